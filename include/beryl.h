@@ -77,6 +77,10 @@ class ExportAPI Beryl
 
 	struct timespec TIME;
 	
+	/* Set when the last loop left work behind, so the next one does not wait for events. */
+	
+	bool Busy;
+
 	/* A buffer used to read/write pending data. */
 	
 	char PendingBuffer[BUFFERSIZE];
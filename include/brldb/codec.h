@@ -0,0 +1,712 @@
+/*
+ * BerylDB - A lightweight database.
+ * http://www.beryldb.com
+ *
+ * Copyright (C) 2021 - Carlos F. Ferry <cferry@beryldb.com>
+ *
+ * This file is part of BerylDB. BerylDB is free software: you can
+ * redistribute it and/or modify it under the terms of the BSD License
+ * version 3.
+ *
+ * More information about our licensing can be found at https://docs.beryl.dev
+ */
+
+#pragma once
+
+#include <cstdint>
+#include <cstring>
+#include <string>
+
+#include "converter.h"
+#include "constants.h"
+
+/*
+ * On-disk format written by this version.
+ *
+ *         · 1: ASCII bit-strings (to_bin) for keys and values.
+ *         · 2: Length-prefixed raw bytes, tagged values.
+ *         · 3: Type and select lead every key.
+ *         · 4: Registry entry (INT_REG) for every key.
+ *         · 5: List elements stored as separate entries (INT_MEMBER).
+ *         · 6: Map fields stored as separate entries (INT_MEMBER).
+ *         · 7: Entry counters for every select and type (KEYSPACE_COUNTER).
+ *         · 8: Values carry a deadline header (VALUE_EXPIRING).
+ */
+
+const unsigned int STORAGE_FORMAT 	= 	8;
+
+/* Reserved entry holding the format of a database. Too short to be decoded as a key. */
+
+const std::string STORAGE_FORMAT_KEY	=	std::string(1, '\0') + "fmt";
+
+/* Leads the reserved entries counting entries of a type within a select. */
+
+const std::string KEYSPACE_COUNTER	=	std::string(1, '\0') + "cnt";
+
+/* Type (1 byte) and select (4 bytes, big-endian) at the start of every key. */
+
+const size_t KEY_PREFIX_LENGTH 		= 	5;
+
+/* First byte of every stored value. */
+
+enum VALUE_TAG
+{
+       VALUE_RAW 	= 	1,
+       VALUE_INT 	= 	2,
+       VALUE_DOUBLE 	= 	3,
+       VALUE_FIELDS 	= 	4,
+       VALUE_LIST 	= 	5,
+       VALUE_MAP 	= 	6,
+       VALUE_EXPIRING 	= 	7
+};
+
+/* Sequence of the first element pushed to a new list. */
+
+const uint64_t LIST_ORIGIN 		= 	1ULL << 63;
+
+/* A storage key, split into its components. */
+
+struct KeyData
+{
+        std::string key;
+
+        unsigned int select;
+
+        std::string type;
+
+        KeyData() : select(0)
+        {
+
+        }
+};
+
+/* 
+ * Header of a list. Elements are stored under INT_MEMBER, keyed by
+ * sequence, within [head, tail).
+ */
+
+struct ListHeader
+{
+        uint64_t head;
+
+        uint64_t tail;
+
+        /* Lower than tail - head once elements are removed from the middle. */
+
+        uint64_t count;
+
+        ListHeader() : head(LIST_ORIGIN), tail(LIST_ORIGIN), count(0)
+        {
+
+        }
+};
+
+/*
+ * Appends a length as a base-128 varint.
+ *
+ * @parameters:
+ *
+ *         · string: Output buffer.
+ *         · size_t: Length to append.
+ */
+
+inline void codec_put_length(std::string& out, size_t length)
+{
+        while (length >= 0x80)
+        {
+              out.push_back(static_cast<char>((length & 0x7F) | 0x80));
+              length >>= 7;
+        }
+
+        out.push_back(static_cast<char>(length));
+}
+
+/*
+ * Reads a varint length.
+ *
+ * @parameters:
+ *
+ *         · string: Input buffer.
+ *         · size_t: Position to read from, advanced past the varint.
+ *         · size_t: Decoded length.
+ *
+ * @return:
+ *
+ *         · bool: False if input is truncated.
+ */
+
+inline bool codec_get_length(const std::string& in, size_t& pos, size_t& length)
+{
+        length = 0;
+
+        for (unsigned int shift = 0; shift < 64 && pos < in.size(); shift += 7)
+        {
+              const unsigned char byte = static_cast<unsigned char>(in[pos++]);
+              length |= static_cast<size_t>(byte & 0x7F) << shift;
+
+              if (!(byte & 0x80))
+              {
+                    return true;
+              }
+        }
+
+        return false;
+}
+
+/* Appends a length-prefixed field. */
+
+inline void codec_put_field(std::string& out, const std::string& field)
+{
+        codec_put_length(out, field.size());
+        out.append(field);
+}
+
+/*
+ * Reads a length-prefixed field.
+ *
+ * @parameters:
+ *
+ *         · string: Input buffer.
+ *         · size_t: Position to read from, advanced past the field.
+ *         · string: Field read.
+ *
+ * @return:
+ *
+ *         · bool: False if input is truncated.
+ */
+
+inline bool codec_get_field(const std::string& in, size_t& pos, std::string& field)
+{
+        size_t length = 0;
+
+        if (!codec_get_length(in, pos, length) || length > in.size() - pos)
+        {
+              return false;
+        }
+
+        field.assign(in, pos, length);
+        pos += length;
+        return true;
+}
+
+/* Stores a 64 bit integer in little-endian order. */
+
+inline void codec_put_fixed64(std::string& out, uint64_t number)
+{
+        for (unsigned int i = 0; i < 8; i++)
+        {
+              out.push_back(static_cast<char>((number >> (i * 8)) & 0xFF));
+        }
+}
+
+/* Reads a little-endian 64 bit integer. Input must have 8 bytes left. */
+
+inline uint64_t codec_get_fixed64(const std::string& in, size_t pos)
+{
+        uint64_t number = 0;
+
+        for (unsigned int i = 0; i < 8; i++)
+        {
+              number |= static_cast<uint64_t>(static_cast<unsigned char>(in[pos + i])) << (i * 8);
+        }
+
+        return number;
+}
+
+/*
+ * Builds the prefix shared by all entries of a type.
+ *
+ * @parameters:
+ *
+ *         · string: Type (INT_KEY, INT_LIST, ...).
+ *
+ * @return:
+ *
+ *         · string: Type prefix.
+ */
+
+inline std::string to_prefix(const std::string& type)
+{
+        return type.substr(0, 1);
+}
+
+/* Builds the prefix shared by all entries of a type within a select. */
+
+inline std::string to_prefix(unsigned int select, const std::string& type)
+{
+        std::string prefix = to_prefix(type);
+
+        for (int shift = 24; shift >= 0; shift -= 8)
+        {
+              prefix.push_back(static_cast<char>((select >> shift) & 0xFF));
+        }
+
+        return prefix;
+}
+
+/* 
+ * Builds the reserved entry counting entries of a type within a select.
+ * Counters of a type share their first KEY_PREFIX_LENGTH bytes, so all
+ * selects are summed with a single prefix scan.
+ */
+
+inline std::string to_counter(unsigned int select, const std::string& type)
+{
+        return KEYSPACE_COUNTER + to_prefix(select, type);
+}
+
+/* Checks whether a type holds user data (and thus has a registry entry). */
+
+inline bool is_data_type(const std::string& type)
+{
+        return (type == INT_KEY || type == INT_MAP || type == INT_LIST || type == INT_GEO || type == INT_MMAP || type == INT_VECTOR);
+}
+
+/* Checks whether a type keeps its elements as INT_MEMBER entries. */
+
+inline bool has_members(const std::string& type)
+{
+        return (type == INT_LIST || type == INT_MAP);
+}
+
+/*
+ * Builds the storage key of an entry.
+ *
+ * @parameters:
+ *
+ *         · string: Key, as provided by user.
+ *         · uint  : Select.
+ *         · string: Type (INT_KEY, INT_LIST, ...).
+ *
+ * @return:
+ *
+ *         · string: Storage key.
+ */
+
+inline std::string to_dest(const std::string& key, unsigned int select, const std::string& type)
+{
+        return to_prefix(select, type) + key;
+}
+
+/*
+ * Splits a storage key into its components.
+ *
+ * @parameters:
+ *
+ *         · string : Storage key.
+ *         · KeyData: Components found.
+ *
+ * @return:
+ *
+ *         · bool   : False if this is not a valid storage key.
+ */
+
+inline bool from_dest(const std::string& raw, KeyData& out)
+{
+        if (raw.size() < KEY_PREFIX_LENGTH || raw[0] == '\0')
+        {
+              return false;
+        }
+
+        out.type.assign(raw, 0, 1);
+        out.select = 0;
+
+        for (size_t i = 1; i < KEY_PREFIX_LENGTH; i++)
+        {
+              out.select = (out.select << 8) | static_cast<unsigned char>(raw[i]);
+        }
+
+        out.key.assign(raw, KEY_PREFIX_LENGTH, std::string::npos);
+        return true;
+}
+
+/*
+ * Builds the prefix shared by all elements of an entry (list sequences,
+ * map fields). The key is
+ * length-prefixed, so 'a' does not cover the elements of 'ab'.
+ *
+ * @parameters:
+ *
+ *         · string: Key, as provided by user.
+ *         · uint  : Select.
+ *
+ * @return:
+ *
+ *         · string: Element prefix.
+ */
+
+inline std::string to_member_prefix(const std::string& key, unsigned int select)
+{
+        std::string prefix = to_prefix(select, INT_MEMBER);
+        codec_put_field(prefix, key);
+        return prefix;
+}
+
+/* Encodes a list sequence. Big-endian, so elements iterate in order. */
+
+inline std::string to_seq(uint64_t seq)
+{
+        std::string out;
+
+        for (int shift = 56; shift >= 0; shift -= 8)
+        {
+              out.push_back(static_cast<char>((seq >> shift) & 0xFF));
+        }
+
+        return out;
+}
+
+/* Reads the sequence at the end of an element key. */
+
+inline uint64_t from_seq(const std::string& member)
+{
+        uint64_t seq = 0;
+
+        for (size_t i = member.size() - 8; i < member.size(); i++)
+        {
+              seq = (seq << 8) | static_cast<unsigned char>(member[i]);
+        }
+
+        return seq;
+}
+
+/* Smallest key sorting after every key that starts with prefix. */
+
+inline std::string prefix_end(const std::string& prefix)
+{
+        std::string end = prefix;
+
+        while (!end.empty() && static_cast<unsigned char>(end.back()) == 0xFF)
+        {
+              end.pop_back();
+        }
+
+        if (!end.empty())
+        {
+              end.back() = static_cast<char>(static_cast<unsigned char>(end.back()) + 1);
+        }
+
+        return end;
+}
+
+/* Encodes a string value. */
+
+inline std::string to_value(const std::string& raw)
+{
+        std::string value(1, static_cast<char>(VALUE_RAW));
+        value.append(raw);
+        return value;
+}
+
+/* Deadline of a stored value, 0 if it does not expire. */
+
+inline time_t value_deadline(const std::string& stored)
+{
+        if (stored.size() < 9 || stored[0] != VALUE_EXPIRING)
+        {
+              return 0;
+        }
+
+        return static_cast<time_t>(codec_get_fixed64(stored, 1));
+}
+
+/* Removes the deadline of a stored value, if any. */
+
+inline std::string strip_deadline(const std::string& stored)
+{
+        if (!value_deadline(stored))
+        {
+              return stored;
+        }
+
+        return stored.substr(9);
+}
+
+/*
+ * Adds an expiring deadline in front of a stored value, replacing any
+ * previous one. Expiring keys carry their deadline, so reads and
+ * compactions drop them without looking at their INT_EXPIRE record.
+ *
+ * @parameters:
+ *
+ *         · time_t: Deadline, as an epoch.
+ *         · string: Stored value.
+ *
+ * @return:
+ *
+ *         · string: Stored value, with header.
+ */
+
+inline std::string to_expiring(time_t deadline, const std::string& stored)
+{
+        std::string value(1, static_cast<char>(VALUE_EXPIRING));
+        codec_put_fixed64(value, static_cast<uint64_t>(deadline));
+        value.append(strip_deadline(stored));
+        return value;
+}
+
+/* Checks whether a stored value has passed its deadline. */
+
+inline bool is_expired(const std::string& stored, time_t now)
+{
+        const time_t deadline = value_deadline(stored);
+        return (deadline && deadline < now);
+}
+
+/*
+ * Encodes a number natively. Integral values are stored as int64,
+ * everything else as a double.
+ */
+
+inline std::string to_number_value(double number)
+{
+        std::string value;
+
+        if (number >= -9.2e18 && number <= 9.2e18 && number == static_cast<double>(static_cast<int64_t>(number)))
+        {
+              value.push_back(static_cast<char>(VALUE_INT));
+              codec_put_fixed64(value, static_cast<uint64_t>(static_cast<int64_t>(number)));
+              return value;
+        }
+
+        uint64_t bits = 0;
+        std::memcpy(&bits, &number, sizeof(bits));
+
+        value.push_back(static_cast<char>(VALUE_DOUBLE));
+        codec_put_fixed64(value, bits);
+        return value;
+}
+
+/*
+ * Reads a stored value as a number.
+ *
+ * @parameters:
+ *
+ *         · string: Stored value.
+ *         · double: Number read.
+ *
+ * @return:
+ *
+ *         · bool: False if value is not numeric.
+ */
+
+inline bool from_number_value(const std::string& stored, double& number)
+{
+        if (value_deadline(stored))
+        {
+              return from_number_value(strip_deadline(stored), number);
+        }
+
+        if (stored.size() == 9 && stored[0] == VALUE_INT)
+        {
+              number = static_cast<double>(static_cast<int64_t>(codec_get_fixed64(stored, 1)));
+              return true;
+        }
+
+        if (stored.size() == 9 && stored[0] == VALUE_DOUBLE)
+        {
+              const uint64_t bits = codec_get_fixed64(stored, 1);
+              std::memcpy(&number, &bits, sizeof(number));
+              return true;
+        }
+
+        if (stored.empty() || stored[0] != VALUE_RAW)
+        {
+              return false;
+        }
+
+        const std::string& raw = stored.substr(1);
+
+        if (raw.empty() || !is_number(raw, true))
+        {
+              return false;
+        }
+
+        number = convto_num<double>(raw);
+        return true;
+}
+
+/*
+ * Decodes a stored value.
+ *
+ * @parameters:
+ *
+ *         · string: Stored value.
+ *
+ * @return:
+ *
+ *         · string: Value as seen by users.
+ */
+
+inline std::string from_value(const std::string& stored)
+{
+        if (stored.empty())
+        {
+              return stored;
+        }
+
+        switch (stored[0])
+        {
+              case VALUE_RAW:
+
+                     return stored.substr(1);
+
+              case VALUE_EXPIRING:
+
+                     if (value_deadline(stored))
+                     {
+                           return from_value(strip_deadline(stored));
+                     }
+
+              break;
+
+              case VALUE_INT:
+
+                     if (stored.size() == 9)
+                     {
+                           return convto_string(static_cast<int64_t>(codec_get_fixed64(stored, 1)));
+                     }
+
+              break;
+
+              case VALUE_DOUBLE:
+              {
+                     double number = 0;
+
+                     if (from_number_value(stored, number))
+                     {
+                           return convto_string(number);
+                     }
+              }
+
+              break;
+        }
+
+        return "";
+}
+
+/* Begins a field-list value (lists, vectors, maps and geos). */
+
+inline std::string to_fields()
+{
+        return std::string(1, static_cast<char>(VALUE_FIELDS));
+}
+
+/*
+ * Checks whether a stored value is a field list.
+ *
+ * @parameters:
+ *
+ *         · string: Stored value.
+ *         · size_t: Position of first field.
+ *
+ * @return:
+ *
+ *         · bool: True if fields can be read from pos.
+ */
+
+inline bool from_fields(const std::string& stored, size_t& pos)
+{
+        pos = 1;
+        return (!stored.empty() && stored[0] == VALUE_FIELDS);
+}
+
+/* Encodes a two-field value (geo coordinates, futures). */
+
+inline std::string to_pair(const std::string& first, const std::string& second)
+{
+        std::string value = to_fields();
+        codec_put_field(value, first);
+        codec_put_field(value, second);
+        return value;
+}
+
+/*
+ * Decodes a two-field value.
+ *
+ * @parameters:
+ *
+ *         · string: Stored value.
+ *         · string: First field.
+ *         · string: Second field.
+ *
+ * @return:
+ *
+ *         · bool: False if value is not a pair.
+ */
+
+inline bool from_pair(const std::string& stored, std::string& first, std::string& second)
+{
+        size_t pos = 0;
+        return (from_fields(stored, pos) && codec_get_field(stored, pos, first) && codec_get_field(stored, pos, second));
+}
+
+/* Encodes a list header. */
+
+inline std::string to_list_header(const ListHeader& header)
+{
+        std::string value(1, static_cast<char>(VALUE_LIST));
+        codec_put_fixed64(value, header.head);
+        codec_put_fixed64(value, header.tail);
+        codec_put_fixed64(value, header.count);
+        return value;
+}
+
+/*
+ * Decodes a list header.
+ *
+ * @parameters:
+ *
+ *         · string    : Stored value.
+ *         · ListHeader: Header read.
+ *
+ * @return:
+ *
+ *         · bool: False if value is not a list header.
+ */
+
+inline bool from_list_header(const std::string& stored, ListHeader& header)
+{
+        if (stored.size() != 25 || stored[0] != VALUE_LIST)
+        {
+              return false;
+        }
+
+        header.head  = codec_get_fixed64(stored, 1);
+        header.tail  = codec_get_fixed64(stored, 9);
+        header.count = codec_get_fixed64(stored, 17);
+        return true;
+}
+
+/* Encodes a map header, holding the number of fields. */
+
+inline std::string to_map_header(uint64_t count)
+{
+        std::string value(1, static_cast<char>(VALUE_MAP));
+        codec_put_fixed64(value, count);
+        return value;
+}
+
+/*
+ * Decodes a map header.
+ *
+ * @parameters:
+ *
+ *         · string: Stored value.
+ *         · uint64: Fields in map.
+ *
+ * @return:
+ *
+ *         · bool: False if value is not a map header.
+ */
+
+inline bool from_map_header(const std::string& stored, uint64_t& count)
+{
+        if (stored.size() != 9 || stored[0] != VALUE_MAP)
+        {
+              return false;
+        }
+
+        count = codec_get_fixed64(stored, 1);
+        return true;
+}
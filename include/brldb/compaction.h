@@ -0,0 +1,53 @@
+/*
+ * BerylDB - A lightweight database.
+ * http://www.beryldb.com
+ *
+ * Copyright (C) 2021 - Carlos F. Ferry <cferry@beryldb.com>
+ *
+ * This file is part of BerylDB. BerylDB is free software: you can
+ * redistribute it and/or modify it under the terms of the BSD License
+ * version 3.
+ *
+ * More information about our licensing can be found at https://docs.beryl.dev
+ */
+
+#pragma once
+
+#include <atomic>
+#include <rocksdb/compaction_filter.h>
+
+#include "brldb/codec.h"
+
+/*
+ * Drops expired keys (values past their VALUE_EXPIRING deadline) while
+ * compacting, so expired data not yet deleted is not carried to lower levels.
+ *
+ * Registry entries and expire records (INT_EXPIRE) are kept: these are
+ * counted by Database::Count(), and ExpireManager removes them along with
+ * the key, reloading the record after a restart.
+ */
+
+class ExportAPI ExpireFilter : public rocksdb::CompactionFilter
+{
+    private:
+
+        /* Time seen by compaction threads, which may not read Kernel->TIME. */
+
+        static std::atomic<time_t> clock;
+
+    public:
+
+        /* Refreshes the time used by compactions. Called from the mainloop. */
+
+        static void SetTime(time_t now)
+        {
+                clock.store(now, std::memory_order_relaxed);
+        }
+
+        bool Filter(int level, const rocksdb::Slice& key, const rocksdb::Slice& existing_value, std::string* new_value, bool* value_changed) const override;
+
+        const char* Name() const override
+        {
+                return "BerylExpireFilter";
+        }
+};
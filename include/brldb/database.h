@@ -13,11 +13,34 @@
 
 #pragma once
 
+#include <condition_variable>
+#include <mutex>
+#include <vector>
+
 #include <rocksdb/write_batch.h>
 #include <rocksdb/db.h>
 #include <rocksdb/c.h>
 #include <rocksdb/options.h>
 #include <rocksdb/env.h>
+#include <rocksdb/slice_transform.h>
+
+#include "brldb/compaction.h"
+
+/* A batch waiting to be committed by Database::Commit(). */
+
+struct CommitRequest
+{
+        rocksdb::WriteBatch* batch;
+        
+        rocksdb::Status status;
+        
+        bool done;
+        
+        CommitRequest(rocksdb::WriteBatch* wbatch) : batch(wbatch), done(false)
+        {
+        
+        }
+};
 
 class ExportAPI Database
 {
@@ -41,6 +64,10 @@ class ExportAPI Database
         
         rocksdb::Options options;
         
+        /* Drops expired entries while compacting, must outlive db. */
+        
+        ExpireFilter filter;
+        
         /* Opening/Closure status. */
         
         rocksdb::Status status;
@@ -56,6 +83,53 @@ class ExportAPI Database
         /* Path to a database. */
        
         std::string path;
+
+        /* Guards the commit queue. */
+        
+        std::mutex commit_mute;
+        
+        /* Signaled when a group has been written. */
+        
+        std::condition_variable committed;
+
+        /* Signaled when a batch joins the queue, while a leader gathers. */
+        
+        std::condition_variable gathering;
+        
+        /* Batches waiting for the next group. */
+        
+        std::vector<CommitRequest*> commit_queue;
+        
+        /* Whether a thread is writing a group. */
+        
+        bool committing;
+        
+        /* 
+         * Checks the storage format of this database, converting
+         * entries written by older versions.
+         * 
+         * @return:
+ 	 *
+         *         · True: Database uses current format.
+         */    
+         
+        bool Upgrade();
+        
+        /* 
+         * Appends to a batch the keyspace counter updates (KEYSPACE_COUNTER)
+         * for the entries it creates or removes. Only called by the thread
+         * writing a group, so counters never race.
+         * 
+         * @parameters:
+	 *
+	 *         · WriteBatch : Batch about to be written.
+	 *
+         * @return:
+ 	 *
+         *         · Status     : Counters could not be appended.
+         */    
+         
+        rocksdb::Status Count(rocksdb::WriteBatch& batch);
      
     public:
 
@@ -112,6 +186,42 @@ class ExportAPI Database
          
         bool Open();
 
+        /* 
+         * Writes a batch. Batches committed by different data threads at
+         * the same time are merged and written together, so concurrent
+         * writers share a single trip through the write path (and a
+         * single sync, if enabled). Returns once the batch is written.
+         * 
+         * @parameters:
+	 *
+	 *         · WriteBatch : Batch to write.
+	 *
+         * @return:
+ 	 *
+         *         · bool	: Batch was written.
+         */    
+         
+        bool Commit(rocksdb::WriteBatch& batch);
+
+        /* 
+         * Number of entries of a type within a select, as kept by Count().
+         * 
+         * @parameters:
+	 *
+	 *         · uint       : Select.
+	 *         · string     : Type (INT_KEY, INT_LIST, ...).
+	 *
+         * @return:
+ 	 *
+         *         · uint       : Entries found.
+         */    
+         
+        unsigned int Counter(unsigned int select, const std::string& type);
+
+        /* Number of entries of a type, all selects summed. */
+        
+        unsigned int Counter(const std::string& type);
+
         /* Remove all content */
         
         bool FlushDB();
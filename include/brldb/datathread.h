@@ -14,7 +14,6 @@
 #pragma once
 
 #include <thread>
-#include <queue>
 #include <mutex>
 #include <atomic>
 #include <condition_variable>
@@ -23,7 +22,6 @@
 
 enum THR_CMD
 {
-        PROC_EXIT_THREAD = 1,	/* Request to exit thread */
         PROC_SIGNAL 	 = 2,   /* Request to process a QueryBase signal */
 };
 
@@ -38,28 +36,138 @@ struct ThreadMsg
         }
 };
 
+/* Messages a single WorkDeque can hold. Must be a power of two. */
+
+const size_t WORK_DEQUE_SIZE = 1024;
+
+/*
+ * Bounded lock-free deque (Chase-Lev). Only the main thread pushes to the
+ * bottom. Data threads take from the top, whether the deque is their own
+ * or they are stealing it from another thread.
+ */
+
+class WorkDeque
+{
+    private:
+
+        std::atomic<size_t> top;
+        
+        std::atomic<size_t> bottom;
+        
+        std::atomic<ThreadMsg*> items[WORK_DEQUE_SIZE];
+
+    public:
+
+        WorkDeque() : top(0), bottom(0)
+        {
+                for (size_t i = 0; i < WORK_DEQUE_SIZE; i++)
+                {
+                        items[i].store(NULL, std::memory_order_relaxed);
+                }
+        }
+
+        /* 
+         * Adds a message at the bottom. Main thread only.
+         * 
+         * @return:
+ 	 *
+         *         · bool: False if deque is full.
+         */    
+
+        bool Push(ThreadMsg* item)
+        {
+                const size_t b = bottom.load(std::memory_order_relaxed);
+                const size_t t = top.load(std::memory_order_acquire);
+
+                if (b - t >= WORK_DEQUE_SIZE)
+                {
+                        return false;
+                }
+
+                items[b & (WORK_DEQUE_SIZE - 1)].store(item, std::memory_order_relaxed);
+                bottom.store(b + 1, std::memory_order_release);
+                return true;
+        }
+
+        /* 
+         * Takes the oldest message. Safe from any number of threads.
+         * 
+         * @return:
+ 	 *
+         *         · ThreadMsg: Message taken, NULL if deque is empty.
+         */    
+
+        ThreadMsg* Steal()
+        {
+                while (true)
+                {
+                        size_t t = top.load(std::memory_order_acquire);
+                        std::atomic_thread_fence(std::memory_order_seq_cst);
+                        const size_t b = bottom.load(std::memory_order_acquire);
+
+                        if (t >= b)
+                        {
+                                return NULL;
+                        }
+
+                        ThreadMsg* item = items[t & (WORK_DEQUE_SIZE - 1)].load(std::memory_order_relaxed);
+
+                        if (top.compare_exchange_strong(t, t + 1, std::memory_order_seq_cst, std::memory_order_relaxed))
+                        {
+                                return item;
+                        }
+                }
+        }
+
+        /* Approximate number of queued messages. */
+
+        size_t Size()
+        {
+                const size_t b = bottom.load(std::memory_order_relaxed);
+                const size_t t = top.load(std::memory_order_relaxed);
+                return (b > t ? b - t : 0);
+        }
+};
+
 class DataThread
 {   
     private:
 
-        /* Keeps this thread safe. */
+        /* Idle threads sleep on this mutex and condition variable. */
         
-        std::mutex m_mutex;
+        static std::mutex idle;
         
-        std::unique_ptr<std::thread> handler;
+        static std::condition_variable wakeup;
         
-        /* Queue item to attach. */
+        /* Messages posted and not yet taken by any thread. */
         
-        std::queue<std::shared_ptr<ThreadMsg>> queue;
+        static std::atomic<size_t> queued;
         
-        /* Conditional variable for thread. */
+        std::unique_ptr<std::thread> handler;
         
-        std::condition_variable m_cv;
+        /* Messages posted to this thread. */
+        
+        WorkDeque deque;
         
         /* Keeps track of busy status */
       
         std::atomic<bool> busy;
         
+        /* Set by Exit(). */
+        
+        std::atomic<bool> exiting;
+        
+        /* 
+         * Takes a message from this thread, or steals one from another
+         * thread if this one has nothing queued.
+         * 
+         * @return:
+ 	 *
+         *         · ThreadMsg: Message to process, NULL if all threads are empty.
+         */    
+         
+        ThreadMsg* Next();
+        
     public:
     
         /* Thread constructor. */
@@ -80,6 +188,13 @@ class DataThread
          */    
          
         bool IsBusy();
+        
+        /* Number of messages waiting in this thread. */
+        
+        size_t Pending()
+        {
+                return this->deque.Size();
+        }
     
         /* A mainloop for a datathread. */
         
@@ -109,11 +224,15 @@ class DataThread
          * @parameters:
 	 *
 	 *         · QueryBase   : Thread to process.
+	 *
+         * @return:
+ 	 *
+         *         · bool        : False if this thread can not queue more queries.
          */            
         
-        void Post(const std::shared_ptr<QueryBase> query);
+        bool Post(const std::shared_ptr<QueryBase> query);
 
-        /* Removes all items in this->queue */
+        /* Removes all queued messages. */
         
         void Clear();
-};
\ No newline at end of file
+};
@@ -14,6 +14,7 @@
 #pragma once
 
 #include <mutex>
+#include <set>
 
 #include "query.h"
 #include "brldb/datathread.h"
@@ -22,13 +23,63 @@
        
 typedef std::vector<DataThread*> DataThreadVector;
 
+/* 
+ * Lock-free queue of finished queries. Data threads push results, the
+ * mainloop takes all of them at once.
+ */
+
+class ExportAPI CompletionQueue
+{
+   private:
+
+        struct Node
+        {
+                std::shared_ptr<QueryBase> query;
+                
+                Node* next;
+        };
+
+        /* Most recent result. */
+        
+        std::atomic<Node*> head;
+
+   public:
+
+        CompletionQueue() : head(NULL)
+        {
+        
+        }
+        
+        ~CompletionQueue();
+
+        /* 
+         * Adds a finished query. Safe from any thread.
+         * 
+         * @parameters:
+	 *
+	 *         · QueryBase	: Finished query.
+         */    
+
+        void Push(const std::shared_ptr<QueryBase>& query);
+
+        /* 
+         * Takes all queued queries. Mainloop only.
+         * 
+         * @parameters:
+	 *
+	 *         · vector	: Queries taken, oldest first.
+         */    
+
+        void Take(std::vector<std::shared_ptr<QueryBase>>& taken);
+};
+
 class ExportAPI DataFlush : public safecast<DataFlush>
 { 
       friend class StoreManager;
 
    private:
 
-        /* Mute used to add notifications. */
+        /* Mute used to process global queries. */
 
         static std::mutex mute;
         
@@ -39,13 +90,43 @@ class ExportAPI DataFlush : public safecast<DataFlush>
         /* Vector containing all threads. */
 
         DataThreadVector threadslist;
+
+        /* Queries finished by data threads. */
+        
+        static CompletionQueue Completed;
+        
+        /* Uuids of users with queries waiting to be dispatched. */
+        
+        static std::set<std::string> Ready;
+
+        /* 
+         * Releases the user of a finished query: unlocks it, or frees a
+         * pipeline entry, and completes its reply slot.
+         * 
+         * @parameters:
+	 *
+	 *         · QueryBase	: Finished query.
+         */    
+         
+        static void Release(const std::shared_ptr<QueryBase>& signal);
+
+        /* 
+         * Completes reply slots held by a query, and by the queries of
+         * a MULTI block.
+         * 
+         * @parameters:
+	 *
+	 *         · QueryBase	: Finished or dropped query.
+         */    
+         
+        static void FinishSlots(const std::shared_ptr<QueryBase>& signal);
+
+        /* Drops pending queries of an user, completing their slots. */
+        
+        static void Discard(User* user);
   
    public:
 
-        /* Mutexes for queries */
-        
-        static std::mutex query_mute;
-   
         /* Flush processor */
         
         static void Flush(User* user, const std::shared_ptr<QueryBase> signal);
@@ -176,13 +257,36 @@ class ExportAPI DataFlush : public safecast<DataFlush>
          
          static void EntryNOExpires(User* user, const std::shared_ptr<QueryBase> signal);
         
-         /* Results from the processing threads. */
+         /* 
+          * Results from the processing threads.
+          *
+          * @return:
+          *
+          *         · bool: True if a result was delivered.
+          */
         
-         static void GetResults();
+         static bool GetResults();
 
-         /* Gets pending queries by iterating all users. */
+        /* 
+         * Replies to the user of a finished query, in the reply slot
+         * of the command that created it.
+         * 
+         * @parameters:
+	 *
+	 *         · QueryBase	: Finished query.
+         */    
+         
+         static void Reply(const std::shared_ptr<QueryBase>& signal);
+
+         /* 
+          * Gets pending queries of users in the ready list.
+          *
+          * @return:
+          *
+          *         · bool: True if a query was dispatched.
+          */
  
-         static void GetPending();
+         static bool GetPending();
 
          /* Flush constructor, should should be set to OK after this. */
         
@@ -195,9 +299,13 @@ class ExportAPI DataFlush : public safecast<DataFlush>
          * @parameters:
 	 *
 	 *         · QueryBase	: Signal to process.
+	 * 
+         * @return:
+ 	 *
+         *         · True: Signal was posted and removed from user->pending.
          */             
          
-         static void Process(User* user, const std::shared_ptr<QueryBase> signal);
+         static bool Process(User* user, const std::shared_ptr<QueryBase> signal);
         
          /* Pauses this->running */
         
@@ -228,7 +336,7 @@ class ExportAPI DataFlush : public safecast<DataFlush>
          static void AttachGlobal(const std::shared_ptr<QueryBase> result);
          
         /* 
-         * Adds a new notification to the notification vector.
+         * Adds a finished query to the completion queue.
          * 
          * @parameters:
 	 *
@@ -237,9 +345,26 @@ class ExportAPI DataFlush : public safecast<DataFlush>
          
          static void AttachResult(const std::shared_ptr<QueryBase> result);
 
-         /* Called in the mainloop, used to dispatch notifications and pending queries. */
+        /* 
+         * Adds an user to the ready list, after a query has been queued
+         * in user->pending.
+         * 
+         * @parameters:
+	 *
+	 *         · User	: User with pending queries.
+         */    
+         
+         static void AttachPending(User* user);
+
+         /* 
+          * Called in the mainloop, used to dispatch notifications and pending queries.
+          *
+          * @return:
+          *
+          *         · bool: True if there was anything to dispatch.
+          */
         
-         static void Process();
+         static bool Process();
 
          /* Close all threads */
         
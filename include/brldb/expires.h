@@ -13,7 +13,9 @@
 
 #pragma once
 
+#include <list>
 #include <mutex>
+#include <unordered_map>
 
 class ExpireEntry
 {
@@ -53,8 +55,110 @@ class ExpireEntry
 
 typedef std::multimap<time_t, ExpireEntry> ExpireMap;
 
+/* Identifies an expiring key: database, select and key. */
+
+struct ExpireKey
+{
+        Database* database;
+        
+        unsigned int select;
+        
+        std::string key;
+        
+        ExpireKey(Database* db, unsigned int use, const std::string& name) : database(db), select(use), key(name)
+        {
+        
+        }
+        
+        bool operator==(const ExpireKey& other) const
+        {
+                return (this->database == other.database && this->select == other.select && this->key == other.key);
+        }
+};
+
+struct ExpireKeyHash
+{
+        size_t operator()(const ExpireKey& entry) const
+        {
+                size_t seed = std::hash<std::string>()(entry.key);
+                seed ^= std::hash<unsigned int>()(entry.select) + 0x9e3779b9 + (seed << 6) + (seed >> 2);
+                seed ^= std::hash<Database*>()(entry.database) + 0x9e3779b9 + (seed << 6) + (seed >> 2);
+                return seed;
+        }
+};
+
+/* 
+ * Levels of the timing wheel. Slots of level N span 256^N seconds, 
+ * so four levels cover 2^32 seconds ahead.
+ */
+
+const unsigned int WHEEL_LEVELS 	= 	4;
+
+const unsigned int WHEEL_BITS 		= 	8;
+
+const unsigned int WHEEL_SLOTS 		= 	1 << WHEEL_BITS;
+
+/* Keys removed by a single data thread batch. */
+
+const unsigned int EXPIRE_BATCH 	= 	512;
+
+typedef std::list<ExpireEntry> ExpireSlot;
+
+/* Where an expire is kept in the wheel. */
+
+struct ExpirePosition
+{
+        unsigned int level;
+        
+        unsigned int slot;
+        
+        ExpireSlot::iterator entry;
+};
+
+typedef std::unordered_map<ExpireKey, ExpirePosition, ExpireKeyHash> ExpireIndex;
+
+/*
+ * Keeps expiring keys in a hierarchical timing wheel, indexed by
+ * (database, select, key). Adding, finding and removing an expire
+ * are O(1), and every second only the slot due is visited. Entries
+ * of upper levels move down a level as their slot comes up.
+ */
+
 class ExportAPI ExpireManager : public safecast<ExpireManager>
 {
+    private:
+    
+        ExpireSlot wheel[WHEEL_LEVELS][WHEEL_SLOTS];
+        
+        ExpireIndex index;
+        
+        /* Last second processed by the wheel, 0 until first used. */
+        
+        time_t clock;
+        
+        /* Sets the wheel clock, if not set already. */
+        
+        void Start(time_t now);
+        
+        /* Inserts an entry in the wheel and the index. */
+        
+        void Place(const ExpireEntry& entry);
+        
+        /* Removes an entry from the wheel and the index. */
+        
+        void Unlink(ExpireIndex::iterator it);
+
+        /* 
+         * Moves the entries of a slot down the wheel.
+         *
+         * @parameters:
+         *
+         *         · uint: Level to cascade.
+         *         · uint: Slot within level.
+         */
+                 
+        void Cascade(unsigned int level, unsigned int slot);
+        
     public:
         
         /* Expires have mutex, as these are called inside db threads. */
@@ -65,12 +169,9 @@ class ExportAPI ExpireManager : public safecast<ExpireManager>
         
         ExpireManager();
 
-        /* Expires map */
-        
-        ExpireMap ExpireList;
-        
         /* 
-         * Flushes all pending expires.
+         * Flushes all pending expires. Due keys are removed from the
+         * wheel and deleted in batches, by data threads.
          *
          * @parameters:
          *
@@ -126,7 +227,8 @@ class ExportAPI ExpireManager : public safecast<ExpireManager>
         ExpireEntry Find(std::shared_ptr<Database> database, const std::string& key, unsigned int select);
         
         /* 
-         * Gets all expires.
+         * Gets all expires. Built on every call, so it should only be
+         * used by listings.
 	 * 
          * @return:
  	 *
@@ -134,7 +236,7 @@ class ExportAPI ExpireManager : public safecast<ExpireManager>
          *                      static object of a ExpireEntry.
          */          
            
-        ExpireMap& GetExpires();        
+        ExpireMap GetExpires();        
 
         /* 
          * Time to live.
@@ -146,7 +248,7 @@ class ExportAPI ExpireManager : public safecast<ExpireManager>
          
         signed int GetTTL(std::shared_ptr<Database> database, const std::string& key, unsigned int select);
         
-        /* Clears everything inside ExpireList. */
+        /* Clears every expire. */
         
         static void Reset();
         
@@ -179,7 +281,8 @@ class ExportAPI ExpireManager : public safecast<ExpireManager>
                  
         unsigned int CountAll()
         {
-            return this->ExpireList.size();
+            std::lock_guard<std::mutex> lg(ExpireManager::mute);
+            return this->index.size();
         }
         
         /* 
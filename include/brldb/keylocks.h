@@ -0,0 +1,135 @@
+/*
+ * BerylDB - A lightweight database.
+ * http://www.beryldb.com
+ *
+ * Copyright (C) 2021 - Carlos F. Ferry <cferry@beryldb.com>
+ *
+ * This file is part of BerylDB. BerylDB is free software: you can
+ * redistribute it and/or modify it under the terms of the BSD License
+ * version 3.
+ *
+ * More information about our licensing can be found at https://docs.beryl.dev
+ */
+
+#pragma once
+
+#include <atomic>
+#include <mutex>
+#include <vector>
+
+/* Number of mutexes keys are spread over. */
+
+const size_t KEY_STRIPES = 1024;
+
+/*
+ * Striped lock table. Every (database, select, key) maps to one of
+ * KEY_STRIPES mutexes, so queries on unrelated keys run in parallel
+ * while queries on the same key are serialized.
+ */
+
+class ExportAPI KeyLocks
+{
+    private:
+
+        static std::mutex stripes[KEY_STRIPES];
+
+        /* Bumped every time a key of a stripe is written. */
+        
+        static std::atomic<uint64_t> versions[KEY_STRIPES];
+
+    public:
+
+        /*
+         * Finds the stripe of a key.
+         *
+         * @parameters:
+	 *
+	 *         · Database  : Database holding key.
+	 *         · uint      : Select.
+	 *         · string    : Key.
+	 *
+         * @return:
+ 	 *
+         *         · size_t    : Stripe.
+         */
+
+        static size_t Stripe(const std::shared_ptr<Database>& database, unsigned int select, const std::string& key);
+
+        /* 
+         * Adds every stripe. Used by writes not bound to a single key
+         * (ie: SFLUSH, WDEL), which lock and bump all of them.
+         * 
+         * @parameters:
+	 *
+	 *         · vector    : Stripes to lock.
+         */    
+
+        static void All(std::vector<size_t>& locked);
+
+        /*
+         * Locks a set of stripes. Stripes are sorted and locked in
+         * ascending order, so multi-key queries never deadlock.
+         *
+         * @parameters:
+	 *
+	 *         · vector    : Stripes to lock, sorted on return.
+         */
+
+        static void Lock(std::vector<size_t>& locked);
+
+        /* Unlocks stripes taken by Lock(). */
+
+        static void Unlock(const std::vector<size_t>& locked);
+
+        /* 
+         * Current version of a stripe. Keys sharing a stripe share their
+         * version, so a watched key may be seen as changed when a key next
+         * to it is written.
+         * 
+         * @parameters:
+	 *
+	 *         · size_t    : Stripe.
+	 *
+         * @return:
+ 	 *
+         *         · uint64    : Version.
+         */    
+         
+        static uint64_t Version(size_t stripe)
+        {
+                return KeyLocks::versions[stripe].load(std::memory_order_acquire);
+        }
+
+        /* 
+         * Marks stripes as written. Writes not bound to any key (ie: flushes)
+         * pass an empty vector, bumping all stripes.
+         * 
+         * @parameters:
+	 *
+	 *         · vector    : Stripes written.
+         */    
+         
+        static void Bump(const std::vector<size_t>& written);
+};
+
+/* Holds the stripes of a query while it runs. */
+
+class ExportAPI KeyGuard
+{
+    private:
+
+        std::vector<size_t> locked;
+
+    public:
+
+        KeyGuard(QueryBase* query)
+        {
+                query->Stripes(this->locked);
+                KeyLocks::Lock(this->locked);
+        }
+
+        ~KeyGuard()
+        {
+                KeyLocks::Unlock(this->locked);
+        }
+};
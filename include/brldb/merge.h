@@ -0,0 +1,83 @@
+/*
+ * BerylDB - A lightweight database.
+ * http://www.beryldb.com
+ *
+ * Copyright (C) 2021 - Carlos F. Ferry <cferry@beryldb.com>
+ *
+ * This file is part of BerylDB. BerylDB is free software: you can
+ * redistribute it and/or modify it under the terms of the BSD License
+ * version 3.
+ *
+ * More information about our licensing can be found at https://docs.beryl.dev
+ */
+
+#pragma once
+
+#include <rocksdb/merge_operator.h>
+
+#include "brldb/codec.h"
+
+/* First byte of every merge operand. */
+
+enum MERGE_TAG
+{
+       MERGE_NUMERIC 	= 	1,
+       MERGE_PUSH 	= 	2
+};
+
+/*
+ * Applies a numeric operation (OP_INCR, OP_ADD, ...) to a value.
+ * Used both when merging operands and when replying to users.
+ *
+ * @parameters:
+ *
+ *         · OP_TYPE: Operation to apply.
+ *         · double : Current value.
+ *         · double : Operand (OP_ADD, OP_MULT, ...).
+ *
+ * @return:
+ *
+ *         · double: Resulting value.
+ */
+
+double apply_op(OP_TYPE operation, double current, double oper);
+
+/* Numeric operation, applied to stored numbers. Missing entries start at 0. */
+
+inline std::string to_numeric_operand(OP_TYPE operation, double oper)
+{
+        std::string operand(1, static_cast<char>(MERGE_NUMERIC));
+        operand.push_back(static_cast<char>(operation));
+
+        uint64_t bits = 0;
+        std::memcpy(&bits, &oper, sizeof(bits));
+        codec_put_fixed64(operand, bits);
+        return operand;
+}
+
+/* Item pushed at the end of a field list (VALUE_FIELDS). */
+
+inline std::string to_push_operand(const std::string& item)
+{
+        std::string operand(1, static_cast<char>(MERGE_PUSH));
+        operand.append(item);
+        return operand;
+}
+
+/*
+ * Resolves merge operands written by blind writes (VPUSH, keyspace counters).
+ * Operands that do not apply to the stored value are skipped, so a merge
+ * never fails and never corrupts an entry.
+ */
+
+class ExportAPI ValueMerge : public rocksdb::MergeOperator
+{
+    public:
+
+        bool FullMergeV2(const MergeOperationInput& merge_in, MergeOperationOutput* merge_out) const override;
+
+        const char* Name() const override
+        {
+                return "BerylValueMerge";
+        }
+};
@@ -16,6 +16,12 @@
 #include "dbnumeric.h"
 #include "brldb/database.h"
 #include "cstruct.h"
+#include "brldb/codec.h"
+
+namespace rocksdb
+{
+       class WriteBatchWithIndex;
+}
 
 enum STR_FUNCTION
 {
@@ -50,7 +56,8 @@ enum QUERY_TYPE
        QUERY_TYPE_LAT		 =	23,
        QUERY_TYPE_LONG		 = 	24,
        QUERY_TYPE_TRANSFER	 =      25,
-       QUERY_TYPE_SORT		=	26
+       QUERY_TYPE_SORT		=	26,
+       QUERY_TYPE_MULTI		=	27
 };
 
 enum QUERY_FLAGS
@@ -128,6 +135,17 @@ class ExportAPI QueryBase
         
         signed int limit;
         
+        /* Set when listing by cursor instead of offset. */
+        
+        bool paged;
+        
+        /* 
+         * Raw key a paged listing resumes after. Once ran, raw key it stopped 
+         * on, or empty when the listing is complete.
+         */
+        
+        std::string cursor;
+        
         DualMMap mlist;
         
         unsigned int select_query;
@@ -166,6 +184,22 @@ class ExportAPI QueryBase
         
         double size;
 
+        /* Write queries that only merge operands do not load stored values. */
+        
+        bool blind;
+
+        /* Query may run next to other queries of its user. */
+        
+        bool pipelined;
+        
+        /* Reply slot of the command that created this query. */
+        
+        uint64_t slot;
+        
+        /* Transaction receiving writes and serving reads, NULL when using the database directly. */
+        
+        rocksdb::WriteBatchWithIndex* txn;
+
         void access_set(DBL_CODE status)
         {
             this->access = status;
@@ -186,8 +220,8 @@ class ExportAPI QueryBase
         }
         
         QueryBase() :  finished(false), key_required(false), flags(QUERY_FLAGS_NONE), access(DBL_NONE),  
-                        subresult(0), partial(false), offset(0), limit(0), user(NULL), 
-                        operation(OP_NONE), counter(0), data(0), size(0.0)
+                        subresult(0), partial(false), offset(0), limit(0), paged(false), user(NULL), 
+                        operation(OP_NONE), counter(0), data(0), size(0.0), blind(false), pipelined(false), slot(0), txn(NULL)
         {
               
         }
@@ -237,6 +271,36 @@ class ExportAPI QueryBase
         int CheckDest(unsigned int select, const std::string& regkey,  const std::string& ltype, std::shared_ptr<Database> db = NULL);
 
         RocksData Get(const std::string& where);
+
+        /* 
+         * Reads an entry, including writes of a running transaction.
+         * 
+         * @parameters:
+	 *
+	 *         · where: Storage key.
+	 *         · found: Value found.
+	 *         · db: Database to read, this->database by default.
+	 *
+         * @return:
+ 	 *
+         *         · Status: As returned by rocksdb.
+         */          
+         
+        rocksdb::Status Read(const std::string& where, std::string* found, std::shared_ptr<Database> db = NULL);
+
+        /* 
+         * Reads many entries with a single MultiGet. Keys are looked up
+         * in sorted order, results are returned in the order given.
+         * 
+         * @parameters:
+	 *
+	 *         · where: Storage keys.
+	 *         · values: Values found, empty when missing.
+	 *         · statuses: Status of each lookup.
+	 *         · db: Database to read, this->database by default.
+         */          
+         
+        void ReadMany(const StringVector& where, StringVector& values, std::vector<rocksdb::Status>& statuses, std::shared_ptr<Database> db = NULL);
         
         /* 
          * Writes an entry to the database.
@@ -248,9 +312,138 @@ class ExportAPI QueryBase
          */          
            
         bool Write(const std::string& wdest, const std::string& lvalue);        
+
+        /* 
+         * Writes a merge operand (brldb/merge.h) to an entry, without
+         * reading it first.
+         * 
+         * @parameters:
+	 *
+	 *         · dest: identifier.
+	 *         · operand: Operand to merge.
+         */          
+           
+        bool Merge(const std::string& wdest, const std::string& operand);
         
         void Delete(const std::string& wdest);
         
+        /* 
+         * Adds the registry entry of a storage key to a batch. Entries
+         * not holding user data (expires, futures) are ignored.
+         * 
+         * @parameters:
+	 *
+	 *         · batch: Batch to extend.
+	 *         · dest: Storage key being written.
+         */          
+         
+        void RegPut(rocksdb::WriteBatch& batch, const std::string& wdest);
+        
+        /* Removes the registry entry of a storage key being deleted. */
+        
+        void RegDelete(rocksdb::WriteBatch& batch, const std::string& wdest);
+        
+        /* 
+         * Creates an iterator positioned at the first entry of a key range.
+         * Paged queries are positioned right after their cursor instead.
+         * 
+         * @parameters:
+	 *
+	 *         · prefix: Range to scan, built with to_prefix().
+	 *
+         * @return:
+ 	 *
+         *         · Iterator: Caller must stop once key() no longer starts with prefix.
+         */          
+         
+        std::unique_ptr<rocksdb::Iterator> Scan(const std::string& prefix);
+        
+        /* 
+         * Stores where a paged listing stopped, so the next page seeks
+         * to it instead of skipping over previous pages.
+         * 
+         * @parameters:
+	 *
+	 *         · Iterator: Iterator used by Scan(), positioned on the last
+	 *                     entry delivered.
+	 *         · prefix  : Range being scanned.
+         */     
+         
+        void EndPage(rocksdb::Iterator* it, const std::string& prefix);
+        
+        /* Cursor as sent to users: "@" followed by the hex of the raw key. */
+        
+        std::string GetCursor();
+        
+        /* 
+         * Removes all elements (INT_MEMBER) of an entry. Types without
+         * elements are ignored.
+         * 
+         * @parameters:
+	 *
+	 *         · batch: Batch to extend.
+	 *         · dest: Storage key being removed.
+         */          
+         
+        void DropMembers(rocksdb::WriteBatch& batch, const std::string& wdest);
+        
+        /* 
+         * Removes an expired key: its entry, registry, elements and expire
+         * record.
+         * 
+         * @parameters:
+	 *
+	 *         · batch: Batch to extend.
+	 *         · select: Select of key.
+	 *         · key: Key, as provided by user.
+	 *         · type: Type of key, as found in registry.
+         */          
+         
+        void Reap(rocksdb::WriteBatch& batch, unsigned int select, const std::string& regkey, const std::string& regtype);
+        
+        /* 
+         * Copies all elements of an entry to another one, replacing 
+         * elements previously found in target.
+         * 
+         * @parameters:
+	 *
+	 *         · batch: Batch to extend.
+	 *         · from: Storage key to read elements from (this->database).
+	 *         · to: Storage key receiving elements.
+         */          
+         
+        void CopyMembers(rocksdb::WriteBatch& batch, const std::string& from, const std::string& to);
+        
+        /* 
+         * Reads all elements of a list, in order.
+         * 
+         * @parameters:
+	 *
+	 *         · dest: Storage key of list.
+	 *         · items: Elements found.
+         */          
+         
+        void LoadList(const std::string& ldest, ListMap& items);
+        
+        /* Reads all fields of a map. */
+        
+        void LoadMap(const std::string& ldest, MapMap& items);
+        
+        /* Writes a batch to this->database, or adds it to this->txn. */
+        
+        bool Commit(rocksdb::WriteBatch& batch);
+        
+        /* 
+         * Adds the lock stripes (brldb/keylocks.h) of keys this query
+         * touches. Queries writing to a second key add it as well.
+         * 
+         * @parameters:
+	 *
+	 *         · vector: Stripes to lock.
+         */
+        
+        virtual void Stripes(std::vector<size_t>& locked);
+        
         virtual void Run() = 0;
         
         virtual void Process() = 0;
@@ -332,6 +525,8 @@ class ExportAPI rename_query : public routed_query
         void Vectors();
         
         void Run();
+
+        void Stripes(std::vector<size_t>& locked);
         
         void Process();
 };
@@ -359,6 +554,8 @@ class ExportAPI renamenx_query : public routed_query
 
         void Run();
 
+        void Stripes(std::vector<size_t>& locked);
+
         void Process();
 };
 
@@ -385,6 +582,8 @@ class ExportAPI diff_query : public routed_query
 
         void Run();
 
+        void Stripes(std::vector<size_t>& locked);
+
         void Process();
 };
 
@@ -438,6 +637,8 @@ class ExportAPI transfer_query : public routed_query
 
         void Run();
 
+        void Stripes(std::vector<size_t>& locked);
+
         void Process();
 };
 
@@ -464,6 +665,8 @@ class ExportAPI move_query : public routed_query
 
         void Run();
 
+        void Stripes(std::vector<size_t>& locked);
+
         void Process();
 };
 
@@ -491,6 +694,8 @@ class ExportAPI clone_query : public routed_query
 
         void Run();
 
+        void Stripes(std::vector<size_t>& locked);
+
         void Process();
 };
 
@@ -518,6 +723,8 @@ class ExportAPI copy_query : public routed_query
 
         void Run();
 
+        void Stripes(std::vector<size_t>& locked);
+
         void Process();
 };
 
@@ -739,6 +946,26 @@ class ExportAPI ntouch_query  : public QueryBase
         void Process();
 };
 
+/* Values of many plain keys, looked up together. Keys are in this->VecData. */
+
+class ExportAPI gets_query  : public QueryBase
+{
+    public:
+
+        /* Keys and their values, in the order requested. */
+
+        DualVector found;
+
+        gets_query() 
+        {
+                this->type = QUERY_TYPE_SKIP;
+        }
+
+        void Run();
+
+        void Process();
+};
+
 class ExportAPI count_query  : public QueryBase
 {
     public:
@@ -765,6 +992,10 @@ class ExportAPI sflush_query  : public QueryBase
 
         void Run();
 
+        /* Keys removed are not known beforehand, so all stripes are held. */
+
+        void Stripes(std::vector<size_t>& locked);
+
         void Process();
 };
 
@@ -988,6 +1219,7 @@ class ExportAPI vpush_query  : public QueryBase
         {
                 this->type = QUERY_TYPE_WRITE;
                 this->base_request = INT_VECTOR;
+                this->blind = true;
         }
 
         void Run();
@@ -1358,6 +1590,23 @@ class ExportAPI setnx_query  : public QueryBase
         void Process();
 };
 
+/* Sets this->value if key holds this->hesh. */
+
+class ExportAPI cas_query  : public QueryBase
+{
+    public:
+
+        cas_query() 
+        {
+                this->type = QUERY_TYPE_WRITE;
+                this->base_request = INT_KEY;
+        }
+
+        void Run();
+
+        void Process();
+};
+
 class ExportAPI settx_query  : public QueryBase
 {
     public:
@@ -2036,6 +2285,28 @@ class ExportAPI expire_del_query  : public QueryBase
         void Process();
 };
 
+/* Deletes expired keys of a database in a single batch, see ExpireManager::Flush(). */
+
+class ExportAPI expire_batch_query  : public QueryBase
+{
+    public:
+
+        /* Select and key of every expired entry. */
+        
+        std::vector<std::pair<unsigned int, std::string>> due;
+        
+        expire_batch_query() 
+        {
+                this->type = QUERY_TYPE_SKIP;
+        }
+
+        void Run();
+
+        void Stripes(std::vector<size_t>& locked);
+        
+        void Process();
+};
+
 class ExportAPI mvals_query  : public QueryBase
 {
     public:
@@ -2184,6 +2455,10 @@ class ExportAPI wdel_query  : public QueryBase
 
         void Run();
 
+        /* Keys removed are not known beforehand, so all stripes are held. */
+
+        void Stripes(std::vector<size_t>& locked);
+
         void Process();
 };
 
@@ -2322,3 +2597,57 @@ class ExportAPI ismatch_query  : public QueryBase
 
         void Process();
 };
+
+/* 
+ * Commands of a MULTI block. Queries are run in order by a single data
+ * thread, holding locks of all keys involved, and their writes are
+ * committed together in one batch.
+ */
+
+class ExportAPI transaction_query : public QueryBase
+{
+    public:
+    
+        /* Queries in the order their commands were queued. */
+        
+        std::vector<std::shared_ptr<QueryBase>> queries;
+        
+        /* Stripes watched before MULTI, and their versions at that time. */
+        
+        std::map<size_t, uint64_t> watched;
+        
+        /* A watched key was written, queries did not run. */
+        
+        bool conflict;
+        
+        transaction_query() : conflict(false)
+        {
+                this->type = QUERY_TYPE_MULTI;
+        }
+        
+        /* 
+         * Adds a query to this transaction.
+         * 
+         * @parameters:
+	 *
+	 *         · QueryBase: Query created by a queued command.
+         */    
+         
+        void Add(const std::shared_ptr<QueryBase>& query);
+        
+        /* 
+         * Checks whether watched keys have been written.
+         * 
+         * @return:
+ 	 *
+         *         · bool: True if a watched stripe has a new version.
+         */    
+         
+        bool Changed();
+        
+        void Stripes(std::vector<size_t>& locked);
+        
+        void Run();
+        
+        void Process();
+};
@@ -17,6 +17,8 @@
 
 class IOQueue;
 
+struct ReactorLink;
+
 enum LiveSocketState
 {
 	/* Socket disconnected. */
@@ -83,13 +85,48 @@ class ExportAPI SocketTimer : public Timer
 
 class ExportAPI StreamSocket : public EventHandler
 {
+ friend class Reactors;
+
  public:
 	
 	class send_queue
 	{
   	  public:
 		
-		typedef std::string Element;
+		/* 
+		 * Queued data. Buffers are immutable and refcounted, so a message
+		 * sent to many sockets (ie: PUBLISH) is held once, and every queue
+		 * keeps its own offset of what has been written already.
+		 */
+
+		class Element
+		{
+		    private:
+
+			std::shared_ptr<const std::string> buffer;
+
+			std::string::size_type offset;
+
+		    public:
+
+			Element(const std::string& data) : buffer(std::make_shared<const std::string>(data)), offset(0)
+			{
+
+			}
+
+			Element(const std::shared_ptr<const std::string>& shared) : buffer(shared), offset(0)
+			{
+
+			}
+
+			const char* data() const { return buffer->data() + offset; }
+
+			std::string::size_type length() const { return buffer->length() - offset; }
+
+			std::string::size_type size() const { return length(); }
+
+			void erase_front(std::string::size_type n) { offset += n; }
+		};
 
 		
 		typedef std::deque<Element> Container;
@@ -125,10 +162,10 @@ class ExportAPI StreamSocket : public EventHandler
 		}
 
 		
-		void erase_front(Element::size_type n)
+		void erase_front(std::string::size_type n)
 		{
 			nbytes -= n;
-			data.front().erase(0, n);
+			data.front().erase_front(n);
 		}
 
 		
@@ -145,6 +182,12 @@ class ExportAPI StreamSocket : public EventHandler
 			nbytes += newdata.length();
 		}
 
+		void push_back(const std::shared_ptr<const std::string>& shared)
+		{
+			data.push_back(Element(shared));
+			nbytes += shared->length();
+		}
+
 		
 		void clear()
 		{
@@ -187,6 +230,10 @@ class ExportAPI StreamSocket : public EventHandler
 	
 	send_queue sendq;
 
+	/* Set while the socket is handled by an I/O thread. */
+
+	std::shared_ptr<ReactorLink> link;
+
 	
 	std::string error;
 
@@ -259,6 +306,14 @@ class ExportAPI StreamSocket : public EventHandler
 
 	
 	void AppendBuffer(const std::string& data);
+
+	/* Queues a shared buffer, without copying it. */
+
+	void AppendBuffer(const std::shared_ptr<const std::string>& data);
+
+	/* Moves all elements of a queue to the send queue. */
+
+	void AppendBuffer(send_queue& data);
 	
 	bool find_next_line(std::string& line, char delim = '\n');
 	
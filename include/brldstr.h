@@ -29,6 +29,10 @@
 
 ExportAPI std::string bin_to_hex(const void* raw, size_t rawsize);
 
+/* Decodes a bin_to_hex() string. Returns false on odd length or non-hex digits. */
+
+ExportAPI bool hex_to_bin(const std::string& hex, std::string& raw);
+
 ExportAPI std::string bin_to_base64(const std::string& data, const char* table = NULL, char pad = 0);
 
 ExportAPI std::string base_64_to_bin(const std::string& data, const char* table = NULL);
@@ -210,6 +210,18 @@ class ExportAPI Command : public CommandModel
 	
 	signed int limit;
 	
+	/* Whether offset may be given as a cursor (see GetLimits). */
+	
+	bool run_cursor;
+	
+	/* Set when a cursor was given instead of an offset. */
+	
+	bool paged;
+	
+	/* Raw key the previous page ended on, empty when starting. */
+	
+	std::string cursor;
+	
 	/* Checks for a valid login */
 	
 	signed check_login;
@@ -253,6 +265,13 @@ class ExportAPI Command : public CommandModel
 	
 	bool no_hint_until_reg;
 
+	/* 
+	 * Command only reads keys, so it may run while previous queries
+	 * of the same user are still being processed (pipelining).
+	 */
+	 
+	bool pipeline_ok;
+
 	
 	virtual COMMAND_RESULT Handle(User* user, const Params& parameters) = 0;
 
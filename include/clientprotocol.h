@@ -225,7 +225,7 @@ class ProtocolTrigger::Message : public ProtocolTrigger::MessageSource
 	typedef std::vector<Param> ParamList;
 
  private:
-	typedef std::vector<std::pair<SerializedData, SerializedMessage> > SerializedList;
+	typedef std::vector<std::pair<SerializedData, SharedMessage> > SerializedList;
 
 	ParamList params;
 	TagMap tags;
@@ -311,7 +311,7 @@ class ProtocolTrigger::Message : public ProtocolTrigger::MessageSource
 	}
 
 	
-	const SerializedMessage& GetSerialized(const SerializedData& serializeinfo) const;
+	const SharedMessage& GetSerialized(const SerializedData& serializeinfo) const;
 
 	
 	void ClearParams()
@@ -490,6 +490,15 @@ struct ProtocolTrigger::BRLDEvents
 
 class ExportAPI ProtocolTrigger::Serializer : public DataProvider
 {
+ public:
+
+	enum ExtractResult
+	{
+		EXTRACT_MORE,
+		EXTRACT_DONE,
+		EXTRACT_TOO_LONG
+	};
+
  private:
 
 	ProtocolTrigger::MessageTagEvent evprov;
@@ -503,13 +512,34 @@ class ExportAPI ProtocolTrigger::Serializer : public DataProvider
 	bool HandleTag(LocalUser* user, const std::string& tagname, std::string& tagvalue, TagMap& tags) const;
 
 	
-	const SerializedMessage& SerializeForUser(LocalUser* user, Message& msg);
+	const SharedMessage& SerializeForUser(LocalUser* user, Message& msg);
 
 	
 	virtual std::string Serialize(const Message& msg, const TagSelection& tagwl) const = 0;
 
 	
 	virtual bool Parse(LocalUser* user, const std::string& line, ParseOutput& parseoutput) = 0;
+
+	/* 
+	 * Reads the next message of received data. Messages are lines
+	 * by default; serializers with their own framing override this.
+	 * 
+	 * @parameters:
+	 *
+	 *         · LocalUser : User data was received from.
+	 *         · string    : Received data.
+	 *         · size_type : Start of next message, moved past it once read.
+	 *         · size_type : Received data already looked at.
+	 *         · string    : Message extracted.
+	 *
+	 * @return:
+	 *
+	 *         · EXTRACT_DONE     : A full message was extracted.
+	 *         · EXTRACT_MORE     : More data is needed.
+	 *         · EXTRACT_TOO_LONG : Message does not fit in the recvq limit.
+	 */
+
+	virtual ExtractResult Extract(LocalUser* user, const std::string& recvq, std::string::size_type& head, std::string::size_type& checked, std::string& message);
 };
 
 inline ProtocolTrigger::MessageProvider::MessageProvider(MessageDataProvider* prov, const std::string& val, void* data)
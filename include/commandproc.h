@@ -31,6 +31,57 @@ struct PendingCMD
 
 class ExportAPI CommandQueue : public safecast<CommandQueue>
 {
+   private:
+   
+         /* Uuids of users with commands in their PendingList. */
+         
+         std::set<std::string> ready;
+
+         /* Last user served, next pass starts after it. */
+         
+         std::string last;
+
+        /* 
+         * Runs pending commands of an user, up to Config->CommandBurst.
+         * 
+         * @parameters:
+	 *
+	 *         · LocalUser	: User to process.
+	 * 
+         * @return:
+ 	 *
+         *         · True: At least one command was executed.
+         */    
+         
+         bool Drain(LocalUser* user);
+
+        /* 
+         * Runs leading commands of an user that only read keys, while
+         * its pipeline depth allows it.
+         * 
+         * @parameters:
+	 *
+	 *         · LocalUser	: User to process.
+	 *         · uint	: Maximum commands to run.
+	 * 
+         * @return:
+ 	 *
+         *         · uint: Commands executed.
+         */    
+         
+         unsigned int Pipeline(LocalUser* user, unsigned int budget);
+
+        /* 
+         * Runs commands queued after MULTI. Their queries are pushed as a
+         * single transaction_query, replying once all of them have run.
+         * 
+         * @parameters:
+	 *
+	 *         · LocalUser	: User that sent MRUN.
+         */    
+         
+         void Transaction(LocalUser* user);
+         
    public:
 
          /* Constructor */
@@ -52,6 +103,12 @@ class ExportAPI CommandQueue : public safecast<CommandQueue>
         /* 
          * Runs pending commands. 
          * This function is called from mainloop and runs constantly.
+         * Users are served round-robin, each one up to Config->CommandBurst
+         * commands, until Config->FlushUsec is spent.
+         * 
+         * @return:
+ 	 *
+         *         · True: At least one command was executed.
          */    
 	
 	bool Flush();
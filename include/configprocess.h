@@ -81,6 +81,17 @@ struct DBOptions
         
         bool pipeline;
         
+        /* Whether writes are synced to disk before being acknowledged. */
+        
+        bool sync;
+        
+        /* Microseconds a group commit waits for more writes. */
+        
+        unsigned int commitusec;
+        
+        /* Maximum batches written by a single group commit. */
+        
+        unsigned int commitops;
 };
 
 /* Stores user-cmd line arguments. */
@@ -197,6 +208,18 @@ class ExportAPI Configuration
 	
 	unsigned int MaxClients;
 
+	/* Commands a client may run in a single mainloop pass. */
+	
+	unsigned int CommandBurst;
+	
+	/* Microseconds spent running commands in a single mainloop pass. */
+	
+	unsigned int FlushUsec;
+
+	/* Threads handling client sockets, none when zero. Read at startup. */
+
+	unsigned int IOThreads;
+
 	
         bool RawLog;
 
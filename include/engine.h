@@ -495,6 +495,19 @@ class ExportAPI Dispatcher : public safecast<Dispatcher>
          */  
          
         static void MMapFlush(bool comillas, const std::string& title, const std::string& subtitle, QueryBase* query);
+
+        /* 
+         * Flushes pairs in the order given, laid out as MMapFlush.
+         * 
+         * @parameters:
+         *
+         *         · string     : Title that a given returning title has.
+         *         · string     : Subtitle to utilize.
+         *         · DualVector : Pairs to list, values already formatted.
+         *         · QueryBase  : Original query. 
+         */  
+         
+        static void PairFlush(const std::string& title, const std::string& subtitle, const DualVector& pairs, QueryBase* query);
         
         /* 
          * This function is used when creating a string that cotains repeated 
@@ -30,6 +30,7 @@ class Subscription;
 class Module;
 class ProtocolServer;
 class QueryBase;
+class transaction_query;
 class RemoteUser;
 class Server;
 class Configuration;
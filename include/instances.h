@@ -65,6 +65,14 @@ struct ExportAPI ConfigConnect : public refcountbase
 	/* Connecting port */
 	
 	brld::flat_set<int> ports;
+
+	/* Queries a connection may have running at once (pipelining). */
+	
+	unsigned int pipeline;
+
+	/* Bytes a connection may have received and not processed yet. */
+
+	unsigned long recvq;
 	
 	ConfigConnect(config_rule* tag, char type, const std::string& mask);
 	
@@ -122,6 +130,10 @@ class ExportAPI User : public Expandable
         
         bool Locked;
 
+        /* Pipelined queries posted to data threads and not finished yet. */
+        
+        unsigned int InFlight;
+
 	std::string cached_user_real_host;
 	
 	std::string user_ip;
@@ -222,6 +234,18 @@ class ExportAPI User : public Expandable
          */    	
          
 	bool IsLocked();
+
+        /* 
+         * Checks whether queries of this user are still running, either
+         * a locking one or pipelined ones. Users can not be removed
+         * until they finish.
+	 * 
+         * @return:
+ 	 *
+         *         · True: Queries running.
+         */    	
+
+	bool IsBusy();
 	
 	/* Unique id */
 	
@@ -243,10 +267,6 @@ class ExportAPI User : public Expandable
         
         std::deque<std::shared_ptr<QueryBase>> pending;
 
-        /* Pending results */
-        
-        std::deque<std::shared_ptr<QueryBase>> notifications;
-
         /* Current select: 1 by default */
         
         unsigned int select;
@@ -621,13 +641,17 @@ class ExportAPI InstanceStream : public StreamSocket
 {
  private:
 
+	 /* Start of the first message not yet handed out. */
+
+	 size_t head;
+
 	 size_t checked_until;
 
  public:
 
 	LocalUser* const user;
 
-	InstanceStream(LocalUser* me) : StreamSocket(StreamSocket::SS_USER), checked_until(0), user(me)
+	InstanceStream(LocalUser* me) : StreamSocket(StreamSocket::SS_USER), head(0), checked_until(0), user(me)
 	{
 
 	}
@@ -641,6 +665,36 @@ class ExportAPI InstanceStream : public StreamSocket
 
 typedef unsigned int sent_id;
 
+/* Slot id used when output is not bound to any command. */
+
+const uint64_t NO_SLOT = 0;
+
+/* 
+ * Replies of a single command. Commands of a connection may finish out
+ * of order when pipelined, so output of a command is held here until
+ * replies of all previous commands have been sent.
+ */
+
+struct ReplySlot
+{
+        /* Output waiting for earlier slots. */
+        
+        StreamSocket::send_queue buffer;
+        
+        /* Queries of this command that have not finished yet. */
+        
+        unsigned int running;
+        
+        /* Whether the command has returned. */
+        
+        bool executed;
+        
+        ReplySlot() : running(0), executed(false)
+        {
+        
+        }
+};
+
 class ExportAPI LocalUser : public User, public brld::node_list_node<LocalUser>
 {
  
@@ -648,7 +702,7 @@ class ExportAPI LocalUser : public User, public brld::node_list_node<LocalUser>
   
   private:
   
-	void Write(const ProtocolTrigger::SerializedMessage& serialized);
+	void Write(const ProtocolTrigger::SharedMessage& serialized);
 	
 	void Send(ProtocolTrigger::Event& protoev, ProtocolTrigger::MessageList& msglist);
 	
@@ -658,6 +712,26 @@ class ExportAPI LocalUser : public User, public brld::node_list_node<LocalUser>
 
         std::deque<PendingCMD> PendingMulti;
 
+        /* Slots of commands whose replies have not been sent. */
+        
+        std::deque<ReplySlot> Slots;
+        
+        /* Id of Slots.front(). */
+        
+        uint64_t FirstSlot;
+        
+        /* Slot receiving output, NO_SLOT if output is written right away. */
+        
+        uint64_t Writing;
+        
+        /* Whether the command being executed may be pipelined. */
+        
+        bool Pipelining;
+        
+        /* Sends slots that are complete, in order. */
+        
+        void ReleaseSlots();
+
   public:
 
 	LocalUser(int fd, engine::sockets::sockaddrs* client, engine::sockets::sockaddrs* server);
@@ -672,6 +746,14 @@ class ExportAPI LocalUser : public User, public brld::node_list_node<LocalUser>
 	
 	reference<ConfigConnect> assigned_class;
 
+        /* MULTI block being run, collects queries pushed by its commands. */
+        
+        std::shared_ptr<transaction_query> Transaction;
+
+        /* Stripes of keys given to WATCH, with their versions at that time. */
+        
+        std::map<size_t, uint64_t> Watched;
+
         /* 
          * Obtain this user's class.
          * 
@@ -685,6 +767,13 @@ class ExportAPI LocalUser : public User, public brld::node_list_node<LocalUser>
 		return assigned_class; 
 	}
 
+	/* Bytes this user may have received and not processed yet. */
+
+	unsigned long GetRecvQMax() const
+	{
+		return (assigned_class ? assigned_class->recvq : INPUT_LIMIT);
+	}
+
 	
 	void check_con_conf(bool clone_count = true);
 	
@@ -729,6 +818,87 @@ class ExportAPI LocalUser : public User, public brld::node_list_node<LocalUser>
 	bool Deserialize(Data& data);
 	
 	bool Serialize(Serializable::Data& data);
+
+        /* 
+         * Opens a reply slot for a command about to be executed. Output
+         * goes to this slot until CloseSlot() is called.
+         * 
+         * @parameters:
+	 *
+	 *         · bool	: Whether command may run next to other queries.
+         */    
+         
+	void OpenSlot(bool pipelined);
+
+        /* Command has returned, its slot is sent once its queries finish. */
+        
+	void CloseSlot();
+
+        /* 
+         * Binds a query to the slot being written.
+         * 
+         * @return:
+ 	 *
+         *         · uint64	: Slot id, or NO_SLOT.
+         */    
+         
+	uint64_t HoldSlot();
+
+        /* 
+         * Directs output to the slot of a query, while its result is flushed.
+         * 
+         * @parameters:
+	 *
+	 *         · uint64	: Slot id, as returned by HoldSlot().
+	 * 
+         * @return:
+ 	 *
+         *         · uint64	: Slot being written before, to be given to LeaveSlot().
+         */    
+         
+	uint64_t EnterSlot(uint64_t id);
+
+        /* Output goes back to the slot written before EnterSlot(). */
+        
+	void LeaveSlot(uint64_t previous = NO_SLOT);
+
+        /* 
+         * A query bound to a slot has finished.
+         * 
+         * @parameters:
+	 *
+	 *         · uint64	: Slot id.
+         */    
+         
+	void FinishSlot(uint64_t id);
+
+        /* 
+         * Whether the command being executed may be pipelined.
+         * 
+         * @return:
+ 	 *
+         *         · True: Queries of this command may run next to others.
+         */    
+         
+	bool IsPipelining()
+	{
+		return this->Pipelining;
+	}
+
+        /* 
+         * Checks whether a command may start, given queries of this
+         * user that are still running.
+         * 
+         * @parameters:
+	 *
+	 *         · bool	: Whether command may be pipelined.
+	 * 
+         * @return:
+ 	 *
+         *         · True: Command can be executed.
+         */    
+         
+	bool CanRun(bool pipelined);
 	
         /* 
          * Get pending list.
@@ -167,17 +167,19 @@ inline bool CheckKey(User* user, const std::string& value, bool notify = true)
 
 class ExportAPI Limiter : public safecast<Limiter>
 {
-   friend Limiter GetLimits(User* user, unsigned int max, const CommandModel::Params& parameters);
+   friend Limiter GetLimits(User* user, unsigned int max, const CommandModel::Params& parameters, bool paging);
     
    private:
    
       bool error;
       signed int limit;
       signed int offset;
+      bool paged;
+      std::string cursor;
   
   public:
   
-      Limiter() : error(false), limit(0), offset(0)
+      Limiter() : error(false), limit(0), offset(0), paged(false)
       {
        
       }
@@ -196,6 +198,16 @@ class ExportAPI Limiter : public safecast<Limiter>
       {
              return this->offset;      
       }
+      
+      bool GetPaged()
+      {
+             return this->paged;
+      }
+      
+      const std::string& GetCursor()
+      {
+             return this->cursor;
+      }
 };
 
 /* 
@@ -206,16 +218,40 @@ class ExportAPI Limiter : public safecast<Limiter>
  *         · User       : Requesting user.
  *         · uint       : Max parameters.
  *         · Params     : Parameters as given by the original command.,
+ *         · bool       : Whether offset may be a cursor ("@" to start, or
+ *                        "@<hex>" as returned by a previous page).
  *
  * @return:
  *
  *         · Limiter    : Returns { 0 } if invalid.
  */
 
-inline Limiter GetLimits(User* user, unsigned int max, const CommandModel::Params& parameters)
+inline Limiter GetLimits(User* user, unsigned int max, const CommandModel::Params& parameters, bool paging = false)
 {
        Limiter limiter;
 
+       if (paging && parameters.size() == max && !parameters[(max - 2)].empty() && parameters[(max - 2)][0] == '@')
+       {
+             if (!is_zero_or_great_or_mone(parameters[(max - 1)]))
+             {
+                   user->SendProtocol(ERR_INPUT, MUST_BE_GREAT_ZERO);
+                   limiter.error = true;
+                   return limiter;
+             }
+             
+             if (!hex_to_bin(parameters[(max - 2)].substr(1), limiter.cursor))
+             {
+                   user->SendProtocol(ERR_INPUT, INVALID_CURSOR);
+                   limiter.error = true;
+                   return limiter;
+             }
+             
+             limiter.paged  = true;
+             limiter.limit  = convto_num<signed int>(parameters[(max - 1)]); 
+             limiter.offset = 0;
+             return limiter;
+       }
+
        if (parameters.size() == (max - 1))
        {
              if (!is_zero_or_great_or_mone(parameters[(max - 2)]))
@@ -40,7 +40,16 @@ class ExportAPI GlobalHelper
 
       static void Delete(User* user, const std::string& entry);
       
-      static void ExpireDelete(std::shared_ptr<Database> database, unsigned int where, const std::string& key);
+      /* 
+       * Deletes expired keys of a database, in a data thread.
+       * 
+       * @parameters:
+       *
+       *         · Database : Database holding keys.
+       *         · vector   : Select and key of every entry, moved.
+       */   
+       
+      static void ExpireBatch(std::shared_ptr<Database> database, std::vector<std::pair<unsigned int, std::string>>& due);
 
       static void Exists(User* user, const std::string& entry);
       
@@ -48,6 +48,18 @@ class ExportAPI KeyHelper
 
         static void RetroLimits(User* user, std::shared_ptr<QueryBase> query, const std::string& entry, signed int offset, signed int limit, bool allow = false);
 
+        /* 
+         * Same as RetroLimits, also passing the cursor of paged listings.
+         * 
+         * @parameters:
+	 *
+	 *         · query  : Query type to create.
+	 *         · entry  : Key to submit.
+	 *         · handler: Command, as set by GetLimits.
+         */     
+         
+        static void RetroPage(User* user, std::shared_ptr<QueryBase> query, const std::string& entry, Command* handler, bool allow = false);
+
         /* 
          * Posts a simple job to the thread manager.
          * 
@@ -123,7 +123,7 @@ class SSLQueue : public IOQueue
 		
 		do
 		{
-			tmp.append(sendq.front());
+			tmp.append(sendq.front().data(), sendq.front().length());
 			sendq.pop_front();
 		}
 		while (!sendq.empty() && tmp.length() < targetsize);
@@ -143,6 +143,13 @@ class ExportAPI MonitorHandler
                  
         void Flush();
 
+        /* Checks whether events are waiting to be flushed. */
+        
+        bool Pending()
+        {
+              return !this->buffer.empty();
+        }
+
         /* 
          * Returns a MonitorMap containing all monitoring users.
          * 
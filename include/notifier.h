@@ -143,6 +143,13 @@ class ExportAPI Notifier
 
          void Flush();
 
+         /* Checks whether events are waiting to be flushed. */
+         
+         bool Pending()
+         {
+               return !this->events.empty();
+         }
+
         /* 
          * Resets NotifyList and pending events.
          * 
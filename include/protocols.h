@@ -188,6 +188,7 @@ enum BRLD_PROTOCOL
 	BRLD_END_LIST			=		283,
         BRLD_START_UNQ_LIST             =               284,
         BRLD_END_UNQ_LIST               =               285,
+        BRLD_CURSOR			=		286,
         BRLD_FIRSTOF			=		287,	
         BRLD_RESTART_OK			=		289,
         BRLD_COMMAND_ITEM		=		290,
@@ -0,0 +1,154 @@
+/*
+ * BerylDB - A lightweight database.
+ * http://www.beryldb.com
+ *
+ * Copyright (C) 2021 - Carlos F. Ferry <cferry@beryldb.com>
+ *
+ * This file is part of BerylDB. BerylDB is free software: you can
+ * redistribute it and/or modify it under the terms of the BSD License
+ * version 3.
+ *
+ * More information about our licensing can be found at https://docs.beryl.dev
+ */
+
+#pragma once
+
+#include <mutex>
+
+class Reactor;
+
+/*
+ * Client socket handed to a reactor. Reactor threads own the descriptor
+ * and do all reads and writes on it, while the mainloop keeps running
+ * commands. Both sides only meet through the buffers below, under mute.
+ */
+
+struct ExportAPI ReactorLink
+{
+        std::mutex mute;
+
+        /* Reactor polling this socket. */
+
+        Reactor* const reactor;
+
+        /* Socket in the mainloop, NULL once closed. Mainloop only. */
+
+        StreamSocket* sock;
+
+        const int fd;
+
+        /* Data read, not yet seen by the mainloop. */
+
+        std::string input;
+
+        /* Data waiting to be written. */
+
+        StreamSocket::send_queue output;
+
+        /* errno of the failed read or write, 0 if closed by peer. */
+
+        int error;
+
+        /* Queued for the mainloop, cleared once it takes input. */
+
+        bool incoming;
+
+        /* No more reads or writes are done once set. */
+
+        bool dead;
+
+        /* Reads stopped until the mainloop takes input. */
+
+        bool paused;
+
+        /* Write would block, waiting for the socket. */
+
+        bool blocked;
+
+        /* Output queued in sock, not handed over yet. Mainloop only. */
+
+        bool dirty;
+
+        /* Events polled for, none when left out of the poll set. Reactor only. */
+
+        uint32_t events;
+
+        ReactorLink(Reactor* owner, StreamSocket* socket) : reactor(owner)
+                                                          , sock(socket)
+                                                          , fd(socket->GetDescriptor())
+                                                          , error(0)
+                                                          , incoming(false)
+                                                          , dead(false)
+                                                          , paused(false)
+                                                          , blocked(false)
+                                                          , dirty(false)
+                                                          , events(0)
+        {
+
+        }
+};
+
+/*
+ * I/O threads, configured through <settings iothreads>. Each one runs
+ * its own poll set and takes a share of plain client sockets, leaving
+ * the mainloop with command processing only. Sockets with I/O hooks
+ * (ie: TLS) stay in the SocketPool.
+ */
+
+class ExportAPI Reactors
+{
+    public:
+
+        /*
+         * Starts I/O threads.
+         *
+         * @parameters:
+	 *
+	 *         · uint    : Threads to start, none keeps all sockets
+	 *                     in the mainloop.
+         */
+
+        static void Start(unsigned int count);
+
+        /* Closes remaining sockets and joins all threads. */
+
+        static void Stop();
+
+        /*
+         * Moves a socket from the SocketPool to a reactor.
+         *
+         * @parameters:
+	 *
+	 *         · StreamSocket    : Socket to hand over.
+	 *
+         * @return:
+ 	 *
+         *         · True            : Socket handed over.
+         *         · False           : No reactors running.
+         */
+
+        static bool Attach(StreamSocket* sock);
+
+        /*
+         * Hands remaining output of a socket to its reactor, which
+         * writes it and closes the descriptor.
+         *
+         * @parameters:
+	 *
+	 *         · StreamSocket    : Closing socket.
+         */
+
+        static void Detach(StreamSocket* sock);
+
+        /* Marks a socket as having output, handed over on Writes(). */
+
+        static void Queue(StreamSocket* sock);
+
+        /* Hands queued output to reactors. */
+
+        static void Writes();
+
+        /* Processes data read by reactors. */
+
+        static void Process();
+};
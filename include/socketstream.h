@@ -143,6 +143,10 @@ class ExportAPI SocketPool
 	
 	static void InitError();
 
+	/* Registers the descriptor used by Wake(). Called from Start(). */
+
+	static void InitWaker();
+
 	static void OnMaskReq(EventHandler* ehandler, int old_mask, int new_mask);
 
 	static bool AttachFileDescRef(EventHandler* ehandler);
@@ -188,7 +192,19 @@ class ExportAPI SocketPool
 	
 	static EventHandler* GetReference(int fd);
 
-	static int Events();
+	/* 
+	 * Waits for socket events.
+	 *
+	 * @parameters:
+	 *
+	 *         · int	: Max. time to wait, in milliseconds.
+	 */
+
+	static int Events(int timeout);
+
+	/* Interrupts Events(). Safe to call from any thread. */
+
+	static void Wake();
 
 	
 	static void Writes();
@@ -31,6 +31,10 @@ namespace ProtocolTrigger
 	typedef std::vector<std::string> ParamList;
 	typedef std::string SerializedMessage;
 
+	/* Serialized messages are shared by all send queues they are written to. */
+
+	typedef std::shared_ptr<const SerializedMessage> SharedMessage;
+
 	struct MessageProvider
 	{
 		MessageDataProvider* tagprov;
@@ -55,6 +59,10 @@ typedef std::map<std::string, std::string> DualMap;
 
 typedef std::multimap<std::string, std::string> DualMMap;
 
+/* Pairs of strings, kept in insertion order. */
+
+typedef std::vector<std::pair<std::string, std::string>> DualVector;
+
 /* A vector of string. */
 
 typedef std::vector<std::string> StringVector;
@@ -41,6 +41,18 @@ const std::string NO_DIFF		=	"NO_DIFF";
 
 const std::string BATCH_FAIL 		= 	"SYNC_FAILED";
 
+/* Watched key was modified before MRUN. */
+
+const std::string WATCH_CONFLICT 	= 	"WATCH_CONFLICT";
+
+/* Cursor given to a paged listing could not be decoded. */
+
+const std::string INVALID_CURSOR 	= 	"INVALID_CURSOR";
+
+/* Binary frame items do not add up to the frame length. */
+
+const std::string MALFORMED_FRAME 	= 	"MALFORMED_FRAME";
+
 /* Invalid channel */
 
 const std::string INVALID_CHAN 		= 	"INVALID_CHAN";
@@ -228,9 +240,13 @@ const std::string ACCESS_DENIED 	= 	"ACCESS_DENIED";
 
 const std::string MUST_BE_NUMERIC 	= 	"MUST_BE_NUMERIC";
 
-/* Internal registry. */
+/* Internal registry, maps a key to its type. */
+
+const std::string INT_REG 		= 	"7";
+
+/* Internal, elements of lists and fields of maps. */
 
-const std::string INT_REG 		= 	"9";
+const std::string INT_MEMBER 		= 	"0";
 
 /* Keys definition */
 
@@ -0,0 +1,36 @@
+/*
+ * BerylDB - A lightweight database.
+ * http://www.beryldb.com
+ *
+ * Copyright (C) 2021 - Carlos F. Ferry <cferry@beryldb.com>
+ * 
+ * This file is part of BerylDB. BerylDB is free software: you can
+ * redistribute it and/or modify it under the terms of the BSD License
+ * version 3.
+ *
+ * More information about our licensing can be found at https://docs.beryl.dev
+ */
+
+#include <linux/io_uring.h>
+#include <sys/syscall.h>
+#include <string.h>
+#include <unistd.h>
+
+int main() 
+{
+        struct io_uring_params params;
+        memset(&params, 0, sizeof(params));
+
+        int fd = syscall(__NR_io_uring_setup, 8, &params);
+
+        if (fd < 0)
+        {
+                return 1;
+        }
+
+        close(fd);
+
+        /* Multishot polls are as old as resource tags (5.13). */
+
+        return !((params.features & IORING_FEAT_NODROP) && (params.features & IORING_FEAT_EXT_ARG) && (params.features & IORING_FEAT_RSRC_TAGS));
+}
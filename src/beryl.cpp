@@ -13,6 +13,8 @@
 
 #include "beryl.h"
 #include "engine.h"
+#include "reactors.h"
+#include "brldb/compaction.h"
 
 std::unique_ptr<Beryl> Kernel = NULL;
 
@@ -24,7 +26,7 @@ int main(int argc, char** argv)
 	return 1;
 }
 
-Beryl::Beryl(int argc, char** argv) : ConfigFile(DEFAULT_CONFIG), Ready(false)
+Beryl::Beryl(int argc, char** argv) : ConfigFile(DEFAULT_CONFIG), Busy(false), Ready(false)
 {
 	/* Main link. */
 	
@@ -218,6 +220,10 @@ void Beryl::Initialize()
 
 	this->Store->OpenAll();
 
+	/* Opens threads handling client sockets. */
+
+	Reactors::Start(this->Config->IOThreads);
+
         /* Open all databases. */
 
         this->Store->DBM->OpenAll();
@@ -285,6 +291,10 @@ void Beryl::Dispatcher()
 		{	
 		    	PREV_TIME = TIME.tv_sec;
 			
+		    	/* Compactions run in RocksDB threads, which only see this copy. */
+		    	
+		    	ExpireFilter::SetTime(this->TIME.tv_sec);
+		    	
 		    	/* Run functions that are meant to run every 1 second. */
 		    	
 		    	this->Timed(this->TIME.tv_sec);
@@ -313,17 +323,25 @@ void Beryl::Loop()
 {
         /* Flushes pending commands. */
 
-        this->Commander->Queue->Flush();
+        const bool flushed = this->Commander->Queue->Flush();
 
         /*
          * Our socket pool needs to actively await for data in active file descriptors.
          * The SocketPool handles all socket-related writes, from modules to clients.
          * In other words, these two functions below will read and/or write
          * events that are later routed.
+         *
+         * When idle, we wait until the next second, when timers run. Data
+         * threads wake us up earlier through SocketPool::Wake().
          */
 
         SocketPool::Writes();
-        SocketPool::Events();
+        Reactors::Writes();
+        SocketPool::Events((flushed || this->Busy) ? 0 : 1000 - this->TIME.tv_nsec / 1000000);
+
+        /* Data read by I/O threads, if any. */
+
+        Reactors::Process();
 
 	/* Removes all quitting clients. */
 	
@@ -331,7 +349,7 @@ void Beryl::Loop()
 
         /* Dispatches both, pending queries and notifications. */
         
-        DataFlush::Process();
+        this->Busy = DataFlush::Process();
 
         /* Delivers data to monitors. */
 
@@ -340,6 +358,8 @@ void Beryl::Loop()
         /* Pending notifications */
         
         this->Notify->Flush();
+        
+        this->Busy = (this->Busy || this->Monitor->Pending() || this->Notify->Pending());
 
         /* Functions queued to run outside current loop. */
         
@@ -529,6 +549,10 @@ void Beryl::PrepareExit(int status, const std::string& quitmsg)
 	
 	this->Modules->UnloadAll();
 
+	/* Sockets left by clients are closed by their I/O threads. */
+
+	Reactors::Stop();
+
 	/* Shuts down socket pool. */
 	
 	SocketPool::CloseAll();
@@ -12,6 +12,7 @@
  */
 
 #include "beryl.h"
+#include "brldb/keylocks.h"
 #include "brldb/database.h"
 #include "brldb/query.h"
 #include "brldb/dbnumeric.h"
@@ -21,7 +22,7 @@
 void clone_query::Keys()
 {
     RocksData result = this->Get(this->dest);
-    const std::string& newdest = to_bin(this->key) + ":" + this->value + ":" + this->identified;
+    const std::string& newdest = to_dest(this->key, convto_num<unsigned int>(this->value), this->identified);
 
     this->ExpireBatch(newdest, this->value, this->key, convto_num<unsigned int>(this->value), this->id);
     this->SetOK();
@@ -52,6 +53,12 @@ void clone_query::Vectors()
 
 }
 
+void clone_query::Stripes(std::vector<size_t>& locked)
+{
+       QueryBase::Stripes(locked);
+       locked.push_back(KeyLocks::Stripe(this->database, convto_num<unsigned int>(this->value), this->key));
+}
+
 void clone_query::Run()
 {
     if (this->identified == INT_KEY)
@@ -87,8 +94,13 @@ void clone_query::Run()
     }   
 
     RocksData result = this->Get(this->dest);
-    const std::string& newdest = to_bin(this->key) + ":" + this->value + ":" + this->identified;
-    this->Write(newdest, result.value);
+    const std::string& newdest = to_dest(this->key, convto_num<unsigned int>(this->value), this->identified);
+    
+    rocksdb::WriteBatch batch;
+    batch.Put(newdest, result.value);
+    this->RegPut(batch, newdest);
+    this->CopyMembers(batch, this->dest, newdest);
+    this->Commit(batch);
     this->SetOK();
 }
 
@@ -0,0 +1,34 @@
+/*
+ * BerylDB - A lightweight database.
+ * http://www.beryldb.com
+ *
+ * Copyright (C) 2021 - Carlos F. Ferry <cferry@beryldb.com>
+ *
+ * This file is part of BerylDB. BerylDB is free software: you can
+ * redistribute it and/or modify it under the terms of the BSD License
+ * version 3.
+ *
+ * More information about our licensing can be found at https://docs.beryl.dev
+ */
+
+#include "beryl.h"
+#include "brldb/compaction.h"
+
+std::atomic<time_t> ExpireFilter::clock(0);
+
+bool ExpireFilter::Filter(int level, const rocksdb::Slice& key, const rocksdb::Slice& existing_value, std::string* new_value, bool* value_changed) const
+{
+        KeyData parsed;
+
+        if (!from_dest(key.ToString(), parsed))
+        {
+              return false;
+        }
+
+        if (parsed.type == INT_KEY)
+        {
+              return is_expired(existing_value.ToString(), clock.load(std::memory_order_relaxed));
+        }
+
+        return false;
+}
@@ -12,6 +12,7 @@
  */
 
 #include "beryl.h"
+#include "brldb/keylocks.h"
 #include "helpers.h"
 #include "brldb/expires.h"
 
@@ -50,6 +51,12 @@ void copy_query::Vectors()
 
 }
 
+void copy_query::Stripes(std::vector<size_t>& locked)
+{
+       QueryBase::Stripes(locked);
+       locked.push_back(KeyLocks::Stripe(this->database, this->select_query, this->value));
+}
+
 void copy_query::Run()
 {
     if (this->identified == INT_KEY)
@@ -78,8 +85,13 @@ void copy_query::Run()
     }   
 
     RocksData result = this->Get(this->dest);
-    const std::string& newdest = to_bin(this->value) + ":" + convto_string(convto_string(this->select_query)) + ":" + this->identified;
-    this->Write(newdest, result.value);
+    const std::string& newdest = to_dest(this->value, this->select_query, this->identified);
+    
+    rocksdb::WriteBatch batch;
+    batch.Put(newdest, result.value);
+    this->RegPut(batch, newdest);
+    this->CopyMembers(batch, this->dest, newdest);
+    this->Commit(batch);
 }
 
 void copy_query::Process()
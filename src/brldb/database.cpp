@@ -11,10 +11,15 @@
  * More information about our licensing can be found at https://docs.beryl.dev
  */
 
+#include <chrono>
+
 #include "beryl.h"
 #include "exit.h"
 #include "engine.h"
 #include "brldb/datathread.h"
+#include "brldb/codec.h"
+#include "brldb/keylocks.h"
+#include "brldb/merge.h"
 #include "managers/user.h"
 #include "managers/settings.h"
 
@@ -28,11 +33,148 @@ bool Database::IsClosing()
         return this->Closing;
 }
 
-Database::Database(const std::string& dbname, const std::string& dbpath) : created(Kernel->Now()), name(dbname), path(Kernel->Config->Paths->SetWDDB(dbpath))
+Database::Database(const std::string& dbname, const std::string& dbpath) : created(Kernel->Now()), name(dbname), path(Kernel->Config->Paths->SetWDDB(dbpath)), committing(false)
 {
         this->SetClosing(false);
 }
 
+namespace
+{
+      /* Copies the operations of a batch into a group. */
+      
+      class GroupAppend : public rocksdb::WriteBatch::Handler
+      {
+          private:
+          
+              rocksdb::WriteBatch& group;
+              
+          public:
+          
+              GroupAppend(rocksdb::WriteBatch& target) : group(target)
+              {
+              
+              }
+              
+              rocksdb::Status PutCF(uint32_t family, const rocksdb::Slice& key, const rocksdb::Slice& value) override
+              {
+                     return this->group.Put(key, value);
+              }
+
+              rocksdb::Status DeleteCF(uint32_t family, const rocksdb::Slice& key) override
+              {
+                     return this->group.Delete(key);
+              }
+
+              rocksdb::Status MergeCF(uint32_t family, const rocksdb::Slice& key, const rocksdb::Slice& value) override
+              {
+                     return this->group.Merge(key, value);
+              }
+
+              rocksdb::Status DeleteRangeCF(uint32_t family, const rocksdb::Slice& begin, const rocksdb::Slice& end) override
+              {
+                     return this->group.DeleteRange(begin, end);
+              }
+      };
+}
+
+bool Database::Commit(rocksdb::WriteBatch& batch)
+{
+        CommitRequest request(&batch);
+        
+        std::unique_lock<std::mutex> lk(this->commit_mute);
+        
+        this->commit_queue.push_back(&request);
+        this->gathering.notify_one();
+
+        const unsigned int window = Kernel->Config->DB.commitusec;
+        const size_t maxops = Kernel->Config->DB.commitops;
+        
+        rocksdb::WriteOptions wopts;
+        wopts.sync = Kernel->Config->DB.sync;
+
+        for (;;)
+        {
+              /* Another thread may write this batch as part of its group. */
+              
+              this->committed.wait(lk, [this, &request] { return request.done || !this->committing; });
+              
+              if (request.done)
+              {
+                    return request.status.ok();
+              }
+              
+              /* This thread leads the next group. */
+              
+              this->committing = true;
+              
+              if (window && this->commit_queue.size() < maxops)
+              {
+                    this->gathering.wait_for(lk, std::chrono::microseconds(window), [this, maxops] { return this->commit_queue.size() >= maxops; });
+              }
+              
+              /* Groups are written in arrival order, up to maxops batches. */
+              
+              std::vector<CommitRequest*> group;
+              
+              if (this->commit_queue.size() > maxops)
+              {
+                    group.assign(this->commit_queue.begin(), this->commit_queue.begin() + maxops);
+                    this->commit_queue.erase(this->commit_queue.begin(), this->commit_queue.begin() + maxops);
+              }
+              else
+              {
+                    group.swap(this->commit_queue);
+              }
+              
+              lk.unlock();
+              
+              rocksdb::Status written;
+              
+              /* Keyspace counters are written along with the entries they count. */
+              
+              if (group.size() == 1)
+              {
+                    written = this->Count(*group.front()->batch);
+                    
+                    if (written.ok())
+                    {
+                           written = this->db->Write(wopts, group.front()->batch);
+                    }
+              }
+              else
+              {
+                    rocksdb::WriteBatch merged;
+                    GroupAppend append(merged);
+                    
+                    for (std::vector<CommitRequest*>::const_iterator i = group.begin(); i != group.end() && written.ok(); ++i)
+                    {
+                           written = (*i)->batch->Iterate(&append);
+                    }
+                    
+                    if (written.ok())
+                    {
+                           written = this->Count(merged);
+                    }
+                    
+                    if (written.ok())
+                    {
+                           written = this->db->Write(wopts, &merged);
+                    }
+              }
+              
+              lk.lock();
+              
+              for (std::vector<CommitRequest*>::const_iterator i = group.begin(); i != group.end(); ++i)
+              {
+                    (*i)->status = written;
+                    (*i)->done = true;
+              }
+              
+              this->committing = false;
+              this->committed.notify_all();
+        }
+}
+
 CoreDatabase::CoreDatabase() : Database(CORE_DB, CORE_DB + ".db")
 {
 
@@ -69,6 +211,19 @@ bool Database::Open()
         options.write_thread_max_yield_usec 	= Kernel->Config->DB.yieldusec;
         options.enable_thread_tracking 		= true;
         options.enable_pipelined_write 		= Kernel->Config->DB.pipeline;
+        
+        /* Type and select lead every key, so per-select scans are prefix seeks. */
+        
+        options.prefix_extractor.reset(rocksdb::NewFixedPrefixTransform(KEY_PREFIX_LENGTH));
+        options.memtable_prefix_bloom_size_ratio = 0.1;
+
+        /* Blind writes (VPUSH, keyspace counters) are resolved by RocksDB. */
+        
+        options.merge_operator = std::make_shared<ValueMerge>();
+
+        /* Expired keys are dropped by compactions, even if not deleted yet. */
+        
+        options.compaction_filter = &this->filter;
 
         this->status 				= rocksdb::DB::Open(options, this->path, &this->db);
 
@@ -83,6 +238,11 @@ bool Database::Open()
         else
         {
                 slog("DATABASE", LOG_DEFAULT, "Database opened: %s: %s", this->path.c_str(), this->status.ToString().c_str());
+                
+                if (!this->Upgrade())
+                {
+                        Kernel->Exit(EXIT_CODE_DATABASE, true, true);
+                }
         }
 
         return true;
@@ -111,6 +271,10 @@ bool Database::FlushDB()
         rocksdb::DestroyDB(this->path, d_options);
         
         this->SetClosing(false);
+
+        /* Every key is gone, so users watching any of them must see a change. */
+
+        KeyLocks::Bump(std::vector<size_t>());
         
         /* Open the database again. */
         
@@ -206,11 +370,17 @@ void StoreManager::OpenAll()
        for (unsigned int i = 1; i <= Kernel->Config->DB.datathread; i++)
        {
               DataThread* New = new DataThread();   
-              New->Create();
               Kernel->Store->Flusher->threadslist.push_back(New);
               counter++;
        }
 
+       /* Threads steal from each other, so all of them must be listed before starting. */
+
+       for (DataThreadVector::const_iterator i = Kernel->Store->Flusher->threadslist.begin(); i != Kernel->Store->Flusher->threadslist.end(); ++i)
+       {
+              (*i)->Create();
+       }
+
        if (!counter)
        {
               bprint(ERROR, "Threads must be greater than 0.");
@@ -230,6 +400,25 @@ void StoreManager::Push(std::shared_ptr<QueryBase> request)
            return;
       }
 
+      LocalUser* const localuser = IS_LOCAL(user);
+      
+      /* Replies of this query are sent in the order its command was received. */
+      
+      if (localuser)
+      {
+           request->pipelined = localuser->IsPipelining();
+           request->slot = localuser->HoldSlot();
+           
+           /* Queries of a MULTI block are run together, once the block has been read. */
+           
+           if (localuser->Transaction && request->flags != QUERY_FLAGS_GLOBAL)
+           {
+                localuser->Transaction->Add(request);
+                return;
+           }
+      }
+
       user->pending.push_back(request);       
+      DataFlush::AttachPending(user);
 }
 
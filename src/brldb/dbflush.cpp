@@ -11,7 +11,10 @@
  * More information about our licensing can be found at https://docs.beryl.dev
  */
 
+#include <algorithm>
+
 #include "beryl.h"
+#include "brldb/keylocks.h"
 #include "engine.h"
 #include "algo.h"
 
@@ -19,6 +22,14 @@ namespace
 {
       void CheckFlush(User* user, std::shared_ptr<QueryBase> signal)
       {
+              /* MULTI blocks reply for each of their queries. */
+              
+              if (signal->type == QUERY_TYPE_MULTI)
+              {
+                    DataFlush::Flush(user, signal);
+                    return;
+              }
+              
               switch (signal->access)
               {
                     case DBL_NOT_FOUND:
@@ -81,16 +92,60 @@ namespace
                                 DataFlush::NotNumeric(user, signal);
                     break;
 
+                    /* Interrupted queries have nothing to reply. */
+                    
+                    case DBL_INTERRUPT:
+                    break;
+
                     default:
                                 DataFlush::Flush(user, signal);
               }
       }
 }
 
-std::mutex DataFlush::query_mute;
-
 std::mutex DataFlush::mute;
 
+CompletionQueue DataFlush::Completed;
+
+std::set<std::string> DataFlush::Ready;
+
+CompletionQueue::~CompletionQueue()
+{
+      std::vector<std::shared_ptr<QueryBase>> discard;
+      this->Take(discard);
+}
+
+void CompletionQueue::Push(const std::shared_ptr<QueryBase>& query)
+{
+      Node* node = new Node;
+      node->query = query;
+      node->next = this->head.load(std::memory_order_relaxed);
+      
+      while (!this->head.compare_exchange_weak(node->next, node, std::memory_order_release, std::memory_order_relaxed))
+      {
+      
+      }
+}
+
+void CompletionQueue::Take(std::vector<std::shared_ptr<QueryBase>>& taken)
+{
+      Node* node = this->head.exchange(NULL, std::memory_order_acquire);
+      
+      /* Nodes are linked newest first. */
+      
+      const size_t first = taken.size();
+      
+      while (node)
+      {
+             Node* next = node->next;
+             taken.push_back(node->query);
+             delete node;
+             node = next;
+      }
+      
+      std::reverse(taken.begin() + first, taken.end());
+}
+
 void DataFlush::Pause()
 {
       this->running = false;
@@ -118,8 +173,11 @@ void DataFlush::AttachResult(const std::shared_ptr<QueryBase> signal)
                  return;
             }
             
-            std::lock_guard<std::mutex> lg(DataFlush::mute);
-            signal->user->notifications.push_back(signal);
+            DataFlush::Completed.Push(signal);
+            
+            /* Mainloop may be waiting for socket events. */
+            
+            SocketPool::Wake();
 }
 
 void DataFlush::AttachGlobal(const std::shared_ptr<QueryBase> signal)
@@ -134,98 +192,107 @@ void DataFlush::AttachGlobal(const std::shared_ptr<QueryBase> signal)
             signal->user->SetLock(false);
 }
 
-void DataFlush::GetResults()
+bool DataFlush::GetResults()
 {
-            const UserMap& users = Kernel->Clients->GetInstances();
+            std::vector<std::shared_ptr<QueryBase>> results;
+            DataFlush::Completed.Take(results);
             
-            if (!users.size())
+            for (std::vector<std::shared_ptr<QueryBase>>::const_iterator i = results.begin(); i != results.end(); ++i)
             {
-                  return;
-            }
+                        const std::shared_ptr<QueryBase>& signal = *i;
 
-            DataFlush::mute.lock();
-            
-            for (UserMap::const_iterator i = users.begin(); i != users.end(); ++i)
-            {
-                        User* const user = i->second;
-
-                        if (user == NULL || user->IsQuitting() || !user->notifications.size())
+                        DataFlush::Reply(signal);
+                              
+                        if (!signal->partial)
                         {
-                              continue;
+                              DataFlush::Release(signal);
                         }
-                        
-                        /* Nothing to iterate if user has no pending notifications. */
-
-                        if (user->notifications.size())
-                        {
-                              std::shared_ptr<QueryBase> signal = user->notifications.front();
-                              
-                              /* Removes signal from queue. */
-                              
-                              user->notifications.pop_front();
-                              
-                              if (!signal->GetStatus())
-                              {
-                                    LocalUser* localuser = IS_LOCAL(user);
-                                    NOTIFY_MODS(OnQueryFailed, (signal->access, localuser, signal));
-                              }
-                              
-                              CheckFlush(user, signal);
-                              
-                              if (!signal->partial)
-                              {
-                                    user->SetLock(false);
-                              }
-                  }
             }
             
-            DataFlush::mute.unlock();
+            return !results.empty();
 }
 
-void DataFlush::Process()
+bool DataFlush::Process()
 {
       /* We should not dispatch anything if we are paused. */
       
       if (!Kernel->Store->Flusher->Status())  
       {
-            return;   
+            return false;   
       }
 
-      DataFlush::GetResults();
-      DataFlush::GetPending();
+      const bool delivered = DataFlush::GetResults();
+      const bool dispatched = DataFlush::GetPending();
+      
+      return (delivered || dispatched);
 }
 
-void DataFlush::GetPending()
+bool DataFlush::GetPending()
 {
       /* Before processing user pendings, we must check global. */
       
       if (Kernel->Clients->Global->pending.size())
       {
                Process(Kernel->Clients->Global, Kernel->Clients->Global->pending.front());
-               return;
+               return true;
       }
 
-      const UserMap& users = Kernel->Clients->GetInstances();
+      bool dispatched = false;
       
-      if (!users.size())
+      for (std::set<std::string>::const_iterator i = DataFlush::Ready.begin(); i != DataFlush::Ready.end(); )
       {
-            return;
-      }
-      
-      for (UserMap::const_iterator i = users.begin(); i != users.end(); ++i)
-      {
-               User* const user = i->second;
-
-               const unsigned int pending = user->pending.size();
+               User* const user = Kernel->Clients->FindUUID(*i);
 
-               if ((user && !user->IsQuitting()) && (!pending || user->IsLocked()))
+               if (user && user->IsQuitting())
+               {
+                    user->pending.clear();
+               }
+               
+               if (!user || user->pending.empty())
                {
+                    i = DataFlush::Ready.erase(i);
                     continue;
                }
                
-               user->SetLock(true);
-               Process(user, user->pending.front());
+               ++i;
+
+               /* 
+                * Pipelined queries are posted together, up to the depth checked when
+                * their commands ran. Any other query runs alone.
+                */
+               
+               while (!user->pending.empty() && !user->IsLocked())
+               {
+                    const std::shared_ptr<QueryBase> signal = user->pending.front();
+                    
+                    if (!signal->pipelined && user->InFlight)
+                    {
+                         break;
+                    }
+                    
+                    if (!Process(user, signal))
+                    {
+                         break;
+                    }
+                    
+                    dispatched = true;
+                    
+                    if (!signal->pipelined)
+                    {
+                         user->SetLock(true);
+                         break;
+                    }
+                    
+                    user->InFlight++;
+               }
       }
+      
+      return dispatched;
+}
+
+void DataFlush::AttachPending(User* user)
+{
+      DataFlush::Ready.insert(user->uuid);
 }
 
 void DataThread::SetStatus(bool flag)
@@ -238,12 +305,107 @@ bool DataThread::IsBusy()
       return this->busy;
 }
 
-void DataFlush::Process(User* user, std::shared_ptr<QueryBase> signal)
+void DataFlush::Reply(const std::shared_ptr<QueryBase>& signal)
 {
-      if (!signal || !Kernel->Store->Flusher->Status())
+      User* const user = signal->user;
+
+      /* Quitting users are released, so they can exit. */
+
+      if (!user || user->IsQuitting())
       {
             return;
       }
+      
+      LocalUser* const localuser = IS_LOCAL(user);
+
+      if (!signal->GetStatus())
+      {
+            NOTIFY_MODS(OnQueryFailed, (signal->access, localuser, signal));
+      }
+      
+      /* Replies are held until previous commands have replied. */
+      
+      uint64_t previous = NO_SLOT;
+      
+      if (localuser)
+      {
+            previous = localuser->EnterSlot(signal->slot);
+      }
+      
+      CheckFlush(user, signal);
+      
+      /* Paged listings end with the cursor of their next page. */
+      
+      if (signal->paged && !signal->partial && signal->GetStatus())
+      {
+            user->SendProtocol(BRLD_CURSOR, signal->GetCursor());
+      }
+      
+      if (localuser)
+      {
+            localuser->LeaveSlot(previous);
+      }
+}
+
+void DataFlush::FinishSlots(const std::shared_ptr<QueryBase>& signal)
+{
+      LocalUser* const localuser = IS_LOCAL(signal->user);
+      
+      if (!localuser)
+      {
+            return;
+      }
+      
+      /* Queries of a MULTI block hold the slots of their own commands. */
+      
+      if (signal->type == QUERY_TYPE_MULTI)
+      {
+            const std::vector<std::shared_ptr<QueryBase>>& queries = static_cast<transaction_query*>(signal.get())->queries;
+            
+            for (std::vector<std::shared_ptr<QueryBase>>::const_iterator i = queries.begin(); i != queries.end(); ++i)
+            {
+                  localuser->FinishSlot((*i)->slot);
+            }
+      }
+      
+      localuser->FinishSlot(signal->slot);
+}
+
+void DataFlush::Discard(User* user)
+{
+      for (std::deque<std::shared_ptr<QueryBase>>::const_iterator i = user->pending.begin(); i != user->pending.end(); ++i)
+      {
+            DataFlush::FinishSlots(*i);
+      }
+      
+      user->pending.clear();
+}
+
+void DataFlush::Release(const std::shared_ptr<QueryBase>& signal)
+{
+      User* const user = signal->user;
+      
+      if (signal->pipelined)
+      {
+            if (user->InFlight)
+            {
+                  user->InFlight--;
+            }
+      }
+      else
+      {
+            user->SetLock(false);
+      }
+      
+      DataFlush::FinishSlots(signal);
+}
+
+bool DataFlush::Process(User* user, std::shared_ptr<QueryBase> signal)
+{
+      if (!signal || !Kernel->Store->Flusher->Status())
+      {
+            return false;
+      }
 
       const DataThreadVector& Threads = Kernel->Store->Flusher->GetThreads();
       
@@ -257,38 +419,41 @@ void DataFlush::Process(User* user, std::shared_ptr<QueryBase> signal)
            
              /* First, we attempt to find an unused thread. */
            
-             if (!thread->IsBusy())
+             if (!thread->IsBusy() && !thread->Pending())
              {
                    /* No need to continue looking for a thread. */
 
                    ToUse = thread;
                    break; 
              }
+             
+             /* Otherwise, the thread with fewer queued queries. Idle threads steal from it anyway. */
+             
+             if (!ToUse || thread->Pending() < ToUse->Pending())
+             {
+                   ToUse = thread;
+             }
       }
-      
-      /* Checks whether we have assigned a thread. */
+
+      /* Unable to find any thread at all. */
       
       if (!ToUse)
       {
-            /* We find a random thread to attach this signal into. */
-      
-            ToUse = *random_item(Threads.begin(), Threads.end());
+            DataFlush::Discard(user);
+            return false;
       }
 
-      /* Unable to find any thread at all. */
+      /* Let's start processing this signal. */
       
-      if (!ToUse)
+      if (!ToUse->Post(signal))
       {
-            user->SetLock(false);
-            user->pending.clear();
-            return;
+            /* Threads are full, this signal is retried in the next loop. */
+            
+            return false;
       }
 
       user->pending.pop_front();
-
-      /* Let's start processing this signal. */
-      
-      ToUse->Post(signal);
+      return true;
 }
 
 void DataFlush::ResetAll()
@@ -298,35 +463,46 @@ void DataFlush::ResetAll()
       if (Kernel->Clients->Global)
       {
            Kernel->Clients->Global->pending.clear();
-           Kernel->Clients->Global->notifications.clear();
       }
       
-      /* Clear up pending notifications. */
+      /* Drops finished queries, releasing their users. */
 
-      const UserMap& users = Kernel->Clients->GetInstances();
+      std::vector<std::shared_ptr<QueryBase>> results;
+      DataFlush::Completed.Take(results);
       
-      DataFlush::mute.lock();
+      for (std::vector<std::shared_ptr<QueryBase>>::const_iterator i = results.begin(); i != results.end(); ++i)
+      {
+              if (!(*i)->partial)
+              {
+                     DataFlush::Release(*i);
+              }
+      }
       
-      for (UserMap::const_iterator i = users.begin(); i != users.end(); ++i)
+      /* Clear up pending queries. */
+
+      for (std::set<std::string>::const_iterator i = DataFlush::Ready.begin(); i != DataFlush::Ready.end(); ++i)
       {           
-              User* const user = i->second;
+              User* const user = Kernel->Clients->FindUUID(*i);
             
-              if (user == NULL || user->IsQuitting())
+              if (user)
               {
-                     continue;
+                     DataFlush::Discard(user);
               }
-
-              user->notifications.clear();
-              user->pending.clear();
       }
 
-      DataFlush::mute.unlock();
+      DataFlush::Ready.clear();
 
       Kernel->Store->Expires->Reset();
       Kernel->Store->Flusher->Resume();
 }
 
-DataThread::DataThread() : handler(nullptr), busy(false)
+std::mutex DataThread::idle;
+
+std::condition_variable DataThread::wakeup;
+
+std::atomic<size_t> DataThread::queued(0);
+
+DataThread::DataThread() : handler(nullptr), busy(false), exiting(false)
 {
 
 }
@@ -338,35 +514,53 @@ void DataThread::Exit()
              return;
       }  
 
-      std::shared_ptr<ThreadMsg> Input(new ThreadMsg(PROC_EXIT_THREAD, 0));
       {
-             std::lock_guard<std::mutex> lock(m_mutex);
-             queue.push(Input);
-             m_cv.notify_one();
+             std::lock_guard<std::mutex> lock(DataThread::idle);
+             this->exiting = true;
       }
 
+      DataThread::wakeup.notify_all();
+
       handler->join();
       handler = NULL;
+      
+      this->Clear();
 }
 
-void DataThread::Post(const std::shared_ptr<QueryBase> query)
+bool DataThread::Post(const std::shared_ptr<QueryBase> query)
 {	
       if (!handler)
       {
-            return;
+            return false;
       }
 
       if (!query || !query->database || query->database->IsClosing())
       {
-            query->user->SendProtocol(ERR_INPUT, DB_NULL);
-            query->user->SetLock(false);
-            return;
+            /* Replied as a failed query, so its user is released in order. */
+            
+            query->access_set(DBL_STATUS_BROKEN);
+            DataFlush::AttachResult(query);
+            return true;
       }
            
-      std::shared_ptr<ThreadMsg> Input(new ThreadMsg(PROC_SIGNAL, query));
-      std::unique_lock<std::mutex> lk(m_mutex);
-      queue.push(Input);
-      m_cv.notify_one();
+      ThreadMsg* Input = new ThreadMsg(PROC_SIGNAL, query);
+      
+      if (!this->deque.Push(Input))
+      {
+            delete Input;
+            return false;
+      }
+      
+      DataThread::queued++;
+      
+      /* Taking the mutex ensures a thread about to sleep sees this message. */
+      
+      {
+            std::lock_guard<std::mutex> lock(DataThread::idle);
+      }
+      
+      DataThread::wakeup.notify_one();
+      return true;
 }
 
 std::thread::id DataThread::Create()
@@ -379,48 +573,59 @@ std::thread::id DataThread::Create()
       return handler->get_id();
 }
 
-void DataThread::Process()
+ThreadMsg* DataThread::Next()
 {
-      while (true)
+      ThreadMsg* signal = this->deque.Steal();
+      
+      if (signal)
       {
-              std::shared_ptr<ThreadMsg> signal;
-              {
-                      std::unique_lock<std::mutex> lk(m_mutex);
-
-                      while (queue.empty())
-                      {
-                            m_cv.wait(lk);
-                      }
+            return signal;
+      }
+      
+      /* Nothing queued here, steal from other threads. */
+      
+      const DataThreadVector& Threads = Kernel->Store->Flusher->GetThreads();
+      
+      for (DataThreadVector::const_iterator i = Threads.begin(); i != Threads.end(); ++i)
+      {
+            if (*i != this && (signal = (*i)->deque.Steal()))
+            {
+                  return signal;
+            }
+      }
+      
+      return NULL;
+}
 
-                      if (queue.empty())
-                      {
-                            continue;
-                      }
+void DataThread::Process()
+{
+      while (!this->exiting)
+      {
+              /* Queries are kept queued while the flusher is paused. */
 
-                      signal = queue.front();
+              if (!Kernel->Store->Flusher->Status())
+              {
+                    std::this_thread::sleep_for(std::chrono::milliseconds(1));
+                    continue;
               }
+              
+              std::unique_ptr<ThreadMsg> signal(this->Next());
+              
+              if (!signal)
+              {
+                    std::unique_lock<std::mutex> lk(DataThread::idle);
+                    DataThread::wakeup.wait(lk, [this] { return this->exiting || DataThread::queued > 0; });
+                    continue;
+              }
+              
+              DataThread::queued--;
 
               /* Indicates this thread is busy. */
 
               this->SetStatus(true);
 
-              if (!Kernel->Store->Flusher->Status())
-              {
-                    this->SetStatus(false);
-                    continue;
-              }
-
               switch (signal->id)
               {
-                    case PROC_EXIT_THREAD:
-                    {
-                          DataFlush::query_mute.lock();
-                          this->Clear();
-                          DataFlush::query_mute.unlock();
-                          
-                          return;
-                    }
-                    
                     case PROC_SIGNAL:
                     {
                           std::shared_ptr<QueryBase> request = signal->msg;
@@ -437,27 +642,19 @@ void DataThread::Process()
                                      this->SetStatus(false);
                                }
                                
-                               queue.pop();
-                               
-                               signal.reset();
-                               signal = NULL;
-                               
                                break;
                           }
                           
-                          queue.pop();
-                          
-                          DataFlush::query_mute.lock();
-                          
                           if (request->access != DBL_INVALID_FORMAT)
                           {
+                                 /* Only queries sharing a key stripe wait for each other. */
+                                 
+                                 KeyGuard guard(request.get());
                                  request->Prepare();
                           }
 
                           this->SetStatus(false);
 
-                         DataFlush::query_mute.unlock();
-
                           if (request->flags == QUERY_FLAGS_QUIET)
                           {
                                  break;
@@ -469,12 +666,9 @@ void DataThread::Process()
                                  break;
                           }
 
-                          if (request->access != DBL_INTERRUPT)
-                          {
-                                 /* Adds result to the pending notification list. */
+                          /* Interrupted queries are attached too, so their users are released. */
 
-                                 DataFlush::AttachResult(request);
-                          }
+                          DataFlush::AttachResult(request);
                         
                           break;
                     }
@@ -494,8 +688,14 @@ DataThread::~DataThread()
 
 void DataThread::Clear()
 {
-         std::queue<std::shared_ptr<ThreadMsg>> empty;
-         std::swap(this->queue, empty);
+         ThreadMsg* signal = NULL;
+         
+         while ((signal = this->deque.Steal()))
+         {
+                DataThread::queued--;
+                delete signal;
+         }
+         
          this->SetStatus(false);
 }
 
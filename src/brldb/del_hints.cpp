@@ -20,16 +20,15 @@
 
 void del_query::Keys()
 {
-       const std::string& lookup = to_bin(this->key) + ":" + convto_string(convto_string(this->select_query)) + ":" + INT_EXPIRE + ":" + this->database->GetName();
+       const std::string& lookup = to_dest(this->key, this->select_query, INT_EXPIRE);
 
        rocksdb::WriteBatch batch;
 
        batch.Delete(this->dest);
+       this->RegDelete(batch, this->dest);
        batch.Delete(lookup);
        
-       rocksdb::Status stats = this->database->GetAddress()->Write(rocksdb::WriteOptions(), &batch);
-
-       if (stats.ok())
+       if (this->Commit(batch))
        {
              Kernel->Store->Expires->Delete(this->database, this->key, this->select_query);
              this->SetOK();
@@ -12,6 +12,7 @@
  */
 
 #include "beryl.h"
+#include "brldb/keylocks.h"
 #include "engine.h"
 #include "brldb/list_handler.h"
 #include "brldb/multimap_handler.h"
@@ -23,10 +24,10 @@
 
 void diff_query::Keys()
 {
-    std::string lookup  = to_bin(this->value) + ":" + convto_string(convto_string(this->select_query)) + ":" + this->identified;
+    std::string lookup  = to_dest(this->value, this->select_query, this->identified);
     
     std::string dbvalue;
-    rocksdb::Status fstatus = this->database->GetAddress()->Get(rocksdb::ReadOptions(), lookup, &dbvalue);     
+    rocksdb::Status fstatus = this->Read(lookup, &dbvalue);     
     
     if (!fstatus.ok())
     {
@@ -36,7 +37,7 @@ void diff_query::Keys()
     
     RocksData query_result = this->Get(this->dest);
     
-    if (query_result.value == dbvalue)
+    if (from_value(query_result.value) == from_value(dbvalue))
     {
           this->response = "0";
     }
@@ -49,14 +50,13 @@ void diff_query::Keys()
 
 void diff_query::Maps()
 {
-    RocksData query_result = this->Get(this->dest);
+    std::shared_ptr<MapHandler> handler1 = std::make_shared<MapHandler>();
+    this->LoadMap(this->dest, handler1->GetList());
 
-    std::shared_ptr<MapHandler> handler1 = MapHandler::Create(query_result.value);
-
-    std::string lookup  = to_bin(this->value) + ":" + convto_string(convto_string(this->select_query)) + ":" + this->identified;
+    std::string lookup  = to_dest(this->value, this->select_query, this->identified);
 
     std::string dbvalue;
-    rocksdb::Status fstatus = this->database->GetAddress()->Get(rocksdb::ReadOptions(), lookup, &dbvalue);
+    rocksdb::Status fstatus = this->Read(lookup, &dbvalue);
 
     if (!fstatus.ok())
     {
@@ -64,7 +64,8 @@ void diff_query::Maps()
           return;
     }
 
-    std::shared_ptr<MapHandler> handler2 = MapHandler::Create(dbvalue);
+    std::shared_ptr<MapHandler> handler2 = std::make_shared<MapHandler>();
+    this->LoadMap(lookup, handler2->GetList());
 
     StringVector flist = DiffHandler::CompareMap(handler2->GetList(), handler1->GetList());
 
@@ -97,6 +98,7 @@ void diff_query::Maps()
                                                 std::shared_ptr<diff_query> request = std::make_shared<diff_query>();
                                                 request->user = this->user;
                                                 request->partial = true;
+                                                request->slot = this->slot;
                                                 request->subresult = tracker;
                                                 request->VecData = result;
                                                 result.clear();
@@ -121,6 +123,7 @@ void diff_query::Maps()
                                         std::shared_ptr<diff_query> request = std::make_shared<diff_query>();
                                         request->user = this->user;
                                         request->partial = true;
+                                        request->slot = this->slot;
                                         request->subresult = tracker;
                                         request->VecData = result;
                                         result.clear();
@@ -145,10 +148,10 @@ void diff_query::Multis()
 
     std::shared_ptr<MultiMapHandler> handler1 = MultiMapHandler::Create(query_result.value);
     
-    std::string lookup  = to_bin(this->value) + ":" + convto_string(convto_string(this->select_query)) + ":" + this->identified;
+    std::string lookup  = to_dest(this->value, this->select_query, this->identified);
     
     std::string dbvalue;
-    rocksdb::Status fstatus = this->database->GetAddress()->Get(rocksdb::ReadOptions(), lookup, &dbvalue);     
+    rocksdb::Status fstatus = this->Read(lookup, &dbvalue);     
     
     if (!fstatus.ok())
     {
@@ -189,6 +192,7 @@ void diff_query::Multis()
                                                 std::shared_ptr<diff_query> request = std::make_shared<diff_query>();
                                                 request->user = this->user;
                                                 request->partial = true;                                  
+                                                request->slot = this->slot;
                                                 request->subresult = tracker;
                                                 request->VecData = result;
                                                 result.clear();
@@ -213,6 +217,7 @@ void diff_query::Multis()
                                         std::shared_ptr<diff_query> request = std::make_shared<diff_query>();
                                         request->user = this->user;
                                         request->partial = true;
+                                        request->slot = this->slot;
                                         request->subresult = tracker;
                                         request->VecData = result;
                                         result.clear();
@@ -234,10 +239,10 @@ void diff_query::Multis()
 
 void diff_query::Geos()
 {
-    std::string lookup  = to_bin(this->value) + ":" + convto_string(this->select_query) + ":" + this->identified;
+    std::string lookup  = to_dest(this->value, this->select_query, this->identified);
     
     std::string dbvalue;
-    rocksdb::Status fstatus = this->database->GetAddress()->Get(rocksdb::ReadOptions(), lookup, &dbvalue);     
+    rocksdb::Status fstatus = this->Read(lookup, &dbvalue);     
     
     if (!fstatus.ok())
     {
@@ -264,10 +269,10 @@ void diff_query::Vectors()
 
     std::shared_ptr<VectorHandler> handler1 = VectorHandler::Create(query_result.value);
     
-    std::string lookup  = to_bin(this->value) + ":" + convto_string(this->select_query) + ":" + this->identified;
+    std::string lookup  = to_dest(this->value, this->select_query, this->identified);
     
     std::string dbvalue;
-    rocksdb::Status fstatus = this->database->GetAddress()->Get(rocksdb::ReadOptions(), lookup, &dbvalue);     
+    rocksdb::Status fstatus = this->Read(lookup, &dbvalue);     
     
     if (!fstatus.ok())
     {
@@ -308,6 +313,7 @@ void diff_query::Vectors()
                                                 std::shared_ptr<diff_query> request = std::make_shared<diff_query>();
                                                 request->user = this->user;
                                                 request->partial = true;                                  
+                                                request->slot = this->slot;
                                                 request->subresult = tracker;
                                                 request->VecData = result;
                                                 result.clear();
@@ -332,6 +338,7 @@ void diff_query::Vectors()
                                         std::shared_ptr<diff_query> request = std::make_shared<diff_query>();
                                         request->user = this->user;
                                         request->partial = true;
+                                        request->slot = this->slot;
                                         request->subresult = tracker;
                                         request->VecData = result;
                                         result.clear();
@@ -353,14 +360,13 @@ void diff_query::Vectors()
 
 void diff_query::Lists()
 {
-    RocksData query_result = this->Get(this->dest);
+    std::shared_ptr<ListHandler> handler1 = std::make_shared<ListHandler>();
+    this->LoadList(this->dest, handler1->GetList());
     
-    std::shared_ptr<ListHandler> handler1 = ListHandler::Create(query_result.value);
-    
-    std::string lookup  = to_bin(this->value) + ":" + convto_string(this->select_query) + ":" + this->identified;
+    std::string lookup  = to_dest(this->value, this->select_query, this->identified);
     
     std::string dbvalue;
-    rocksdb::Status fstatus = this->database->GetAddress()->Get(rocksdb::ReadOptions(), lookup, &dbvalue);     
+    rocksdb::Status fstatus = this->Read(lookup, &dbvalue);     
     
     if (!fstatus.ok())
     {
@@ -368,7 +374,8 @@ void diff_query::Lists()
           return;
     }
     
-    std::shared_ptr<ListHandler> handler2 = ListHandler::Create(dbvalue);
+    std::shared_ptr<ListHandler> handler2 = std::make_shared<ListHandler>();
+    this->LoadList(lookup, handler2->GetList());
     
     ListMap flist = DiffHandler::CompareList(handler2->GetList(), handler1->GetList());
     
@@ -401,6 +408,7 @@ void diff_query::Lists()
                                                 std::shared_ptr<diff_query> request = std::make_shared<diff_query>();
                                                 request->user = this->user;
                                                 request->partial = true;                                  
+                                                request->slot = this->slot;
                                                 request->subresult = tracker;
                                                 request->VecData = result;
                                                 result.clear();
@@ -425,6 +433,7 @@ void diff_query::Lists()
                                         std::shared_ptr<diff_query> request = std::make_shared<diff_query>();
                                         request->user = this->user;
                                         request->partial = true;
+                                        request->slot = this->slot;
                                         request->subresult = tracker;
                                         request->VecData = result;
                                         result.clear();
@@ -444,6 +453,12 @@ void diff_query::Lists()
 }
 
 
+void diff_query::Stripes(std::vector<size_t>& locked)
+{
+       QueryBase::Stripes(locked);
+       locked.push_back(KeyLocks::Stripe(this->database, this->select_query, this->value));
+}
+
 void diff_query::Run()
 {
     if (this->identified == INT_KEY)
@@ -20,91 +20,36 @@ void future_list_query::Run()
 {
        unsigned int total_counter = 0;
        
-       rocksdb::Iterator* it = this->database->GetAddress()->NewIterator(rocksdb::ReadOptions());
-       
-       for (it->SeekToFirst(); it->Valid(); it->Next()) 
+       const std::string& prefix = to_prefix(INT_FUTURE);
+       std::unique_ptr<rocksdb::Iterator> it = this->Scan(prefix);
+
+       for (; it->Valid() && it->key().starts_with(prefix); it->Next())
        {
                 if (!Dispatcher::CheckIterator(this))
                 {
                        return;
                 }
 
-                std::string key_as_string;
-                std::string select_as_string;
-                std::string db_name;
                 std::string rawmap = it->key().ToString();
-                engine::colon_node_stream stream(rawmap);
-                
-                std::string token;
-                unsigned int strcounter = 0;
-                bool skip = false;
-                
-                while (stream.items_extract(token))
+                KeyData parsed;
+
+                if (!from_dest(rawmap, parsed))
                 {
-                        if (skip)
-                        {
-                             break;
-                        }
-                        
-                        switch (strcounter)
-                        {
-                             case 0:
-                             {
-                                  key_as_string = to_string(token);
-                             }
-
-                             break;
-
-                             case 1:
-                             {
-                                  select_as_string = token;    
-                             }
-
-                             break;
-                             
-                             case 3:
-                             {
-                                  db_name = token;
-                                  
-                                  if (db_name.empty() || db_name != this->database->GetName())
-                                  {
-                                       continue;
-                                  }
-                             }
-                             
-                             break;
-                             
-                             case 2:
-                             {
-                                   if (token != INT_FUTURE)
-                                   {
-                                           skip = true;
-                                   }
-                             }
-                             
-                             default:
-                             {
-                                      break;
-                             }
-                        }
-                        
-                        strcounter++;
+                        continue;
                 }
+
+                std::string path2;
+                std::string file2;
                 
-                if (skip)
+                if (!from_pair(it->value().ToString(), path2, file2))
                 {
+                        this->Delete(rawmap);
                         continue;
                 }
                 
-                std::string rawvalue = it->value().ToString();
-                
-                size_t found2 =  rawvalue.find_first_of(":");
-                std::string path2 = rawvalue.substr(0,found2);
-                std::string file2 = rawvalue.substr(found2+1);
-                
                 if (Kernel->Config->KeepFutures)
                 {
-                     Kernel->Store->Futures->Add(this->database, convto_num<signed int>(path2), key_as_string, file2, convto_num<unsigned int>(select_as_string), true);
+                     Kernel->Store->Futures->Add(this->database, convto_num<signed int>(path2), parsed.key, file2, parsed.select, true);
                      total_counter++;
                 }
                 else
@@ -157,19 +102,20 @@ void expire_query::Process()
 
 void future_exec_query::Run()
 {
-      std::string lookup = to_bin(this->key) + ":" + convto_string(this->select_query) + ":" + INT_FUTURE + ":" + this->database->GetName();
+      std::string lookup = to_dest(this->key, this->select_query, INT_FUTURE);
       std::string dbvalue;
-      rocksdb::Status fstatus = this->database->GetAddress()->Get(rocksdb::ReadOptions(), lookup, &dbvalue);       
+      rocksdb::Status fstatus = this->Read(lookup, &dbvalue);       
       
       if (fstatus.ok())
       {
-             size_t found2 =  dbvalue.find_first_of(":");
-             std::string path2 = dbvalue.substr(0,found2);
-             std::string file2 = dbvalue.substr(found2+1);
+             std::string path2;
+             std::string file2;
+             
+             from_pair(dbvalue, path2, file2);
              
              this->SetDest(this->key, this->select_query, INT_KEY);
              
-             if (!this->Write(this->dest, to_bin(file2)))
+             if (!this->Write(this->dest, to_value(file2)))
              {
                      this->DelFuture();
                      access_set(DBL_UNABLE_WRITE);
@@ -192,9 +138,9 @@ void future_exec_query::Process()
 
 void future_del_query::Run()
 {
-      std::string lookup = to_bin(this->key) + ":" + convto_string(this->select_query) + ":" + INT_FUTURE + ":" + this->database->GetName();
+      std::string lookup = to_dest(this->key, this->select_query, INT_FUTURE);
       std::string dbvalue;
-      rocksdb::Status fstatus = this->database->GetAddress()->Get(rocksdb::ReadOptions(), lookup, &dbvalue);       
+      rocksdb::Status fstatus = this->Read(lookup, &dbvalue);       
       
       if (fstatus.ok())
       {
@@ -20,70 +20,98 @@
 
 std::mutex ExpireManager::mute;
 
-ExpireManager::ExpireManager()
+ExpireManager::ExpireManager() : clock(0)
 {
 
 }
 
-bool ExpireManager::Delete(std::shared_ptr<Database> database, const std::string& key, unsigned int select)
+void ExpireManager::Start(time_t now)
 {
-        const ExpireMap& all = Kernel->Store->Expires->GetExpires();
+        if (!this->clock)
+        {
+                this->clock = now - 1;
+        }
+}
 
-        /* Nothing to delete, at all. */
+void ExpireManager::Place(const ExpireEntry& entry)
+{
+        ExpirePosition position;
+        position.level = 0;
+        
+        /* Next second to run, passed schedules run on it. */
+        
+        const time_t next = this->clock + 1;
+        const time_t target = std::max(static_cast<time_t>(entry.schedule), next);
+        
+        /* Lowest level in which target and next second share their upper bits. */
         
-        if (!all.size())
+        while (position.level < WHEEL_LEVELS - 1 && ((target ^ next) >> (WHEEL_BITS * (position.level + 1))) != 0)
         {
-                return false;
+                position.level++;
         }
+        
+        position.slot = (target >> (WHEEL_BITS * position.level)) & (WHEEL_SLOTS - 1);
+        
+        ExpireSlot& slot = this->wheel[position.level][position.slot];
+        position.entry = slot.insert(slot.end(), entry);
+        
+        this->index[ExpireKey(entry.database.get(), entry.select, entry.key)] = position;
+}
 
-        std::lock_guard<std::mutex> lg(ExpireManager::mute);
+void ExpireManager::Unlink(ExpireIndex::iterator it)
+{
+        const ExpirePosition& position = it->second;
+        
+        this->wheel[position.level][position.slot].erase(position.entry);
+        this->index.erase(it);
+}
 
-        for (ExpireMap::const_iterator it = all.begin(); it != all.end(); )
+void ExpireManager::Cascade(unsigned int level, unsigned int slot)
+{
+        ExpireSlot moving;
+        moving.swap(this->wheel[level][slot]);
+        
+        for (ExpireSlot::const_iterator it = moving.begin(); it != moving.end(); ++it)
         {
-                if (it->second.key != key)
-                {
-                       it++;
-                       continue;
-                }
-                
-                if (it->second.select != select)
-                {
-                       it++;
-                       continue;
-                }
-                
-                if (it->second.database != database)
-                {
-                       it++;
-                       continue;
-                }
-
-                Kernel->Store->Expires->ExpireList.erase(it);
-                return true;
+                this->Place(*it);
         }
+}
 
-        /* Key not found. */
+bool ExpireManager::Delete(std::shared_ptr<Database> database, const std::string& key, unsigned int select)
+{
+        ExpireManager& manager = Kernel->Store->Expires;
+        
+        std::lock_guard<std::mutex> lg(ExpireManager::mute);
 
-        return false;
+        ExpireIndex::iterator it = manager.index.find(ExpireKey(database.get(), select, key));
+        
+        /* Key not found. */
+        
+        if (it == manager.index.end())
+        {
+                return false;
+        }
+        
+        manager.Unlink(it);
+        return true;
 }
 
 signed int ExpireManager::GetTIME(std::shared_ptr<Database> database, const std::string& key, unsigned int select)
 {
-        const ExpireMap& expires = Kernel->Store->Expires->GetExpires();
+        ExpireManager& manager = Kernel->Store->Expires;
 
         std::lock_guard<std::mutex> lg(ExpireManager::mute);
 
-        for (ExpireMap::const_iterator it = expires.begin(); it != expires.end(); it++)
-        {
-                        if (it->second.key == key && it->second.select == select && it->second.database == database)
-                        {
-                                return it->first;
-                        }
-        }
+        ExpireIndex::const_iterator it = manager.index.find(ExpireKey(database.get(), select, key));
 
         /* Not found, not expiring. */
 
-        return -1;
+        if (it == manager.index.end())
+        {
+                return -1;
+        }
+        
+        return it->second.entry->schedule;
 }
 
 signed int ExpireManager::Add(std::shared_ptr<Database> database, signed int schedule, const std::string& key, unsigned int select, bool epoch)
@@ -93,16 +121,20 @@ signed int ExpireManager::Add(std::shared_ptr<Database> database, signed int sch
                 return -1;
         }
         
+        std::lock_guard<std::mutex> lg(ExpireManager::mute);
+        
+        time_t Now = Kernel->Now();
+        this->Start(Now);
+        
         /* If entry already exists, we remove it and insert it again. */
         
-        if (ExpireManager::GetTIME(database, key, select) > 0)
+        ExpireIndex::iterator it = this->index.find(ExpireKey(database.get(), select, key));
+        
+        if (it != this->index.end())
         {
-              ExpireManager::Delete(database, key, select);
+              this->Unlink(it);
         }
         
-        std::lock_guard<std::mutex> lg(ExpireManager::mute);
-        
-        time_t Now = Kernel->Now();
         ExpireEntry New;
         
         New.epoch = epoch;
@@ -122,78 +154,158 @@ signed int ExpireManager::Add(std::shared_ptr<Database> database, signed int sch
         New.secs 	= schedule;
         New.select 	= select;
         
-        Kernel->Store->Expires->ExpireList.insert(std::make_pair(New.schedule, New));
-        
-        //bprint(DONE, "Adding expire to %s (%s): %s", database->GetName().c_str(), key.c_str(), select.c_str());
+        this->Place(New);
         return New.schedule;
 }
 
 ExpireEntry ExpireManager::Find(std::shared_ptr<Database> database, const std::string& key, unsigned int select)
 {
-        ExpireMap& current = Kernel->Store->Expires->GetExpires();
+        std::lock_guard<std::mutex> lg(ExpireManager::mute);
 
-        for (ExpireMap::iterator it = current.begin(); it != current.end(); it++)
-        {
-                        if (it->second.key == key && it->second.select == select && it->second.database == database)
-                        {
-                                return it->second;
-                        }
-        }
+        ExpireIndex::const_iterator it = this->index.find(ExpireKey(database.get(), select, key));
 
         /* Not found, not expiring. */
 
-        throw KernelException("ne");
+        if (it == this->index.end())
+        {
+                throw KernelException("ne");
+        }
+        
+        return *it->second.entry;
 }
 
-ExpireMap& ExpireManager::GetExpires()
+ExpireMap ExpireManager::GetExpires()
 {
        std::lock_guard<std::mutex> lg(ExpireManager::mute);
-       return this->ExpireList;
+       
+       ExpireMap expires;
+       
+       for (ExpireIndex::const_iterator it = this->index.begin(); it != this->index.end(); ++it)
+       {
+              expires.insert(std::make_pair(it->second.entry->schedule, *it->second.entry));
+       }
+       
+       return expires;
 }
 
 void ExpireManager::Flush(time_t TIME)
 {
-        /* 
-         * Considering that Flush is an static function, this is the only 
-         * valid to get expiring entries. 
-         */
-           
-        ExpireMap& expiring = Kernel->Store->Expires->GetExpires();
-
-        if (!expiring.size())
+        std::vector<ExpireEntry> due;
+        
+        {
+              std::lock_guard<std::mutex> lg(ExpireManager::mute);
+              
+              if (this->index.empty())
+              {
+                     this->clock = std::max(this->clock, TIME - 1);
+                     return;
+              }
+              
+              if (TIME - this->clock > static_cast<time_t>(WHEEL_SLOTS * WHEEL_SLOTS))
+              {
+                     /* Too far behind (ie: clock changed), walking every second is slower than rebuilding. */
+                     
+                     std::vector<ExpireEntry> all;
+                     
+                     for (ExpireIndex::const_iterator it = this->index.begin(); it != this->index.end(); ++it)
+                     {
+                            all.push_back(*it->second.entry);
+                     }
+                     
+                     for (unsigned int level = 0; level < WHEEL_LEVELS; level++)
+                     {
+                            for (unsigned int slot = 0; slot < WHEEL_SLOTS; slot++)
+                            {
+                                   this->wheel[level][slot].clear();
+                            }
+                     }
+                     
+                     this->index.clear();
+                     this->clock = TIME - 1;
+                     
+                     for (std::vector<ExpireEntry>::const_iterator it = all.begin(); it != all.end(); ++it)
+                     {
+                            if (it->schedule < TIME)
+                            {
+                                   due.push_back(*it);
+                            }
+                            else
+                            {
+                                   this->Place(*it);
+                            }
+                     }
+              }
+              
+              /* Entries scheduled at second t run once TIME is past t. */
+              
+              for (time_t t = this->clock + 1; t < TIME; t++)
+              {
+                     /* Upper levels move down as their slot comes up, highest first. */
+                     
+                     unsigned int levels = 0;
+                     
+                     while (levels < WHEEL_LEVELS - 1 && !(t & ((static_cast<time_t>(1) << (WHEEL_BITS * (levels + 1))) - 1)))
+                     {
+                            levels++;
+                     }
+                     
+                     for (unsigned int level = levels; level > 0; level--)
+                     {
+                            this->Cascade(level, (t >> (WHEEL_BITS * level)) & (WHEEL_SLOTS - 1));
+                     }
+                     
+                     ExpireSlot& slot = this->wheel[0][t & (WHEEL_SLOTS - 1)];
+                     
+                     for (ExpireSlot::const_iterator it = slot.begin(); it != slot.end(); ++it)
+                     {
+                            due.push_back(*it);
+                            this->index.erase(ExpireKey(it->database.get(), it->select, it->key));
+                     }
+                     
+                     slot.clear();
+                     this->clock = t;
+              }
+        }
+        
+        if (due.empty())
         {
               return;
         }
         
-        for (ExpireMap::iterator it = expiring.begin(); it != expiring.end(); )
+        /* Deletes are grouped per database, so every batch is a single commit. */
+        
+        std::map<Database*, std::pair<std::shared_ptr<Database>, std::vector<std::pair<unsigned int, std::string>>>> pending;
+        
+        for (std::vector<ExpireEntry>::const_iterator it = due.begin(); it != due.end(); ++it)
         {
-              if (it->first >= TIME)
-              {
-                      break;
-              }
+              std::pair<std::shared_ptr<Database>, std::vector<std::pair<unsigned int, std::string>>>& batch = pending[it->database.get()];
               
-              ExpireEntry entry = it->second;
-              GlobalHelper::ExpireDelete(entry.database, entry.select, entry.key);
+              batch.first = it->database;
+              batch.second.push_back(std::make_pair(it->select, it->key));
               
-              it++;
-        }  
+              if (batch.second.size() >= EXPIRE_BATCH)
+              {
+                     GlobalHelper::ExpireBatch(batch.first, batch.second);
+                     batch.second.clear();
+              }
+        }
+        
+        for (std::map<Database*, std::pair<std::shared_ptr<Database>, std::vector<std::pair<unsigned int, std::string>>>>::iterator it = pending.begin(); it != pending.end(); ++it)
+        {
+              if (!it->second.second.empty())
+              {
+                     GlobalHelper::ExpireBatch(it->second.first, it->second.second);
+              }
+        }
 }
 
 signed int ExpireManager::GetTTL(std::shared_ptr<Database> database, const std::string& key, unsigned int select)
 {
-      std::lock_guard<std::mutex> lg(ExpireManager::mute);
       return ExpireManager::GetTIME(database, key, select);
 }
 
 void ExpireManager::PreDBClose(const std::string& dbname)
 {
-      ExpireMap& expiring = Kernel->Store->Expires->GetExpires();
-
-      if (!expiring.size())
-      {
-              return;
-      }
-
       std::shared_ptr<UserDatabase> database = Kernel->Store->DBM->Find(dbname);
 
       if (!database)
@@ -201,29 +313,24 @@ void ExpireManager::PreDBClose(const std::string& dbname)
            return;
       }
 
+      ExpireManager& manager = Kernel->Store->Expires;
+
       std::lock_guard<std::mutex> lg(ExpireManager::mute);
 
-      for (ExpireMap::iterator it = expiring.begin(); it != expiring.end(); )
+      for (ExpireIndex::iterator it = manager.index.begin(); it != manager.index.end(); )
       {
-                if (it->second.database != database)
+                if (it->first.database != database.get())
                 {
                        it++;
                        continue;
                 }
 
-                Kernel->Store->Expires->ExpireList.erase(it++);
+                manager.Unlink(it++);
       }
 }
 
 unsigned int ExpireManager::DatabaseReset(const std::string& dbname)
 {
-      ExpireMap& expiring = Kernel->Store->Expires->GetExpires();
-
-      if (!expiring.size())
-      {
-              return 0;
-      }
-
       unsigned int counter = 0;
 
       std::shared_ptr<UserDatabase> database = Kernel->Store->DBM->Find(dbname);
@@ -233,18 +340,18 @@ unsigned int ExpireManager::DatabaseReset(const std::string& dbname)
            return 0;
       }
 
+      ExpireManager& manager = Kernel->Store->Expires;
+
       std::lock_guard<std::mutex> lg(ExpireManager::mute);
       
-      for (ExpireMap::iterator it = expiring.begin(); it != expiring.end(); )
+      for (ExpireIndex::const_iterator it = manager.index.begin(); it != manager.index.end(); it++)
       {
-            if (it->second.database == database)
+            if (it->first.database == database.get())
             {
-                       ExpireEntry entry = it->second;
+                       const ExpireEntry& entry = *it->second.entry;
                        ExpireHelper::Persist(Kernel->Clients->Global, entry.key, entry.select, entry.database);
                        counter++;
             }
-
-            it++;
       }  
       
       return counter;
@@ -252,13 +359,6 @@ unsigned int ExpireManager::DatabaseReset(const std::string& dbname)
 
 void ExpireManager::DatabaseDestroy(const std::string& dbname)
 {
-      ExpireMap& expiring = Kernel->Store->Expires->GetExpires();
-
-      if (!expiring.size())
-      {
-              return;
-      }
-
       std::shared_ptr<UserDatabase> database = Kernel->Store->DBM->Find(dbname);
 
       if (!database)
@@ -268,11 +368,11 @@ void ExpireManager::DatabaseDestroy(const std::string& dbname)
 
       std::lock_guard<std::mutex> lg(ExpireManager::mute);
 
-      for (ExpireMap::iterator it = expiring.begin(); it != expiring.end(); )
+      for (ExpireIndex::iterator it = this->index.begin(); it != this->index.end(); )
       {
-            if (it->second.database == database)
+            if (it->first.database == database.get())
             {
-                    expiring.erase(it++);
+                    this->Unlink(it++);
                     continue;
             }
 
@@ -286,13 +386,6 @@ unsigned int ExpireManager::SelectReset(const std::string& dbname, unsigned int
       
       unsigned int counter = 0;
 
-      ExpireMap& expiring = Kernel->Store->Expires->GetExpires();
-
-      if (!expiring.size())
-      {
-              return 0;
-      }
-
       std::shared_ptr<UserDatabase> database = Kernel->Store->DBM->Find(dbname);
 
       if (!database)
@@ -300,13 +393,15 @@ unsigned int ExpireManager::SelectReset(const std::string& dbname, unsigned int
             return 0;
       }
 
+      ExpireManager& manager = Kernel->Store->Expires;
+
       std::lock_guard<std::mutex> lg(ExpireManager::mute);
 
-      for (ExpireMap::iterator it = expiring.begin(); it != expiring.end(); it++)
+      for (ExpireIndex::const_iterator it = manager.index.begin(); it != manager.index.end(); it++)
       {
-            if (it->second.select == select && it->second.database == database)
+            if (it->first.select == select && it->first.database == database.get())
             {
-                       ExpireEntry entry = it->second;
+                       const ExpireEntry& entry = *it->second.entry;
                        ExpireHelper::Persist(Kernel->Clients->Global, entry.key, entry.select, entry.database);
                        counter++;
             }
@@ -317,26 +412,19 @@ unsigned int ExpireManager::SelectReset(const std::string& dbname, unsigned int
 
 void ExpireManager::Reset()
 {
-      ExpireMap& expiring = Kernel->Store->Expires->GetExpires();
-
-      if (!expiring.size())
-      {
-              return;
-      }
+      ExpireManager& manager = Kernel->Store->Expires;
 
       std::lock_guard<std::mutex> lg(ExpireManager::mute);
 
-      for (ExpireMap::iterator it = expiring.begin(); it != expiring.end(); it++)
+      for (ExpireIndex::const_iterator it = manager.index.begin(); it != manager.index.end(); it++)
       {
-              ExpireEntry entry = it->second;
+              const ExpireEntry& entry = *it->second.entry;
               ExpireHelper::Persist(Kernel->Clients->Global, entry.key, entry.select, entry.database);
       }  
 }
 
 unsigned int ExpireManager::Count(const std::string& dbname, unsigned int select)
 {
-        ExpireMap& expires = Kernel->Store->Expires->GetExpires();
-        
         std::shared_ptr<UserDatabase> database = Kernel->Store->DBM->Find(dbname);
 
         if (!database)
@@ -344,15 +432,13 @@ unsigned int ExpireManager::Count(const std::string& dbname, unsigned int select
               return 0;
         }
 
-       std::lock_guard<std::mutex> lg(ExpireManager::mute);
+        std::lock_guard<std::mutex> lg(ExpireManager::mute);
         
         unsigned int counter = 0;
 
-        for (ExpireMap::iterator it = expires.begin(); it != expires.end(); it++)
+        for (ExpireIndex::const_iterator it = this->index.begin(); it != this->index.end(); it++)
         {
-                ExpireEntry entry = it->second;
-
-                if (entry.select == select && entry.database == database)       
+                if (it->first.select == select && it->first.database == database.get())       
                 {
                        counter++;
                 }
@@ -360,5 +446,3 @@ unsigned int ExpireManager::Count(const std::string& dbname, unsigned int select
         
         return counter;
 }
-        
-        
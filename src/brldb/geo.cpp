@@ -26,7 +26,7 @@ void geoaddnx_query::Run()
           return;
      }
      
-     const std::string& save = to_bin(this->hesh) + ":" + to_bin(this->value);
+     const std::string& save = to_pair(this->hesh, this->value);
 
      if (this->Write(this->dest, save))
      {
@@ -47,7 +47,7 @@ void geoaddnx_query::Process()
 
 void geoadd_query::Run()
 {
-     const std::string& save = to_bin(this->hesh) + ":" + to_bin(this->value);
+     const std::string& save = to_pair(this->hesh, this->value);
      
      if (this->Write(this->dest, save))
      {
@@ -66,7 +66,7 @@ void geoadd_query::Process()
 
 void geoadd_pub_query::Run()
 {
-     const std::string save = to_bin(this->value) + ":" + to_bin(this->hesh);
+     const std::string save = to_pair(this->value, this->hesh);
      
      if (this->Write(this->dest, save))
      {
@@ -107,12 +107,11 @@ void geoadd_pub_query::Process()
 void geoget_query::Run()
 {
       RocksData result = this->Get(this->dest);
-      std::string dbvalue = result.value;
+      std::string path;
+      std::string file;
     
-      size_t found =  dbvalue.find_first_of(":");
-      const std::string& path = dbvalue.substr(0,found);
-      const std::string& file = dbvalue.substr(found+1);
-      this->response = to_string(path) + " " + to_string(file);
+      from_pair(result.value, path, file);
+      this->response = path + " " + file;
       this->SetOK();
 }
 
@@ -124,19 +123,18 @@ void geoget_query::Process()
 void geoget_custom_query::Run()
 {
       RocksData result = this->Get(this->dest);
-      std::string dbvalue = result.value;
+      std::string path;
+      std::string file;
 
-      size_t found =  dbvalue.find_first_of(":");
+      from_pair(result.value, path, file);
       
       if (this->type == QUERY_TYPE_LONG)
       {
-               const std::string& path = dbvalue.substr(0,found);
-               this->response = to_string(path);
+               this->response = path;
       }
       else
       {
-               const std::string& file = dbvalue.substr(found+1);
-               this->response = to_string(file);
+               this->response = file;
       }
 
       this->SetOK();
@@ -156,9 +154,10 @@ void gkeys_query::Run()
 
        std::string rawmap;
        
-       rocksdb::Iterator* it = this->database->GetAddress()->NewIterator(rocksdb::ReadOptions());
+       const std::string& prefix = to_prefix(this->select_query, INT_GEO);
+       std::unique_ptr<rocksdb::Iterator> it = this->Scan(prefix);
 
-       for (it->SeekToFirst(); it->Valid(); it->Next()) 
+       for (; it->Valid() && it->key().starts_with(prefix); it->Next())
        {
                 if (!Dispatcher::CheckIterator(this))
                 {
@@ -166,64 +165,16 @@ void gkeys_query::Run()
                 }
                 
                 rawmap = it->key().ToString();
-                engine::colon_node_stream stream(rawmap);
-                std::string token;
-                std::string key_as_string;
-                
-                unsigned int strcounter = 0;
-                bool skip = false;
-                
-                while (stream.items_extract(token))
-                {       
-                        if (skip)
-                        {
-                            break;
-                        }
-                        
-                        switch (strcounter)
-                        {
-                             case 0:
-                             {
-                                  key_as_string = to_string(token);
-                                
-                                  if (!Daemon::Match(key_as_string, this->key))
-                                  {
-                                       skip = true;
-                                  }
-                             }
-                             
-                             break;
-                             
-                             case 1:
-                             {
-                                   if (convto_string(this->select_query) != token)
-                                   {
-                                        skip = true;
-                                   }
-                             }
-                             
-                             break;
-                             
-                             case 2:
-                             {
-                                  if (token != INT_GEO)
-                                  {
-                                         skip = true;	
-                                  }
-                             }
-                             
-                             break;
-                             
-                             default:
-                             {
-                                 break;   
-                             }                                     
-                        }
-                        
-                        strcounter++;
+                KeyData parsed;
+
+                if (!from_dest(rawmap, parsed))
+                {
+                        continue;
                 }
-                
-                if (skip)
+
+                const std::string& key_as_string = parsed.key;
+
+                if (!Daemon::Match(key_as_string, this->key))
                 {
                         continue;
                 }
@@ -242,6 +193,7 @@ void gkeys_query::Run()
                                                 std::shared_ptr<gkeys_query> request = std::make_shared<gkeys_query>();
                                                 request->user = this->user;
                                                 request->partial = true;                                  
+                                                request->slot = this->slot;
                                                 request->subresult = tracker;
                                                 request->VecData = result;
                                                 result.clear();
@@ -266,6 +218,7 @@ void gkeys_query::Run()
                                         std::shared_ptr<gkeys_query> request = std::make_shared<gkeys_query>();
                                         request->user = this->user;
                                         request->partial = true;
+                                        request->slot = this->slot;
                                         request->subresult = tracker;
                                         request->VecData = result;
                                         result.clear();
@@ -277,6 +230,8 @@ void gkeys_query::Run()
                 total_counter++;
     }
 
+    this->EndPage(it.get(), prefix);
+
     this->subresult = ++tracker;
     this->partial = false;
     this->counter = aux_counter;
@@ -291,10 +246,10 @@ void gkeys_query::Process()
 
 void geocalc_query::Run()
 {
-        std::string first = to_bin(this->key) + ":" + convto_string(this->select_query) + ":" + this->base_request;
+        std::string first = to_dest(this->key, this->select_query, this->base_request);
 
         std::string dbvalue;
-        this->database->GetAddress()->Get(rocksdb::ReadOptions(), first, &dbvalue);
+        this->Read(first, &dbvalue);
     
         if (dbvalue.empty())
         {
@@ -302,10 +257,10 @@ void geocalc_query::Run()
                return;
         }
         
-        std::string second = to_bin(this->value) + ":" + convto_string(this->select_query) + ":" + this->base_request;
+        std::string second = to_dest(this->value, this->select_query, this->base_request);
         
         std::string dbvalue2;
-        this->database->GetAddress()->Get(rocksdb::ReadOptions(), second, &dbvalue2);
+        this->Read(second, &dbvalue2);
     
         if (dbvalue2.empty())
         {
@@ -313,15 +268,13 @@ void geocalc_query::Run()
                return;
         }
         
-        size_t found =  dbvalue.find_first_of(":");
-        std::string path = dbvalue.substr(0,found);
-        std::string file = dbvalue.substr(found+1);
+        std::string path, file;
+        std::string path2, file2;
         
-        size_t found2 =  dbvalue2.find_first_of(":");
-        std::string path2 = dbvalue2.substr(0,found2);
-        std::string file2 = dbvalue2.substr(found2+1);
+        from_pair(dbvalue, path, file);
+        from_pair(dbvalue2, path2, file2);
         
-        this->response = convto_string(CalculateDistance(convto_num<double>(to_string(path)), convto_num<double>(to_string(file)), convto_num<double>(to_string(path2)), convto_num<double>(to_string(file2))));
+        this->response = convto_string(CalculateDistance(convto_num<double>(path), convto_num<double>(file), convto_num<double>(path2), convto_num<double>(file2)));
         this->SetOK();
 }
 
@@ -332,7 +285,7 @@ void geocalc_query::Process()
 
 void geodistance_query::Run()
 {
-    std::string first = to_bin(this->key) + ":" + convto_string(this->select_query) + ":" + this->base_request;
+    std::string first = to_dest(this->key, this->select_query, this->base_request);
     
     StringVector result;
     
@@ -341,7 +294,7 @@ void geodistance_query::Run()
     unsigned int tracker = 0;
     std::string rawmap;
     std::string dbvalue;
-    rocksdb::Status fstatus2 = this->database->GetAddress()->Get(rocksdb::ReadOptions(), first, &dbvalue);
+    rocksdb::Status fstatus2 = this->Read(first, &dbvalue);
 
     if (dbvalue.empty())
     {
@@ -349,13 +302,13 @@ void geodistance_query::Run()
           return;
     }
     
-    size_t found1 =  dbvalue.find_first_of(":");
-    std::string path1 = dbvalue.substr(0,found1);
-    std::string file1 = dbvalue.substr(found1+1);
+    std::string path1, file1;
+    from_pair(dbvalue, path1, file1);
     
-    rocksdb::Iterator* it = this->database->GetAddress()->NewIterator(rocksdb::ReadOptions());
+    const std::string& prefix = to_prefix(this->select_query, INT_GEO);
+    std::unique_ptr<rocksdb::Iterator> it = this->Scan(prefix);
 
-    for (it->SeekToFirst(); it->Valid(); it->Next()) 
+    for (; it->Valid() && it->key().starts_with(prefix); it->Next())
     {
                 if (!Dispatcher::CheckIterator(this))
                 {
@@ -363,75 +316,28 @@ void geodistance_query::Run()
                 }
                 
                 rawmap = it->key().ToString();
-                engine::colon_node_stream stream(rawmap);
-                std::string token;
-                std::string key_as_string;
-
-                unsigned int strcounter = 0;
-                bool skip = false;
+                KeyData parsed;
 
-                while (stream.items_extract(token))
+                if (!from_dest(rawmap, parsed))
                 {
-                        if (skip)
-                        {
-                            break;
-                        }
-                        
-                        switch (strcounter)
-                        {
-                             case 0:
-                             {
-                                  key_as_string = to_string(token);
-
-                                  if (key_as_string == this->key)
-                                  {
-                                       skip = true;
-                                  }
-                             }
-
-                             break;
-
-                             case 1:
-                             {
-                                   if (convto_string(this->select_query) != token)
-                                   {
-                                        skip = true;
-                                   }
-                             }
-
-                             break;
-
-                             case 2:
-                             {
-                                  if (token != INT_GEO)
-                                  {
-                                         skip = true;   
-                                  }
-                             }
-                             
-                             break;
-
-                             default:
-                             {
-                                 break;   
-                             }
-                        }
-
-                        strcounter++;
+                        continue;
                 }
 
-                if (skip)
+                const std::string& key_as_string = parsed.key;
+
+                if (key_as_string == this->key)
                 {
                         continue;
                 }
 
-                std::string rawvalue = it->value().ToString();
+                std::string path2, file2;
                 
-                size_t found2 =  rawvalue.find_first_of(":");
-                std::string path2 = rawvalue.substr(0,found2);
-                std::string file2 = rawvalue.substr(found2+1);
+                if (!from_pair(it->value().ToString(), path2, file2))
+                {
+                        continue;
+                }
 
-                double distance = CalculateDistance(convto_num<double>(to_string(path1)), convto_num<double>(to_string(file1)), convto_num<double>(to_string(path2)), convto_num<double>(to_string(file2)));
+                double distance = CalculateDistance(convto_num<double>(path1), convto_num<double>(file1), convto_num<double>(path2), convto_num<double>(file2));
             
                 if (distance <= convto_num<double>(this->value))
                 {
@@ -452,6 +358,7 @@ void geodistance_query::Run()
                                                 std::shared_ptr<geodistance_query> request = std::make_shared<geodistance_query>();
                                                 request->user = this->user;
                                                 request->partial = true;                                  
+                                                request->slot = this->slot;
                                                 request->subresult = tracker;
                                                 request->VecData = result;
                                                 result.clear();
@@ -476,6 +383,7 @@ void geodistance_query::Run()
                                         std::shared_ptr<geodistance_query> request = std::make_shared<geodistance_query>();
                                         request->user = this->user;
                                         request->partial = true;
+                                        request->slot = this->slot;
                                         request->subresult = tracker;
                                         request->VecData = result;
                                         result.clear();
@@ -517,14 +425,14 @@ void geodistance_query::Process()
 
 void georem_query::Run()
 {
-    std::string first = to_bin(this->key) + ":" + convto_string(this->select_query) + ":" + this->base_request;
+    std::string first = to_dest(this->key, this->select_query, this->base_request);
     
     StringVector result;
     
     unsigned int total_counter = 0;
 
     std::string dbvalue;
-    rocksdb::Status fstatus2 = this->database->GetAddress()->Get(rocksdb::ReadOptions(), first, &dbvalue);
+    rocksdb::Status fstatus2 = this->Read(first, &dbvalue);
 
     if (dbvalue.empty())
     {
@@ -532,13 +440,13 @@ void georem_query::Run()
           return;
     }
     
-    size_t found1 =  dbvalue.find_first_of(":");
-    std::string path1 = dbvalue.substr(0,found1);
-    std::string file1 = dbvalue.substr(found1+1);
+    std::string path1, file1;
+    from_pair(dbvalue, path1, file1);
     
-    rocksdb::Iterator* it = this->database->GetAddress()->NewIterator(rocksdb::ReadOptions());
+    const std::string& prefix = to_prefix(this->select_query, INT_GEO);
+    std::unique_ptr<rocksdb::Iterator> it = this->Scan(prefix);
 
-    for (it->SeekToFirst(); it->Valid(); it->Next()) 
+    for (; it->Valid() && it->key().starts_with(prefix); it->Next())
     {
                 if (!Dispatcher::CheckIterator(this))
                 {
@@ -546,75 +454,28 @@ void georem_query::Run()
                 }
                 
                 std::string rawmap = it->key().ToString();
-                engine::colon_node_stream stream(rawmap);
-                std::string token;
-                std::string key_as_string;
-
-                unsigned int strcounter = 0;
-                bool skip = false;
+                KeyData parsed;
 
-                while (stream.items_extract(token))
+                if (!from_dest(rawmap, parsed))
                 {
-                        if (skip)
-                        {
-                            break;
-                        }
-                        
-                        switch (strcounter)
-                        {
-                             case 0:
-                             {
-                                  key_as_string = to_string(token);
-                                  
-                                  if (key_as_string == this->key)
-                                  {
-                                       continue;
-                                  }
-                             }
-
-                             break;
-
-                             case 1:
-                             {
-                                   if (convto_string(this->select_query) != token)
-                                   {
-                                        skip = true;
-                                   }
-                             }
-
-                             break;
-
-                             case 2:
-                             {
-                                  if (token != INT_GEO)
-                                  {
-                                         skip = true;   
-                                  }
-                             }
-                             
-                             break;
+                        continue;
+                }
 
-                             default:
-                             {
-                                 break;   
-                             }
-                        }
+                const std::string& key_as_string = parsed.key;
 
-                        strcounter++;
+                if (key_as_string == this->key)
+                {
+                        continue;
                 }
 
-                if (skip)
+                std::string path2, file2;
+                
+                if (!from_pair(it->value().ToString(), path2, file2))
                 {
                         continue;
                 }
 
-                std::string rawvalue = it->value().ToString();
-     
-                size_t found2 =  rawvalue.find_first_of(":");
-                std::string path2 = rawvalue.substr(0,found2);
-                std::string file2 = rawvalue.substr(found2+1);
-
-                double distance = CalculateDistance(convto_num<double>(to_string(path1)), convto_num<double>(to_string(file1)), convto_num<double>(to_string(path2)), convto_num<double>(to_string(file2)));
+                double distance = CalculateDistance(convto_num<double>(path1), convto_num<double>(file1), convto_num<double>(path2), convto_num<double>(file2));
                 
                 if (distance >= convto_num<double>(this->value))
                 {
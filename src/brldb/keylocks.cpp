@@ -0,0 +1,79 @@
+/*
+ * BerylDB - A lightweight database.
+ * http://www.beryldb.com
+ *
+ * Copyright (C) 2021 - Carlos F. Ferry <cferry@beryldb.com>
+ *
+ * This file is part of BerylDB. BerylDB is free software: you can
+ * redistribute it and/or modify it under the terms of the BSD License
+ * version 3.
+ *
+ * More information about our licensing can be found at https://docs.beryl.dev
+ */
+
+#include <algorithm>
+#include <functional>
+
+#include "beryl.h"
+#include "brldb/keylocks.h"
+
+std::mutex KeyLocks::stripes[KEY_STRIPES];
+
+std::atomic<uint64_t> KeyLocks::versions[KEY_STRIPES];
+
+size_t KeyLocks::Stripe(const std::shared_ptr<Database>& database, unsigned int select, const std::string& key)
+{
+        size_t seed = std::hash<std::string>()(key);
+
+        seed ^= std::hash<unsigned int>()(select) + 0x9e3779b9 + (seed << 6) + (seed >> 2);
+        seed ^= std::hash<Database*>()(database.get()) + 0x9e3779b9 + (seed << 6) + (seed >> 2);
+
+        return seed % KEY_STRIPES;
+}
+
+void KeyLocks::All(std::vector<size_t>& locked)
+{
+        locked.reserve(locked.size() + KEY_STRIPES);
+
+        for (size_t i = 0; i < KEY_STRIPES; ++i)
+        {
+                locked.push_back(i);
+        }
+}
+
+void KeyLocks::Lock(std::vector<size_t>& locked)
+{
+        std::sort(locked.begin(), locked.end());
+        locked.erase(std::unique(locked.begin(), locked.end()), locked.end());
+
+        for (std::vector<size_t>::const_iterator i = locked.begin(); i != locked.end(); ++i)
+        {
+                KeyLocks::stripes[*i].lock();
+        }
+}
+
+void KeyLocks::Unlock(const std::vector<size_t>& locked)
+{
+        for (std::vector<size_t>::const_reverse_iterator i = locked.rbegin(); i != locked.rend(); ++i)
+        {
+                KeyLocks::stripes[*i].unlock();
+        }
+}
+
+void KeyLocks::Bump(const std::vector<size_t>& written)
+{
+        if (written.empty())
+        {
+                for (size_t i = 0; i < KEY_STRIPES; ++i)
+                {
+                        KeyLocks::versions[i].fetch_add(1, std::memory_order_release);
+                }
+                
+                return;
+        }
+
+        for (std::vector<size_t>::const_iterator i = written.begin(); i != written.end(); ++i)
+        {
+                KeyLocks::versions[*i].fetch_add(1, std::memory_order_release);
+        }
+}
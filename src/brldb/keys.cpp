@@ -17,101 +17,59 @@
 
 #include "brldb/expires.h"
 #include "brldb/functions.h"
+#include "brldb/keylocks.h"
 
 void expire_list_query::Run()
 {
        unsigned int total_counter = 0;
 
-       rocksdb::Iterator* it = this->database->GetAddress()->NewIterator(rocksdb::ReadOptions());
-       
-       for (it->SeekToFirst(); it->Valid(); it->Next()) 
+       const std::string& prefix = to_prefix(INT_EXPIRE);
+       std::unique_ptr<rocksdb::Iterator> it = this->Scan(prefix);
+
+       for (; it->Valid() && it->key().starts_with(prefix); it->Next())
        {
                 if (!Dispatcher::CheckIterator(this))
                 {
                        return;
                 }
 
-                std::string key_as_string;
-                std::string key_as_bin;
-                std::string select_as_string;
-                std::string db_name;
                 std::string rawmap = it->key().ToString();
-                engine::colon_node_stream stream(rawmap);
-                
-                std::string token;
-                unsigned int strcounter = 0;
-                bool skip = false;
-                
-                while (stream.items_extract(token))
-                {
-                        if (skip)
-                        {
-                             break;
-                        }
-                        
-                        switch (strcounter)
-                        {
-                             case 0:
-                             {
-                                  key_as_string = to_string(token);
-                                  key_as_bin = token;
-                             }
+                KeyData parsed;
 
-                             break;
+                if (!from_dest(rawmap, parsed))
+                {
+                        continue;
+                }
 
-                             case 1:
-                             {
-                                  select_as_string = token;    
-                             }
+                double ttl = 0;
 
-                             break;
-                             
-                             case 3:
-                             {
-                                  db_name = token;
-                                  
-                                  if (db_name.empty() || db_name != this->database->GetName())
-                                  {
-                                       skip = true;
-                                  }
-                             }
-                             
-                             break;
-                             
-                             case 2:
-                             {
-                                   if (token != INT_EXPIRE)
-                                   {
-                                           skip = true;
-                                   }
-                             }
-                             
-                             break;
-                             
-                             default:
-                             {
-                                      break;
-                             }
-                        }
-                        
-                        strcounter++;
-                }
-                
-                if (skip)
+                if (!from_number_value(it->value().ToString(), ttl))
                 {
+                        this->Delete(rawmap);
                         continue;
                 }
-
-                std::string rawvalue = it->value().ToString();
                 
                 if (Kernel->Config->KeepExpires)
                 {
-                     Kernel->Store->Expires->Add(this->database, convto_num<signed int>(rawvalue), key_as_string, convto_num<unsigned int>(select_as_string), true);
+                     Kernel->Store->Expires->Add(this->database, static_cast<signed int>(ttl), parsed.key, parsed.select, true);
                      total_counter++;
                 }
                 else
                 {
-                     this->Delete(rawmap);
+                     /* Keys no longer expire, so they drop their deadline too. */
+                     
+                     rocksdb::WriteBatch batch;
+                     batch.Delete(rawmap);
+                     
+                     const std::string& entry = to_dest(parsed.key, parsed.select, INT_KEY);
+                     std::string stored;
+                     
+                     if (this->Read(entry, &stored).ok() && value_deadline(stored))
+                     {
+                           batch.Put(entry, strip_deadline(stored));
+                     }
+                     
+                     this->Commit(batch);
                 }
         }
         
@@ -164,9 +122,89 @@ void expire_del_query::Process()
         }
 }
 
+void expire_batch_query::Stripes(std::vector<size_t>& locked)
+{
+      for (std::vector<std::pair<unsigned int, std::string>>::const_iterator i = this->due.begin(); i != this->due.end(); ++i)
+      {
+             locked.push_back(KeyLocks::Stripe(this->database, i->first, i->second));
+      }
+}
+
+void expire_batch_query::Run()
+{
+      StringVector lookups;
+      
+      for (std::vector<std::pair<unsigned int, std::string>>::const_iterator i = this->due.begin(); i != this->due.end(); ++i)
+      {
+             lookups.push_back(to_dest(i->second, i->first, INT_EXPIRE));
+             lookups.push_back(to_dest(i->second, i->first, INT_REG));
+             lookups.push_back(to_dest(i->second, i->first, INT_KEY));
+      }
+      
+      StringVector values;
+      std::vector<rocksdb::Status> statuses;
+      
+      this->ReadMany(lookups, values, statuses);
+      
+      const time_t Now = Kernel->Now();
+      rocksdb::WriteBatch batch;
+      
+      for (size_t i = 0; i < this->due.size(); ++i)
+      {
+             const size_t record = i * 3;
+             const size_t reg = record + 1;
+             const size_t entry = record + 2;
+             
+             double schedule = 0;
+             const bool passed = (statuses[record].ok() && from_number_value(values[record], schedule) && schedule <= Now);
+             
+             bool expired = passed;
+             
+             if (statuses[reg].ok() && values[reg] == INT_KEY)
+             {
+                    /* 
+                     * Keys carry their own deadline, which is newer if it was
+                     * rescheduled. Missing keys were dropped by a compaction
+                     * (see ExpireFilter), which leaves their record in place.
+                     */
+                    
+                    if (!statuses[entry].ok())
+                    {
+                           expired = true;
+                    }
+                    else if (value_deadline(values[entry]))
+                    {
+                           expired = (value_deadline(values[entry]) <= Now);
+                    }
+             }
+             
+             if (expired && statuses[reg].ok())
+             {
+                    this->Reap(batch, this->due[i].first, this->due[i].second, values[reg]);
+             }
+             else if (passed)
+             {
+                    batch.Delete(lookups[record]);
+             }
+      }
+      
+      if (batch.Count() && !this->Commit(batch))
+      {
+             access_set(DBL_UNABLE_WRITE);
+             return;
+      }
+      
+      this->SetOK();
+}
+
+void expire_batch_query::Process()
+{
+
+}
+
 void set_query::Run()
 {
-       if (this->Write(this->dest, to_bin(this->value)))
+       if (this->Write(this->dest, to_value(this->value)))
        {
             this->SetOK();
        }
@@ -184,7 +222,7 @@ void set_query::Process()
 void get_substr_query::Run()
 {
        RocksData result = this->Get(this->dest);
-       this->response = to_string(result.value);
+       this->response = from_value(result.value);
        
        if ((unsigned int)(this->offset + this->limit) > this->response.length())
        {	
@@ -194,7 +232,7 @@ void get_substr_query::Run()
        
        this->response = this->response.substr(this->offset, this->limit);
        
-       if (this->Write(this->dest, to_bin(this->response)))
+       if (this->Write(this->dest, to_value(this->response)))
        {
             this->SetOK();
        }
@@ -212,7 +250,7 @@ void get_substr_query::Process()
 void modify_query::Run()
 {
        RocksData result = this->Get(this->dest);
-       this->response = to_string(result.value);
+       this->response = from_value(result.value);
        
        if (this->function == STR_TO_UPPER)
        {
@@ -230,7 +268,7 @@ void modify_query::Run()
             }
        }
  
-       if (this->Write(this->dest, to_bin(this->response)))
+       if (this->Write(this->dest, to_value(this->response)))
        {
             this->SetOK();
        }
@@ -248,7 +286,7 @@ void modify_query::Process()
 void get_occurs_query::Run()
 {
        RocksData result = this->Get(this->dest);
-       this->response = to_string(result.value);
+       this->response = from_value(result.value);
        this->response = convto_string(count_occur(this->response, this->value));
        this->SetOK();
 }
@@ -262,7 +300,7 @@ void alpha_query::Run()
 {
        RocksData result = this->Get(this->dest);
 
-       if (isalpha(to_string(result.value)))
+       if (isalpha(from_value(result.value)))
        {
              this->response = "1";
        }
@@ -283,7 +321,7 @@ void char_query::Run()
 {
        RocksData result = this->Get(this->dest);
 
-       const std::string& found = to_string(result.value);
+       const std::string& found = from_value(result.value);
        const unsigned int flength = convto_num<unsigned int>(this->value);
       
        if (flength >= found.length())
@@ -308,7 +346,7 @@ void isnum_query::Run()
 {
        RocksData result = this->Get(this->dest);
 
-       if (is_number(to_string(result.value), true))
+       if (is_number(from_value(result.value), true))
        {
              this->response = "1";
        }
@@ -328,7 +366,7 @@ void isnum_query::Process()
 void isbool_query::Run()
 {
        RocksData result = this->Get(this->dest);
-       const std::string& as_str = to_string(result.value);
+       const std::string& as_str = from_value(result.value);
        
        if (as_str == "0" || as_str == "1" || as_str == "true" || as_str == "false" || as_str == "on" || as_str == "off")
        {
@@ -350,7 +388,7 @@ void isbool_query::Process()
 void getpersist_query::Run()
 {
        RocksData result = this->Get(this->dest);
-       this->response = to_string(result.value);
+       this->response = from_value(result.value);
        
        this->DelExpire();
        this->SetOK();
@@ -364,7 +402,7 @@ void getpersist_query::Process()
 void get_query::Run()
 {
        RocksData result = this->Get(this->dest);
-       this->response = to_string(result.value);
+       this->response = from_value(result.value);
        this->SetOK();
 }
 
@@ -376,7 +414,7 @@ void get_query::Process()
 void strlen_query::Run()
 {
        RocksData result = this->Get(this->dest);
-       this->response = convto_string(to_string(result.value).length());
+       this->response = convto_string(from_value(result.value).length());
        this->SetOK();
 }
 
@@ -389,9 +427,12 @@ void count_query::Run()
 {
        unsigned int total_counter = 0;
 
-       rocksdb::Iterator* it = this->database->GetAddress()->NewIterator(rocksdb::ReadOptions());
+       const std::string& prefix = to_prefix(this->select_query, INT_KEY);
+       std::unique_ptr<rocksdb::Iterator> it = this->Scan(prefix);
+
+       const time_t Now = Kernel->Now();
 
-       for (it->SeekToFirst(); it->Valid(); it->Next()) 
+       for (; it->Valid() && it->key().starts_with(prefix); it->Next())
        {
                 if (!Dispatcher::CheckIterator(this))
                 {
@@ -400,64 +441,23 @@ void count_query::Run()
                 
                 std::string rawmap = it->key().ToString();
 
-                engine::colon_node_stream stream(rawmap);
-                std::string token;
-                unsigned int strcounter = 0;
-                bool skip = false;
+                KeyData parsed;
 
-                std::string key_as_string;
-
-                while (stream.items_extract(token))
+                if (!from_dest(rawmap, parsed))
                 {
-                        if (skip)
-                        {
-                            break;
-                        }
-
-                        switch (strcounter)
-                        {
-                             case 0:
-                             {
-                                  key_as_string = to_string(token);
-                                  
-                                  if (!Daemon::Match(key_as_string, this->key))
-                                  {
-                                        skip = true;
-                                  }
-                             }
-
-                             break;
-
-                             case 1:
-                             {
-                                   if (convto_string(this->select_query) != token)
-                                   {
-                                        skip = true;
-                                   }
-                             }
-
-                             break;
-                             
-                             case 2:
-                             {
-                                  if (token != INT_KEY)
-                                  {
-                                         skip = true;   
-                                  }
-                             }
-                             
-                             break;
+                        continue;
+                }
 
-                             default:
-                             {
-                                 break;   
-                             }
-                        }
+                /* Expired, not removed yet. */
 
-                        strcounter++;
+                if (is_expired(it->value().ToString(), Now))
+                {
+                        continue;
                 }
 
-                if (skip)
+                const std::string& key_as_string = parsed.key;
+
+                if (!Daemon::Match(key_as_string, this->key))
                 {
                         continue;
                 }
@@ -477,7 +477,7 @@ void count_query::Process()
 void getdel_query::Run()
 {
        RocksData result = this->Get(this->dest);
-       this->response = to_string(result.value);
+       this->response = from_value(result.value);
        this->Delete(this->dest);
        this->SetOK();
 }
@@ -490,9 +490,9 @@ void getdel_query::Process()
 void getset_query::Run()
 {
        RocksData result = this->Get(this->dest);
-       this->response = to_string(result.value);
+       this->response = from_value(result.value);
 
-       if (this->Write(this->dest, to_bin(this->value)))
+       if (this->Write(this->dest, to_value(this->value)))
        {
             this->SetOK();
        }
@@ -507,15 +507,21 @@ void getset_query::Process()
        user->SendProtocol(BRLD_OK, Helpers::Format(this->response.c_str()));
 }
 
+void wdel_query::Stripes(std::vector<size_t>& locked)
+{
+       KeyLocks::All(locked);
+}
+
 void wdel_query::Run()
 {
        unsigned int total_counter = 0;
 
        std::string rawmap;
        
-       rocksdb::Iterator* it = this->database->GetAddress()->NewIterator(rocksdb::ReadOptions());
+       const std::string& prefix = to_prefix(this->select_query, INT_KEY);
+       std::unique_ptr<rocksdb::Iterator> it = this->Scan(prefix);
 
-       for (it->SeekToFirst(); it->Valid(); it->Next()) 
+       for (; it->Valid() && it->key().starts_with(prefix); it->Next())
        {
                 if (!Dispatcher::CheckIterator(this))
                 {
@@ -523,65 +529,16 @@ void wdel_query::Run()
                 }
 
                 rawmap = it->key().ToString();
-                std::string key_as_string;
-                std::string token;
-                bool skip = false;
-                
-                unsigned int strcounter = 0;
-                
-                engine::colon_node_stream stream(rawmap);
-                
-                while (stream.items_extract(token))
-                {
-                        if (skip)
-                        {
-                            break;
-                        }
-
-                        switch (strcounter)
-                        {
-                             case 0:
-                             {
-                                  key_as_string = to_string(token);
-                                  
-                                  if (!Daemon::Match(key_as_string, this->key))
-                                  {
-                                        skip = true;
-                                  }
-                             }
-
-                             break;
-
-                             case 1:
-                             {
-                                   if (convto_string(this->select_query) != token)
-                                   {
-                                        skip = true;
-                                   }
-                             }
-
-                             break;
-                             
-                             case 2:
-                             {
-                                  if (token != INT_KEY)
-                                  {
-                                         skip = true;   
-                                  }
-                             }
+                KeyData parsed;
 
-                             break;
-
-                             default:
-                             {
-                                 break;   
-                             }
-                        }
-
-                        strcounter++;
+                if (!from_dest(rawmap, parsed))
+                {
+                        continue;
                 }
 
-                if (skip)
+                const std::string& key_as_string = parsed.key;
+
+                if (!Daemon::Match(key_as_string, this->key))
                 {
                         continue;
                 }
@@ -607,7 +564,7 @@ void setnx_query::Run()
        
        if (!result.status.ok())
        {
-            if (this->Write(this->dest, to_bin(this->value)))
+            if (this->Write(this->dest, to_value(this->value)))
             {
                 this->SetOK();
             }
@@ -627,13 +584,86 @@ void setnx_query::Process()
        user->SendProtocol(BRLD_OK, PROCESS_OK);
 }
 
+void gets_query::Run()
+{
+       const StringVector& keys = this->VecData;
+       StringVector dests;
+
+       dests.reserve(keys.size());
+
+       for (StringVector::const_iterator i = keys.begin(); i != keys.end(); ++i)
+       {
+              dests.push_back(to_dest(*i, this->select_query, INT_KEY));
+       }
+
+       StringVector values;
+       std::vector<rocksdb::Status> statuses;
+       this->ReadMany(dests, values, statuses);
+
+       this->found.reserve(keys.size());
+
+       for (size_t i = 0; i < keys.size(); ++i)
+       {
+              if (statuses[i].ok() && !is_expired(values[i], Kernel->Now()))
+              {
+                     this->found.push_back(std::make_pair(keys[i], Helpers::Format(from_value(values[i]))));
+              }
+              else
+              {
+                     this->found.push_back(std::make_pair(keys[i], PROCESS_NULL));
+              }
+       }
+
+       this->SetOK();
+}
+
+void gets_query::Process()
+{
+       Dispatcher::PairFlush("Key", "Value", this->found, this);
+}
+
+void cas_query::Run()
+{
+       RocksData result = this->Get(this->dest);
+       
+       if (!result.status.ok())
+       {
+            access_set(DBL_NOT_FOUND);
+            return;
+       }
+       
+       /* Key is locked while running, so no other write lands in between. */
+       
+       if (from_value(result.value) != this->hesh)
+       {
+            this->response = "0";
+            this->SetOK();
+            return;
+       }
+       
+       if (this->Write(this->dest, to_value(this->value)))
+       {
+            this->response = "1";
+            this->SetOK();
+       }
+       else
+       {
+            access_set(DBL_UNABLE_WRITE);
+       }
+}
+
+void cas_query::Process()
+{
+       user->SendProtocol(BRLD_OK, this->response);
+}
+
 void settx_query::Run()
 {
        RocksData result = this->Get(this->dest);
        
        if (this->IsExpiring() < 0)
        {
-            this->Write(this->dest, to_bin(this->value));
+            this->Write(this->dest, to_value(this->value));
             this->SetOK();
             return;
        }
@@ -654,9 +684,12 @@ void search_query::Run()
        unsigned int aux_counter = 0;
        unsigned int tracker = 0;
 
-       rocksdb::Iterator* it = this->database->GetAddress()->NewIterator(rocksdb::ReadOptions());
+       const std::string& prefix = to_prefix(this->select_query, INT_KEY);
+       std::unique_ptr<rocksdb::Iterator> it = this->Scan(prefix);
 
-       for (it->SeekToFirst(); it->Valid(); it->Next()) 
+       const time_t Now = Kernel->Now();
+
+       for (; it->Valid() && it->key().starts_with(prefix); it->Next())
        {
                 if (!Dispatcher::CheckIterator(this))
                 {
@@ -664,70 +697,29 @@ void search_query::Run()
                 }
 
                 std::string rawmap = it->key().ToString();
-                std::string rawvalue = to_string(it->value().ToString());
+                std::string rawvalue = from_value(it->value().ToString());
                          
-                engine::colon_node_stream stream(rawmap);
-                std::string token;
-                unsigned int strcounter = 0;
-                bool skip = false;
+                KeyData parsed;
 
-                std::string key_as_string;
-                
-                if (!Daemon::Match(rawvalue, this->key))
+                if (!from_dest(rawmap, parsed))
                 {
                         continue;
                 }
 
-                while (stream.items_extract(token))
-                {
-                        if (skip)
-                        {
-                            break;
-                        }
-
-                        switch (strcounter)
-                        {
-                             case 0:
-                             {
-                                  key_as_string = to_string(token);
-                             }
-
-                             break;
-
-                             case 1:
-                             {
-                                   if (convto_string(this->select_query) != token)
-                                   {
-                                        skip = true;
-                                   }
-                             }
-
-                             break;
-
-                             case 2:
-                             {
-                                  if (token != INT_KEY)
-                                  {
-                                         skip = true;   
-                                  }
-                             }
-
-                             break;
-
-                             default:
-                             {
-                                 break;   
-                             }
-                        }
+                /* Expired, not removed yet. */
 
-                        strcounter++;
+                if (is_expired(it->value().ToString(), Now))
+                {
+                        continue;
                 }
 
-                if (skip)
+                if (!Daemon::Match(rawvalue, this->key))
                 {
                         continue;
                 }
 
+                const std::string& key_as_string = parsed.key;
+
                 if (this->limit != -1 && ((signed int)total_counter >= this->offset))
                 {
                              if (((signed int)aux_counter < limit))
@@ -741,6 +733,7 @@ void search_query::Run()
                                                 std::shared_ptr<search_query> request = std::make_shared<search_query>();
                                                 request->user = this->user;
                                                 request->partial = true;                                  
+                                                request->slot = this->slot;
                                                 request->subresult = ++tracker;
                                                 request->mmap = result;
                                                 result.clear();
@@ -764,6 +757,7 @@ void search_query::Run()
                                         std::shared_ptr<search_query> request = std::make_shared<search_query>();
                                         request->user = this->user;
                                         request->partial = true;
+                                        request->slot = this->slot;
                                         request->subresult = ++tracker;
                                         request->mmap = result;
                                         result.clear();
@@ -775,6 +769,8 @@ void search_query::Run()
                 total_counter++;
     }
 
+    this->EndPage(it.get(), prefix);
+
     this->subresult = ++tracker;
     this->partial = false;
     this->counter = aux_counter;
@@ -796,9 +792,12 @@ void keys_query::Run()
 
        std::string rawmap;
        
-       rocksdb::Iterator* it = this->database->GetAddress()->NewIterator(rocksdb::ReadOptions());
-       
-       for (it->SeekToFirst(); it->Valid(); it->Next()) 
+       const std::string& prefix = to_prefix(this->select_query, INT_KEY);
+       std::unique_ptr<rocksdb::Iterator> it = this->Scan(prefix);
+
+       const time_t Now = Kernel->Now();
+
+       for (; it->Valid() && it->key().starts_with(prefix); it->Next())
        {
                 if (!Dispatcher::CheckIterator(this))
                 {
@@ -806,64 +805,23 @@ void keys_query::Run()
                 }
                 
                 rawmap = it->key().ToString();
-                engine::colon_node_stream stream(rawmap);
-                std::string token;
-                unsigned int strcounter = 0;
-                bool skip = false;
-                
-                std::string key_as_string;
-                
-                while (stream.items_extract(token))
-                {       
-                        if (skip)
-                        {
-                            break;
-                        }
-                        
-                        switch (strcounter)
-                        {
-                             case 0:
-                             {
-                                  key_as_string = to_string(token);
-                                
-                                  if (!Daemon::Match(key_as_string, this->key))
-                                  {
-                                       skip = true;
-                                  }
-                             }
-                             
-                             break;
-                             
-                             case 1:
-                             {
-                                   if (convto_string(this->select_query) != token)
-                                   {
-                                        skip = true;
-                                   }
-                             }
-                             
-                             break;
-                             
-                             case 2:
-                             {
-                                  if (token != INT_KEY)
-                                  {
-                                         skip = true;	
-                                  }
-                             }
-                             
-                             break;
-                             
-                             default:
-                             {
-                                 break;   
-                             }                                     
-                        }
-                        
-                        strcounter++;
+                KeyData parsed;
+
+                if (!from_dest(rawmap, parsed))
+                {
+                        continue;
                 }
-                
-                if (skip)
+
+                /* Expired, not removed yet. */
+
+                if (is_expired(it->value().ToString(), Now))
+                {
+                        continue;
+                }
+
+                const std::string& key_as_string = parsed.key;
+
+                if (!Daemon::Match(key_as_string, this->key))
                 {
                         continue;
                 }
@@ -883,6 +841,7 @@ void keys_query::Run()
                                                 request->key	= this->key;
                                                 request->user = this->user;
                                                 request->partial = true;                                  
+                                                request->slot = this->slot;
                                                 request->subresult = tracker;
                                                 request->VecData = result;
                                                 result.clear();
@@ -908,6 +867,7 @@ void keys_query::Run()
                                         request->key	= this->key;
                                         request->user = this->user;
                                         request->partial = true;
+                                        request->slot = this->slot;
                                         request->subresult = tracker;
                                         request->VecData = result;
                                         result.clear();
@@ -919,6 +879,8 @@ void keys_query::Run()
                 total_counter++;
     }
 
+    this->EndPage(it.get(), prefix);
+
     this->subresult = ++tracker;
     this->partial = false;
     this->counter = aux_counter;
@@ -933,10 +895,14 @@ void keys_query::Process()
 
 void append_query::Run()
 {
-       RocksData result = this->Get(this->dest);
-       this->response = to_string(result.value) + this->value;
+       if (this->identified != PROCESS_NULL)
+       {
+            this->response = from_value(this->Get(this->dest).value);
+       }
+
+       this->response.append(this->value);
        
-       if (this->Write(this->dest, to_bin(this->response)))
+       if (this->Write(this->dest, to_value(this->response)))
        {
             this->SetOK();
        }
@@ -953,108 +919,51 @@ void append_query::Process()
 
 void random_query::Run()
 {
-       unsigned int total_counter = 0;
-       
-       std::string foundkey;
-
-       rocksdb::Iterator* it = this->database->GetAddress()->NewIterator(rocksdb::ReadOptions());
+       const std::string& prefix = to_prefix(this->select_query, INT_KEY);
+       std::unique_ptr<rocksdb::Iterator> it = this->Scan(prefix);
 
-       for (it->SeekToFirst(); it->Valid(); it->Next()) 
+       if (!it->Valid() || !it->key().starts_with(prefix))
        {
-                if (!Dispatcher::CheckIterator(this))
-                {
-                       return;
-                }
-
-                std::string rawmap = it->key().ToString();
-                engine::colon_node_stream stream(rawmap);
-                std::string token;
-                unsigned int strcounter = 0;
-                bool skip = false;
-
-                std::string key_as_string;
-          
-                while (stream.items_extract(token))
-                {
-                        if (skip)
-                        {
-                            break;
-                        }
-
-                        switch (strcounter)
-                        {
-                             case 0:
-                             {
-                                  key_as_string = to_string(token);
-                             }
-
-                             break;
-
-                             case 1:
-                             {
-                                   if (convto_string(this->select_query) != token)
-                                   {
-                                        skip = true;
-                                   }
-                             }
+            access_set(DBL_NOT_FOUND);
+            return;
+       }
 
-                             break;
-                             
-                             case 2:
-                             {
-                                  if (token != INT_KEY)
-                                  {
-                                         skip = true;   
-                                  }
-                             }
+       /* Seeks to a random point between the first and last key of this select. */
+       
+       const std::string first = it->key().ToString();
+       
+       std::unique_ptr<rocksdb::Iterator> last = this->Scan(to_prefix(INT_KEY));
+       last->SeekForPrev(to_prefix(this->select_query + 1, INT_KEY));
+       
+       if (last->Valid() && last->key() == to_prefix(this->select_query + 1, INT_KEY))
+       {
+            last->Prev();
+       }
+       
+       const unsigned char low = (first.size() > KEY_PREFIX_LENGTH ? first[KEY_PREFIX_LENGTH] : 0);
+       const unsigned char high = (last->Valid() && last->key().size() > KEY_PREFIX_LENGTH ? last->key()[KEY_PREFIX_LENGTH] : 255);
 
-                             break;
+       std::string target = prefix;
+       target.push_back(static_cast<char>(IntRand(low, high)));
+       target.push_back(static_cast<char>(IntRand(0, 255)));
 
-                             default:
-                             {
-                                 break;   
-                             }
-                        }
-
-                        strcounter++;
-                }
+       it->Seek(target);
+       
+       if (!it->Valid() || !it->key().starts_with(prefix))
+       {
+            it->Seek(prefix);
+       }
 
-                if (skip)
-                {
-                        continue;
-                }
-                
-                total_counter++;
-                
-                if (foundkey.empty())
-                {
-                     foundkey = key_as_string;
-                     continue;
-                }
-                
-                unsigned int rvalue = IntRand(0, 1);
-                
-                if (rvalue == 0)
-                {
-                      foundkey = key_as_string;
-                }	
-                
-                unsigned int stopvalue = IntRand(2, 1000);
-                
-                if (stopvalue == total_counter)
-                {
-                     break;
-                }
-      }
-      
-      if (total_counter == 0 && foundkey.empty())
-      {
+       KeyData parsed;
+       
+       if (!it->Valid() || !from_dest(it->key().ToString(), parsed))
+       {
             access_set(DBL_NOT_FOUND);
             return;
-      }
+       }
        
-      this->response = foundkey;
-      this->SetOK();
+       this->response = parsed.key;
+       this->SetOK();
 }
 
 void random_query::Process()
@@ -1065,7 +974,7 @@ void random_query::Process()
 void getexp_query::Run()
 {
        RocksData result = this->Get(this->dest);
-       this->response = to_string(result.value);
+       this->response = from_value(result.value);
        
        this->WriteExpire(this->key, this->select_query, this->id);
        this->SetOK();
@@ -1080,7 +989,7 @@ void asbool_query::Run()
 {
        RocksData result = this->Get(this->dest);
 
-       std::string as_str = to_string(result.value);
+       std::string as_str = from_value(result.value);
        
        if (as_str == "1" || as_str == "true" || as_str == "on")
        {
@@ -1103,7 +1012,7 @@ void ismatch_query::Run()
 {
        RocksData result = this->Get(this->dest);
 
-       std::string as_str = to_string(result.value);
+       std::string as_str = from_value(result.value);
 
        if (Daemon::Match(as_str, this->value))
        {
@@ -1125,7 +1034,7 @@ void ismatch_query::Process()
 void insert_query::Run()
 {       
        RocksData result = this->Get(this->dest);
-       std::string as_str = to_string(result.value);
+       std::string as_str = from_value(result.value);
        
        if (as_str.length() < this->id)
        {
@@ -1136,7 +1045,7 @@ void insert_query::Run()
        as_str.insert(this->id, this->value);
        this->response = as_str;
        
-       if (this->Write(this->dest, to_bin(as_str)))
+       if (this->Write(this->dest, to_value(as_str)))
        {
             this->SetOK();
        }
@@ -0,0 +1,287 @@
+/*
+ * BerylDB - A lightweight database.
+ * http://www.beryldb.com
+ *
+ * Copyright (C) 2021 - Carlos F. Ferry <cferry@beryldb.com>
+ *
+ * This file is part of BerylDB. BerylDB is free software: you can
+ * redistribute it and/or modify it under the terms of the BSD License
+ * version 3.
+ *
+ * More information about our licensing can be found at https://docs.beryl.dev
+ */
+
+#include <set>
+
+#include "beryl.h"
+#include "brldb/codec.h"
+#include "brldb/merge.h"
+
+namespace
+{
+      /*
+       * Finds the counter an entry belongs to. Data types are counted through
+       * their registry entry (INT_REG), which is only written when a key is
+       * created or removed. Expires and futures have no registry entry, so
+       * they are counted directly.
+       */
+
+      bool Counted(const rocksdb::Slice& raw, KeyData& parsed)
+      {
+              if (!from_dest(raw.ToString(), parsed))
+              {
+                     return false;
+              }
+
+              return (parsed.type == INT_REG || parsed.type == INT_EXPIRE || parsed.type == INT_FUTURE);
+      }
+
+      /* Collects how a batch changes the number of entries of every select and type. */
+
+      class KeyspaceDelta : public rocksdb::WriteBatch::Handler
+      {
+          private:
+
+              rocksdb::DB* db;
+
+              /* Counted type of entries seen so far, empty once removed. */
+
+              std::map<std::string, std::string> found;
+
+              /* Ranges removed by this batch, [begin, end). */
+
+              std::vector<std::pair<std::string, std::string>> cleared;
+
+          public:
+
+              /* Change of every counter. */
+
+              std::map<std::string, int64_t> deltas;
+
+              /* Counters set to their delta, instead of adding it. */
+
+              std::set<std::string> resets;
+
+              KeyspaceDelta(rocksdb::DB* database) : db(database)
+              {
+
+              }
+
+              /* Type an entry is counted as, before this operation. */
+
+              std::string& Lookup(const std::string& raw, const KeyData& parsed)
+              {
+                      std::map<std::string, std::string>::iterator entry = this->found.find(raw);
+
+                      if (entry != this->found.end())
+                      {
+                              return entry->second;
+                      }
+
+                      std::string& type = this->found[raw];
+
+                      for (std::vector<std::pair<std::string, std::string>>::const_iterator i = this->cleared.begin(); i != this->cleared.end(); ++i)
+                      {
+                              if (raw >= i->first && raw < i->second)
+                              {
+                                      return type;
+                              }
+                      }
+
+                      std::string stored;
+
+                      if (this->db->Get(rocksdb::ReadOptions(), raw, &stored).ok())
+                      {
+                              type = (parsed.type == INT_REG ? stored : parsed.type);
+                      }
+
+                      return type;
+              }
+
+              void Added(const rocksdb::Slice& key, const std::string& newtype)
+              {
+                      KeyData parsed;
+
+                      if (!Counted(key, parsed))
+                      {
+                              return;
+                      }
+
+                      std::string& type = this->Lookup(key.ToString(), parsed);
+
+                      if (type == newtype)
+                      {
+                              return;
+                      }
+
+                      if (!type.empty())
+                      {
+                              this->deltas[to_counter(parsed.select, type)]--;
+                      }
+
+                      this->deltas[to_counter(parsed.select, newtype)]++;
+                      type = newtype;
+              }
+
+              void Removed(const rocksdb::Slice& key)
+              {
+                      KeyData parsed;
+
+                      if (!Counted(key, parsed))
+                      {
+                              return;
+                      }
+
+                      std::string& type = this->Lookup(key.ToString(), parsed);
+
+                      if (!type.empty())
+                      {
+                              this->deltas[to_counter(parsed.select, type)]--;
+                              type.clear();
+                      }
+              }
+
+              rocksdb::Status PutCF(uint32_t family, const rocksdb::Slice& key, const rocksdb::Slice& value) override
+              {
+                      KeyData parsed;
+
+                      if (Counted(key, parsed))
+                      {
+                              this->Added(key, parsed.type == INT_REG ? value.ToString() : parsed.type);
+                      }
+
+                      return rocksdb::Status::OK();
+              }
+
+              rocksdb::Status MergeCF(uint32_t family, const rocksdb::Slice& key, const rocksdb::Slice& value) override
+              {
+                      KeyData parsed;
+
+                      if (Counted(key, parsed) && parsed.type != INT_REG)
+                      {
+                              this->Added(key, parsed.type);
+                      }
+
+                      return rocksdb::Status::OK();
+              }
+
+              rocksdb::Status DeleteCF(uint32_t family, const rocksdb::Slice& key) override
+              {
+                      this->Removed(key);
+                      return rocksdb::Status::OK();
+              }
+
+              rocksdb::Status DeleteRangeCF(uint32_t family, const rocksdb::Slice& begin, const rocksdb::Slice& end) override
+              {
+                      KeyData parsed;
+
+                      if (!Counted(begin, parsed))
+                      {
+                              return rocksdb::Status::OK();
+                      }
+
+                      const std::string& first = begin.ToString();
+                      const std::string& last = end.ToString();
+
+                      /* Whole selects (SFLUSH) reset their counters, without reading them. */
+
+                      if (first == to_prefix(parsed.select, parsed.type) && last == to_prefix(parsed.select + 1, parsed.type))
+                      {
+                              for (std::vector<std::string>::const_iterator i = TypeRegs.begin(); i != TypeRegs.end(); ++i)
+                              {
+                                      if (parsed.type == *i || (parsed.type == INT_REG && is_data_type(*i)))
+                                      {
+                                              const std::string& counter = to_counter(parsed.select, *i);
+                                              this->deltas[counter] = 0;
+                                              this->resets.insert(counter);
+                                      }
+                              }
+
+                              for (std::map<std::string, std::string>::iterator entry = this->found.lower_bound(first); entry != this->found.end() && entry->first < last; ++entry)
+                              {
+                                      entry->second.clear();
+                              }
+                      }
+                      else
+                      {
+                              rocksdb::ReadOptions options;
+                              options.total_order_seek = true;
+
+                              std::unique_ptr<rocksdb::Iterator> it(this->db->NewIterator(options));
+
+                              for (it->Seek(begin); it->Valid() && it->key().compare(end) < 0; it->Next())
+                              {
+                                      this->Removed(it->key());
+                              }
+
+                              /* Entries created earlier in this batch. */
+
+                              for (std::map<std::string, std::string>::iterator entry = this->found.lower_bound(first); entry != this->found.end() && entry->first < last; ++entry)
+                              {
+                                      this->Removed(entry->first);
+                              }
+                      }
+
+                      this->cleared.push_back(std::make_pair(first, last));
+                      return rocksdb::Status::OK();
+              }
+      };
+}
+
+rocksdb::Status Database::Count(rocksdb::WriteBatch& batch)
+{
+        KeyspaceDelta delta(this->db);
+
+        rocksdb::Status counted = batch.Iterate(&delta);
+
+        for (std::map<std::string, int64_t>::const_iterator i = delta.deltas.begin(); i != delta.deltas.end() && counted.ok(); ++i)
+        {
+                if (delta.resets.count(i->first))
+                {
+                        counted = batch.Put(i->first, to_number_value(i->second));
+                }
+                else if (i->second)
+                {
+                        counted = batch.Merge(i->first, to_numeric_operand(OP_ADD, i->second));
+                }
+        }
+
+        return counted;
+}
+
+unsigned int Database::Counter(unsigned int select, const std::string& type)
+{
+        std::string stored;
+        double number = 0;
+
+        if (!this->db->Get(rocksdb::ReadOptions(), to_counter(select, type), &stored).ok() || !from_number_value(stored, number) || number < 0)
+        {
+                return 0;
+        }
+
+        return static_cast<unsigned int>(number);
+}
+
+unsigned int Database::Counter(const std::string& type)
+{
+        const std::string& prefix = KEYSPACE_COUNTER + to_prefix(type);
+
+        rocksdb::ReadOptions scan;
+        scan.prefix_same_as_start = true;
+
+        std::unique_ptr<rocksdb::Iterator> it(this->db->NewIterator(scan));
+
+        double total = 0;
+
+        for (it->Seek(prefix); it->Valid() && it->key().starts_with(prefix); it->Next())
+        {
+                double number = 0;
+
+                if (from_number_value(it->value().ToString(), number) && number > 0)
+                {
+                        total += number;
+                }
+        }
+
+        return static_cast<unsigned int>(total);
+}
@@ -16,6 +16,7 @@
 #include "beryl.h"
 #include "engine.h"
 #include "brldb/list_handler.h"
+#include "brldb/codec.h"
 
 ListHandler::ListHandler()
 {
@@ -26,12 +27,17 @@ std::shared_ptr<ListHandler> ListHandler::Create(const std::string& load)
 {
         std::shared_ptr<ListHandler> New = std::make_shared<ListHandler>();
         
-        engine::colon_node_stream stream(load);
+        size_t pos = 0;
         std::string mask;
 
-        while (stream.items_extract(mask))
+        if (!from_fields(load, pos))
         {
-                New->Add(to_string(mask));
+                return New;
+        }
+
+        while (pos < load.size() && codec_get_field(load, pos, mask))
+        {
+                New->Add(mask);
         }
         
         return New;
@@ -224,22 +230,11 @@ void ListHandler::Remove(const std::string& key)
 
 std::string ListHandler::as_string()
 {
-        std::string final;
-        
-        unsigned int size = this->mhandler.size();
-        
-        unsigned int counter = 0;
+        std::string final = to_fields();
         
         for (ListMap::const_iterator i = this->mhandler.begin(); i != this->mhandler.end(); ++i)      
         {
-                  std::string key = *i;
-                  
-                  if (counter != size)
-                  {
-                        final += to_bin(key) + ":";
-                  }
-                  
-                  counter++;
+                  codec_put_field(final, *i);
         }
         
         return final;
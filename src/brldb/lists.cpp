@@ -16,6 +16,295 @@
 
 #include "brldb/list_handler.h"
 
+/* 
+ * Reads the header of the list a query points to.
+ * 
+ * @parameters:
+ *
+ *         · QueryBase : Query pointing to a list (dest).
+ *         · ListHeader: Header read.
+ *
+ * @return:
+ *
+ *         · bool: False if list does not exist.
+ */
+
+static bool ReadHeader(QueryBase* query, ListHeader& header)
+{
+       RocksData result = query->Get(query->dest);
+       return (result.status.ok() && from_list_header(result.value, header));
+}
+
+/* 
+ * Stores an updated header, or removes the list if it has no elements
+ * left. Elements must have been updated in the same batch.
+ */
+
+static bool WriteHeader(QueryBase* query, rocksdb::WriteBatch& batch, const ListHeader& header)
+{
+       if (header.count > 0)
+       {
+              batch.Put(query->dest, to_list_header(header));
+       }
+       else
+       {
+              batch.Delete(query->dest);
+              query->RegDelete(batch, query->dest);
+       }
+       
+       return query->Commit(batch);
+}
+
+/* 
+ * Finds the first or last element of a list.
+ * 
+ * @parameters:
+ *
+ *         · QueryBase : Query pointing to a list.
+ *         · ListHeader: List header.
+ *         · bool      : True to find last element.
+ *         · string    : Storage key of element found.
+ *         · string    : Element found.
+ *
+ * @return:
+ *
+ *         · bool: False if list is empty.
+ */
+
+static bool ListEdge(QueryBase* query, const ListHeader& header, bool back, std::string& member, std::string& item)
+{
+       if (header.count == 0)
+       {
+              return false;
+       }
+       
+       const std::string& prefix = to_member_prefix(query->key, query->select_query);
+       const std::string& edge = prefix + to_seq(back ? header.tail - 1 : header.head);
+       
+       std::unique_ptr<rocksdb::Iterator> it = query->Scan(edge);
+       
+       /* Last element is not found at tail - 1 if it was removed by LDEL or LPOPALL. */
+       
+       if (back && (!it->Valid() || it->key().compare(edge) != 0))
+       {
+              it->SeekForPrev(edge);
+       }
+       
+       if (!it->Valid() || !it->key().starts_with(prefix))
+       {
+              return false;
+       }
+       
+       member = it->key().ToString();
+       item = it->value().ToString();
+       return true;
+}
+
+/* 
+ * Positions an iterator at a given index of a list. Caller must check
+ * whether the iterator is still within the list.
+ */
+
+static std::unique_ptr<rocksdb::Iterator> ListAt(QueryBase* query, const ListHeader& header, uint64_t index)
+{
+       const std::string& prefix = to_member_prefix(query->key, query->select_query);
+       
+       /* Without gaps, element n is stored at head + n. */
+       
+       if (header.tail - header.head == header.count)
+       {
+              return query->Scan(prefix + to_seq(header.head + index));
+       }
+       
+       std::unique_ptr<rocksdb::Iterator> it = query->Scan(prefix);
+       
+       for (uint64_t skip = 0; skip < index && it->Valid() && it->key().starts_with(prefix); skip++)
+       {
+              it->Next();
+       }
+       
+       return it;
+}
+
+/* 
+ * Appends an element to a list, creating it if needed.
+ * 
+ * @parameters:
+ *
+ *         · QueryBase: Query pointing to a list.
+ *         · string   : Element to add.
+ *
+ * @return:
+ *
+ *         · bool: False if list could not be written.
+ */
+
+static bool ListPush(QueryBase* query, const std::string& item)
+{
+       ListHeader header;
+       const bool exists = ReadHeader(query, header);
+       
+       rocksdb::WriteBatch batch;
+       batch.Put(to_member_prefix(query->key, query->select_query) + to_seq(header.tail++), item);
+       header.count++;
+       
+       batch.Put(query->dest, to_list_header(header));
+       
+       if (!exists)
+       {
+              query->RegPut(batch, query->dest);
+       }
+       
+       return query->Commit(batch);
+}
+
+/* 
+ * Removes the first or last element of a list.
+ * 
+ * @parameters:
+ *
+ *         · QueryBase: Query pointing to a list.
+ *         · bool     : True to remove last element.
+ *         · string   : Element removed.
+ *
+ * @return:
+ *
+ *         · bool: False if nothing was removed, access is set.
+ */
+
+static bool ListPop(QueryBase* query, bool back, std::string& item)
+{
+       ListHeader header;
+       std::string member;
+       
+       if (!ReadHeader(query, header) || !ListEdge(query, header, back, member, item))
+       {
+              query->access_set(DBL_NOT_FOUND);
+              return false;
+       }
+       
+       rocksdb::WriteBatch batch;
+       batch.Delete(member);
+       header.count--;
+       
+       if (back)
+       {
+              header.tail = from_seq(member);
+       }
+       else
+       {
+              header.head = from_seq(member) + 1;
+       }
+       
+       if (!WriteHeader(query, batch, header))
+       {
+              query->access_set(DBL_UNABLE_WRITE);
+              return false;
+       }
+       
+       return true;
+}
+
+/* 
+ * Removes elements matching a value.
+ * 
+ * @parameters:
+ *
+ *         · QueryBase: Query pointing to a list.
+ *         · string   : Value to remove.
+ *         · bool     : Stop after first match.
+ *
+ * @return:
+ *
+ *         · uint: Elements removed.
+ */
+
+static unsigned int ListRemove(QueryBase* query, const std::string& value, bool first_only)
+{
+       ListHeader header;
+       
+       if (!ReadHeader(query, header))
+       {
+              return 0;
+       }
+       
+       const std::string& prefix = to_member_prefix(query->key, query->select_query);
+       
+       rocksdb::WriteBatch batch;
+       unsigned int removed = 0;
+       bool kept = false;
+       
+       std::unique_ptr<rocksdb::Iterator> it = query->Scan(prefix);
+       
+       for (; it->Valid() && it->key().starts_with(prefix); it->Next())
+       {
+              if ((!first_only || !removed) && it->value() == value)
+              {
+                     batch.Delete(it->key());
+                     removed++;
+                     continue;
+              }
+              
+              /* Bounds shrink to remaining elements. */
+              
+              const uint64_t seq = from_seq(it->key().ToString());
+              
+              if (!kept)
+              {
+                     header.head = seq;
+                     kept = true;
+              }
+              
+              header.tail = seq + 1;
+       }
+       
+       if (!removed)
+       {
+              return 0;
+       }
+       
+       header.count -= removed;
+       
+       if (!WriteHeader(query, batch, header))
+       {
+              return 0;
+       }
+       
+       return removed;
+}
+
+/* 
+ * Replaces all elements of a list, keeping its head. Used when 
+ * elements are reordered.
+ */
+
+static bool ListRewrite(QueryBase* query, ListHeader& header, const ListMap& items)
+{
+       const std::string& prefix = to_member_prefix(query->key, query->select_query);
+
+       rocksdb::WriteBatch batch;
+       batch.DeleteRange(prefix, prefix_end(prefix));
+       
+       header.tail = header.head;
+       
+       for (ListMap::const_iterator i = items.begin(); i != items.end(); ++i)
+       {
+              batch.Put(prefix + to_seq(header.tail++), *i);
+       }
+       
+       header.count = items.size();
+       return WriteHeader(query, batch, header);
+}
+
+/* Loads all elements of the list a query points to. */
+
+static std::shared_ptr<ListHandler> ListLoad(QueryBase* query)
+{
+       std::shared_ptr<ListHandler> handler = std::make_shared<ListHandler>();
+       query->LoadList(query->dest, handler->GetList());
+       return handler;
+}
+
 void lkeys_query::Run()
 {
        StringVector result;
@@ -23,9 +312,10 @@ void lkeys_query::Run()
        unsigned int aux_counter = 0;
        unsigned int tracker = 0;
 
-       rocksdb::Iterator* it = this->database->GetAddress()->NewIterator(rocksdb::ReadOptions());
+       const std::string& prefix = to_prefix(this->select_query, INT_LIST);
+       std::unique_ptr<rocksdb::Iterator> it = this->Scan(prefix);
 
-       for (it->SeekToFirst(); it->Valid(); it->Next()) 
+       for (; it->Valid() && it->key().starts_with(prefix); it->Next())
        {
                 if (!Dispatcher::CheckIterator(this))
                 {
@@ -35,64 +325,16 @@ void lkeys_query::Run()
                 std::string rawmap = it->key().ToString();
                 std::string rawvalue = it->value().ToString();
                 
-                engine::colon_node_stream stream(rawmap);
-                std::string token;
-                unsigned int strcounter = 0;
-                bool skip = false;
-
-                std::string key_as_string;
+                KeyData parsed;
 
-                while (stream.items_extract(token))
+                if (!from_dest(rawmap, parsed))
                 {
-                        if (skip)
-                        {
-                            break;
-                        }
-
-                        switch (strcounter)
-                        {
-                             case 0:
-                             {
-                                  key_as_string = to_string(token);
-                                
-                                  if (!Daemon::Match(key_as_string, this->key))
-                                  {
-                                       skip = true;
-                                  }
-                             }
-                             
-                             break;
-                             
-                             case 1:
-                             {
-                                   if (convto_string(this->select_query) != token)
-                                   {
-                                        skip = true;
-                                   }
-                             }
-                             
-                             break;
-                             
-                             case 2:
-                             {
-                                  if (token != INT_LIST)
-                                  {
-                                         skip = true;   
-                                  }
-                             }
-                             
-                             break;
-                             
-                             default:
-                             {
-                                 break;   
-                             }                                     
-                        }
-                        
-                        strcounter++;
+                        continue;
                 }
-                
-                if (skip)
+
+                const std::string& key_as_string = parsed.key;
+
+                if (!Daemon::Match(key_as_string, this->key))
                 {
                         continue;
                 }
@@ -111,6 +353,7 @@ void lkeys_query::Run()
                                                 std::shared_ptr<lkeys_query> request = std::make_shared<lkeys_query>();
                                                 request->user = this->user;
                                                 request->partial = true;                                  
+                                                request->slot = this->slot;
                                                 request->subresult = tracker;
                                                 request->VecData = result;
                                                 result.clear();
@@ -135,6 +378,7 @@ void lkeys_query::Run()
                                         std::shared_ptr<lkeys_query> request = std::make_shared<lkeys_query>();
                                         request->user = this->user;
                                         request->partial = true;
+                                        request->slot = this->slot;
                                         request->subresult = tracker;
                                         request->VecData = result;
                                         result.clear();
@@ -146,6 +390,8 @@ void lkeys_query::Run()
                 total_counter++;
     }
 
+    this->EndPage(it.get(), prefix);
+
     this->subresult = ++tracker;
     this->partial = false;
     this->counter = aux_counter;
@@ -166,49 +412,13 @@ void lpush_query::Run()
              return;
        }
 
-       RocksData result = this->Get(this->dest);
-       std::shared_ptr<ListHandler> handler;
-       
-       if (!result.status.ok())
+       if (!ListPush(this, this->value))
        {
-               /* Create a new entry. */   
-    
-               handler = std::make_shared<ListHandler>();
-               handler->Add(this->value);
-               
-               if (handler->GetLast() == HANDLER_MSG_OK)
-               {
-                     this->Write(this->dest, handler->as_string());
-                     this->SetOK();
-               }
-               else
-               {
-                     access_set(DBL_UNABLE_WRITE);
-               }
-
-               return;
+             access_set(DBL_UNABLE_WRITE);
+             return;
        }
        
-       handler = ListHandler::Create(result.value);
-       handler->Add(this->value);
-       
-       if (handler->GetLast() == HANDLER_MSG_OK)
-       {
-               if (this->Write(this->dest, handler->as_string()))
-               {
-                     this->SetOK();
-               }
-               else
-               {
-                     access_set(DBL_UNABLE_WRITE);
-               }
-               
-               return;
-       }
-       else
-       {
-               access_set(DBL_UNABLE_WRITE);
-       }
+       this->SetOK();
 }
 
 void lpush_query::Process()
@@ -218,18 +428,18 @@ void lpush_query::Process()
 
 void lreverse_query::Run()
 {
-       RocksData result = this->Get(this->dest);
+       ListHeader header;
 
-       if (!result.status.ok())
+       if (!ReadHeader(this, header))
        {
                access_set(DBL_NOT_FOUND);
                return;
        }
 
-       std::shared_ptr<ListHandler> handler = ListHandler::Create(result.value);
+       std::shared_ptr<ListHandler> handler = ListLoad(this);
        handler->Reverse();
        
-       if (this->Write(this->dest, handler->as_string()))
+       if (ListRewrite(this, header, handler->GetList()))
        {
               this->SetOK();
        }
@@ -237,8 +447,6 @@ void lreverse_query::Run()
        {
               access_set(DBL_UNABLE_WRITE);
        }
-       
-       return;
 }
 
 void lsort_query::Process()
@@ -248,18 +456,18 @@ void lsort_query::Process()
 
 void lsort_query::Run()
 {
-       RocksData result = this->Get(this->dest);
+       ListHeader header;
 
-       if (!result.status.ok())
+       if (!ReadHeader(this, header))
        {
                access_set(DBL_NOT_FOUND);
                return;
        }
 
-       std::shared_ptr<ListHandler> handler = ListHandler::Create(result.value);
-       handler->Reverse();
+       std::shared_ptr<ListHandler> handler = ListLoad(this);
+       handler->Sort();
        
-       if (this->Write(this->dest, handler->as_string()))
+       if (ListRewrite(this, header, handler->GetList()))
        {
              this->SetOK();
        }
@@ -267,24 +475,29 @@ void lsort_query::Run()
        {
              access_set(DBL_UNABLE_WRITE);
        }
-       
-       return;
 }
 
 void lpos_query::Run()
 {
-       RocksData result = this->Get(this->dest);
+       ListHeader header;
+       const uint64_t index = convto_num<unsigned int>(this->value);
 
-       std::shared_ptr<ListHandler> handler = ListHandler::Create(result.value);
-       std::string reply = handler->Index(convto_num<unsigned int>(this->value));
+       if (!ReadHeader(this, header) || index >= header.count)
+       {
+            access_set(DBL_NOT_FOUND);
+            return;
+       }
        
-       if (handler->GetLast() == HANDLER_MSG_NOT_FOUND)
+       const std::string& prefix = to_member_prefix(this->key, this->select_query);
+       std::unique_ptr<rocksdb::Iterator> it = ListAt(this, header, index);
+       
+       if (!it->Valid() || !it->key().starts_with(prefix))
        {
             access_set(DBL_NOT_FOUND);
             return;
        }
        
-       this->response = reply;
+       this->response = it->value().ToString();
        this->SetOK();
 }
 
@@ -300,35 +513,54 @@ void lreverse_query::Process()
 
 void lresize_query::Run()
 {
-       RocksData result = this->Get(this->dest);
+       ListHeader header;
 
-       if (!result.status.ok())
+       if (!ReadHeader(this, header))
        {
                access_set(DBL_NOT_FOUND);
                return;
        }
 
-       std::shared_ptr<ListHandler> handler = ListHandler::Create(result.value);
-
-       handler->Resize(convto_num<unsigned int>(this->value));
+       const uint64_t keep = convto_num<unsigned int>(this->value);
        
-       if (handler->Count() > 0)
+       if (keep >= header.count)
        {
-               if (this->Write(this->dest, handler->as_string()))
-               {
-                     this->SetOK();
-               }
-               else
+               this->SetOK();
+               return;
+       }
+       
+       const std::string& prefix = to_member_prefix(this->key, this->select_query);
+       rocksdb::WriteBatch batch;
+
+       if (keep > 0)
+       {
+               /* Elements from position 'keep' onwards are dropped as a single range. */
+               
+               std::unique_ptr<rocksdb::Iterator> it = ListAt(this, header, keep);
+               
+               if (!it->Valid() || !it->key().starts_with(prefix))
                {
-                     access_set(DBL_UNABLE_WRITE);
+                      access_set(DBL_NOT_FOUND);
+                      return;
                }
                
-               return;
+               header.tail = from_seq(it->key().ToString());
+               batch.DeleteRange(it->key(), prefix_end(prefix));
        }
        else
        {
-               this->Delete(this->dest);
-       } 
+               batch.DeleteRange(prefix, prefix_end(prefix));
+       }
+       
+       header.count = keep;
+
+       if (!WriteHeader(this, batch, header))
+       {
+               access_set(DBL_UNABLE_WRITE);
+               return;
+       }
+       
+       this->SetOK();
 }
 
 void lresize_query::Process()
@@ -338,35 +570,12 @@ void lresize_query::Process()
 
 void lpop_front_query::Run()
 {
-       RocksData result = this->Get(this->dest);
-       std::shared_ptr<ListHandler> handler;
+       std::string item;
 
-       if (!result.status.ok())
+       if (ListPop(this, false, item))
        {
-               access_set(DBL_NOT_FOUND);
-               return;
+               this->SetOK();
        }
-
-       handler = ListHandler::Create(result.value);
-       handler->PopFront();
- 
-       if (handler->Count() > 0)
-       {
-               if (this->Write(this->dest, handler->as_string()))
-               {
-                     this->SetOK();
-               }
-               else
-               {
-                     access_set(DBL_UNABLE_WRITE);
-               }
-               
-               return;
-       }
-       else
-       {
-               this->Delete(this->dest);
-       } 
 }
 
 void lpop_front_query::Process()
@@ -376,35 +585,12 @@ void lpop_front_query::Process()
 
 void lpop_back_query::Run()
 {
-       RocksData result = this->Get(this->dest);
-       std::shared_ptr<ListHandler> handler;
+       std::string item;
 
-       if (!result.status.ok())
+       if (ListPop(this, true, item))
        {
-               access_set(DBL_NOT_FOUND);
-               return;
+               this->SetOK();
        }
-
-       handler = ListHandler::Create(result.value);
-       handler->PopBack();
-       
-       if (handler->Count() > 0)
-       {
-               if (this->Write(this->dest, handler->as_string()))
-               {
-                     this->SetOK();
-               }
-               else
-               {
-                     access_set(DBL_UNABLE_WRITE);
-               }
-               
-               return;
-       }
-       else
-       {
-               this->Delete(this->dest);
-       } 
 }
 
 void lpop_back_query::Process()
@@ -414,35 +600,7 @@ void lpop_back_query::Process()
 
 void lpopall_query::Run()
 {
-       RocksData result = this->Get(this->dest);
-
-       if (!result.status.ok())
-       {
-               access_set(DBL_NOT_FOUND);
-               return;
-       }
-
-       std::shared_ptr<ListHandler> handler = ListHandler::Create(result.value);
-       handler->PopAll(this->value);
-
-       if (handler->Count() > 0)
-       {
-               if (this->Write(this->dest, handler->as_string()))
-               {
-                     this->SetOK();
-               }
-               else
-               {
-                     access_set(DBL_UNABLE_WRITE);
-               }
-               
-               return;
-       }
-       else
-       {             
-               this->Delete(this->dest);
-       }        
-       
+       ListRemove(this, this->value, false);
        this->SetOK();
 }
 
@@ -453,16 +611,15 @@ void lpopall_query::Process()
 
 void lcount_query::Run()
 {
-       RocksData query_result = this->Get(this->dest);
+       ListHeader header;
 
-       if (!query_result.status.ok())
+       if (!ReadHeader(this, header))
        {
                access_set(DBL_NOT_FOUND);
                return;
        }
 
-       std::shared_ptr<ListHandler> handler = ListHandler::Create(query_result.value);
-       this->counter = handler->Count();
+       this->counter = header.count;
        this->SetOK();
 }
 
@@ -477,23 +634,41 @@ void lget_query::Run()
        unsigned int aux_counter = 0;
        unsigned int tracker = 0;
        
-       RocksData query_result = this->Get(this->dest);
+       ListHeader header;
        
-       if (!query_result.status.ok())
+       if (!ReadHeader(this, header))
        {
                access_set(DBL_NOT_FOUND);
                return;
        }
        
-       std::shared_ptr<ListHandler> handler = ListHandler::Create(query_result.value);
+       if (this->flags == QUERY_FLAGS_COUNT)
+       {
+               this->counter = header.count;
+               this->SetOK();
+               return;
+       }
+       
+       const std::string& prefix = to_member_prefix(this->key, this->select_query);
+       std::unique_ptr<rocksdb::Iterator> it;
+       
+       /* Elements before offset are skipped, not read. */
        
-       ListMap result = handler->GetList();
+       if (this->flags != QUERY_FLAGS_CORE && this->limit != -1 && this->offset > 0)
+       {
+               total_counter = std::min<uint64_t>(this->offset, header.count);
+               it = ListAt(this, header, total_counter);
+       }
+       else
+       {
+               it = this->Scan(prefix);
+       }
 
        StringVector result_return;
        
-       for (ListMap::iterator i = result.begin(); i != result.end(); ++i)
+       for (; it->Valid() && it->key().starts_with(prefix); it->Next())
        {
-                std::string hesh_as_string = *i;
+                std::string hesh_as_string = it->value().ToString();
                 
                 if (this->flags == QUERY_FLAGS_CORE)
                 {
@@ -502,12 +677,6 @@ void lget_query::Run()
                        continue;
                 }
                 
-                if (this->flags == QUERY_FLAGS_COUNT)
-                {
-                      total_counter++;
-                      continue;
-                }
-
                 if (this->limit != -1 && ((signed int)total_counter >= this->offset))
                 {
                              if (((signed int)aux_counter < limit))
@@ -522,6 +691,7 @@ void lget_query::Run()
 
                                                 request->user = this->user;
                                                 request->partial = true;                                  
+                                                request->slot = this->slot;
                                                 request->subresult = ++tracker;
                                                 request->VecData = result_return;
                                                 result_return.clear();
@@ -545,6 +715,7 @@ void lget_query::Run()
                                         std::shared_ptr<lget_query> request = std::make_shared<lget_query>();
                                         request->user = this->user;
                                         request->partial = true;
+                                        request->slot = this->slot;
                                         request->key    = this->key;
                                         
                                         request->subresult = ++tracker;
@@ -584,15 +755,15 @@ void lexist_query::Process()
 
 void lexist_query::Run()
 {
-       RocksData result = this->Get(this->dest);
+       ListHeader header;
 
-       if (!result.status.ok())
+       if (!ReadHeader(this, header))
        {
                access_set(DBL_NOT_FOUND);
                return;
        }
 
-       std::shared_ptr<ListHandler> handler = ListHandler::Create(result.value);
+       std::shared_ptr<ListHandler> handler = ListLoad(this);
        
        if (handler->Exist(this->value))
        {
@@ -613,56 +784,26 @@ void ldel_query::Process()
 
 void ldel_query::Run()
 {
-       RocksData query_result = this->Get(this->dest);
-
-       if (!query_result.status.ok())
+       if (!ListRemove(this, this->value, true))
        {
                access_set(DBL_NOT_FOUND);
                return;
        }
-
-       std::shared_ptr<ListHandler> handler = ListHandler::Create(query_result.value);
-       
-       if (!handler->Exist(this->value))
-       {
-               access_set(DBL_NOT_FOUND);
-               return;
-       }
-       
-       handler->Remove(this->value);
-
-       if (handler->Count() > 0)
-       {
-               if (this->Write(this->dest, handler->as_string()))
-               {
-                     this->SetOK();
-               }
-               else
-               {
-                     access_set(DBL_UNABLE_WRITE);
-               }
-               
-               return;
-       }
-       else
-       {
-               this->Delete(this->dest);
-       } 
        
        this->SetOK();
 }
 
 void lrepeats_query::Run()
 {
-       RocksData result = this->Get(this->dest);
+       ListHeader header;
 
-       if (!result.status.ok())
+       if (!ReadHeader(this, header))
        {
                access_set(DBL_NOT_FOUND);
                return;
        }
 
-       std::shared_ptr<ListHandler> handler = ListHandler::Create(result.value);
+       std::shared_ptr<ListHandler> handler = ListLoad(this);
        this->response = convto_string(handler->Repeats(this->value));
        this->SetOK();
 }
@@ -674,42 +815,10 @@ void lrepeats_query::Process()
 
 void lrop_query::Run()
 {
-       RocksData result = this->Get(this->dest);
-
-       if (!result.status.ok())
+       if (ListPop(this, true, this->response))
        {
-               access_set(DBL_NOT_FOUND);
-               return;
+               this->SetOK();
        }
-
-       std::shared_ptr<ListHandler> handler = ListHandler::Create(result.value);
-       
-       this->response = handler->RPOP();
-       
-       if (handler->GetLast() == HANDLER_MSG_NOT_FOUND)
-       {
-             access_set(DBL_NOT_FOUND);
-             return;
-       }
-
-       if (handler->Count() > 0)
-       {
-               if (this->Write(this->dest, handler->as_string()))
-               {
-                     this->SetOK();
-               }
-               else
-               {
-                     access_set(DBL_UNABLE_WRITE);
-                     return;
-               }
-       }
-       else
-       {
-               this->Delete(this->dest);
-       } 
-       
-       this->SetOK();
 }
 
 void lrop_query::Process()
@@ -719,43 +828,10 @@ void lrop_query::Process()
 
 void lrfront_query::Run()
 {
-       RocksData result = this->Get(this->dest);
-
-       if (!result.status.ok())
+       if (ListPop(this, false, this->response))
        {
-               access_set(DBL_NOT_FOUND);
-               return;
+               this->SetOK();
        }
-
-       std::shared_ptr<ListHandler> handler = ListHandler::Create(result.value);
-
-       this->response = handler->FPOP();
-
-       if (handler->GetLast() == HANDLER_MSG_NOT_FOUND)
-       {
-             access_set(DBL_NOT_FOUND);
-             return;
-       }
-
-       if (handler->Count() > 0)
-       {
-               if (this->Write(this->dest, handler->as_string()))
-               {
-                     this->SetOK();
-               }
-               else
-               {
-                     access_set(DBL_UNABLE_WRITE);
-               }
-               
-               return;
-       }
-       else
-       {
-               this->Delete(this->dest);
-       } 
-
-       this->SetOK();
 }
 
 void lrfront_query::Process()
@@ -765,24 +841,15 @@ void lrfront_query::Process()
 
 void lback_query::Run()
 {
-       RocksData result = this->Get(this->dest);
+       ListHeader header;
+       std::string member;
 
-       if (!result.status.ok())
+       if (!ReadHeader(this, header) || !ListEdge(this, header, true, member, this->response))
        {
                access_set(DBL_NOT_FOUND);
                return;
        }
 
-       std::shared_ptr<ListHandler> handler = ListHandler::Create(result.value);
-
-       this->response = handler->Back();
-
-       if (handler->GetLast() == HANDLER_MSG_NOT_FOUND)
-       {
-             access_set(DBL_NOT_FOUND);
-             return;
-       }
-
        this->SetOK();
 }
 
@@ -793,24 +860,15 @@ void lback_query::Process()
 
 void lfront_query::Run()
 {
-       RocksData result = this->Get(this->dest);
+       ListHeader header;
+       std::string member;
 
-       if (!result.status.ok())
+       if (!ReadHeader(this, header) || !ListEdge(this, header, false, member, this->response))
        {
                access_set(DBL_NOT_FOUND);
                return;
        }
 
-       std::shared_ptr<ListHandler> handler = ListHandler::Create(result.value);
-
-       this->response = handler->Front();
-
-       if (handler->GetLast() == HANDLER_MSG_NOT_FOUND)
-       {
-             access_set(DBL_NOT_FOUND);
-             return;
-       }
-
        this->SetOK();
 }
 
@@ -821,29 +879,18 @@ void lfront_query::Process()
 
 void lpushnx_query::Run()
 {
-       RocksData query_result = this->Get(this->dest);
-
-       std::shared_ptr<ListHandler> handler = ListHandler::Create(query_result.value);
+       std::shared_ptr<ListHandler> handler = ListLoad(this);
        
        if (handler->Exist(this->value))
        {
               access_set(DBL_ENTRY_EXISTS);
               return;
        }
-       else
+       
+       if (!ListPush(this, this->value))
        {
-             handler->Add(this->value);
-             
-             if (this->Write(this->dest, handler->as_string()))
-             {
-                     this->SetOK();
-             }
-             else
-             {
-                     access_set(DBL_UNABLE_WRITE);
-             }
-             
-             return;
+              access_set(DBL_UNABLE_WRITE);
+              return;
        }
 
        this->SetOK();
@@ -856,15 +903,15 @@ void lpushnx_query::Process()
 
 void lavg_query::Run()
 {
-       RocksData result = this->Get(this->dest);
+       ListHeader header;
 
-       if (!result.status.ok())
+       if (!ReadHeader(this, header))
        {
                access_set(DBL_NOT_FOUND);
                return;
        }
 
-       std::shared_ptr<ListHandler> handler = ListHandler::Create(result.value);
+       std::shared_ptr<ListHandler> handler = ListLoad(this);
 
        if (!handler->IsNumeric())
        {
@@ -883,15 +930,15 @@ void lavg_query::Process()
 
 void lhigh_query::Run()
 {
-       RocksData result = this->Get(this->dest);
+       ListHeader header;
 
-       if (!result.status.ok())
+       if (!ReadHeader(this, header))
        {
                access_set(DBL_NOT_FOUND);
                return;
        }
 
-       std::shared_ptr<ListHandler> handler = ListHandler::Create(result.value);
+       std::shared_ptr<ListHandler> handler = ListLoad(this);
        
        if (!handler->IsNumeric())
        {
@@ -910,15 +957,15 @@ void lhigh_query::Process()
 
 void llow_query::Run()
 {
-       RocksData result = this->Get(this->dest);
+       ListHeader header;
 
-       if (!result.status.ok())
+       if (!ReadHeader(this, header))
        {
                access_set(DBL_NOT_FOUND);
                return;
        }
 
-       std::shared_ptr<ListHandler> handler = ListHandler::Create(result.value);
+       std::shared_ptr<ListHandler> handler = ListLoad(this);
 
        if (!handler->IsNumeric())
        {
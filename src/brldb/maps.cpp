@@ -16,6 +16,80 @@
 
 #include "brldb/map_handler.h"
 
+/* Reads the number of fields of the map a query points to. */
+
+static bool ReadCount(QueryBase* query, uint64_t& count)
+{
+       RocksData result = query->Get(query->dest);
+       return (result.status.ok() && from_map_header(result.value, count));
+}
+
+/* 
+ * Reads a single field.
+ * 
+ * @parameters:
+ *
+ *         · QueryBase: Query pointing to a map.
+ *         · string   : Field to read.
+ *         · string   : Value found.
+ *
+ * @return:
+ *
+ *         · bool: False if field is not defined.
+ */
+
+static bool FieldGet(QueryBase* query, const std::string& field, std::string& value)
+{
+       const std::string& member = to_member_prefix(query->key, query->select_query) + field;
+       return query->Read(member, &value).ok();
+}
+
+/* 
+ * Sets a field, creating the map if needed.
+ * 
+ * @parameters:
+ *
+ *         · QueryBase: Query pointing to a map.
+ *         · string   : Field to set.
+ *         · string   : Value to assign.
+ *         · bool     : False to fail if field is already defined.
+ *
+ * @return:
+ *
+ *         · DBL_CODE: DBL_NONE on success.
+ */
+
+static DBL_CODE FieldSet(QueryBase* query, const std::string& field, const std::string& value, bool overwrite)
+{
+       uint64_t count = 0;
+       const bool exists = ReadCount(query, count);
+       
+       std::string current;
+       const bool defined = (exists && FieldGet(query, field, current));
+       
+       if (defined && !overwrite)
+       {
+              return DBL_ENTRY_EXISTS;
+       }
+       
+       rocksdb::WriteBatch batch;
+       batch.Put(to_member_prefix(query->key, query->select_query) + field, value);
+
+       /* Header only changes when a field is added. */
+       
+       if (!defined)
+       {
+              batch.Put(query->dest, to_map_header(count + 1));
+       }
+       
+       if (!exists)
+       {
+              query->RegPut(batch, query->dest);
+       }
+       
+       return (query->Commit(batch) ? DBL_NONE : DBL_UNABLE_WRITE);
+}
+
 void hfind_query::Run()
 {
        StringVector result;
@@ -25,9 +99,10 @@ void hfind_query::Run()
 
        std::string rawmap;
        
-       rocksdb::Iterator* it = this->database->GetAddress()->NewIterator(rocksdb::ReadOptions());
+       const std::string& prefix = to_prefix(this->select_query, INT_MAP);
+       std::unique_ptr<rocksdb::Iterator> it = this->Scan(prefix);
        
-       for (it->SeekToFirst(); it->Valid(); it->Next()) 
+       for (; it->Valid() && it->key().starts_with(prefix); it->Next())
        {
                 if (!Dispatcher::CheckIterator(this))
                 {
@@ -35,64 +110,16 @@ void hfind_query::Run()
                 }
                 
                 rawmap = it->key().ToString();
-                engine::colon_node_stream stream(rawmap);
-                std::string token;
-                unsigned int strcounter = 0;
-                bool skip = false;
-                
-                std::string key_as_string;
-                
-                while (stream.items_extract(token))
-                {       
-                        if (skip)
-                        {
-                            break;
-                        }
-                        
-                        switch (strcounter)
-                        {
-                             case 0:
-                             {
-                                  key_as_string = to_string(token);
-                                
-                                  if (!Daemon::Match(key_as_string, this->key))
-                                  {
-                                       skip = true;
-                                  }
-                             }
-                             
-                             break;
-                             
-                             case 1:
-                             {
-                                   if (convto_string(this->select_query) != token)
-                                   {
-                                        skip = true;
-                                   }
-                             }
-                             
-                             break;
-                             
-                             case 2:
-                             {
-                                  if (token != INT_MAP)
-                                  {
-                                         skip = true;   
-                                  }
-                             }
-                             
-                             break;
-                             
-                             default:
-                             {
-                                 break;   
-                             }                                     
-                        }
-                        
-                        strcounter++;
+                KeyData parsed;
+
+                if (!from_dest(rawmap, parsed))
+                {
+                        continue;
                 }
-                
-                if (skip)
+
+                const std::string& key_as_string = parsed.key;
+
+                if (!Daemon::Match(key_as_string, this->key))
                 {
                         continue;
                 }
@@ -110,6 +137,7 @@ void hfind_query::Run()
                                                 std::shared_ptr<hfind_query> request = std::make_shared<hfind_query>();
                                                 request->user = this->user;
                                                 request->partial = true;                                  
+                                                request->slot = this->slot;
                                                 request->key    = this->key;
                                                 
                                                 request->subresult = tracker;
@@ -136,6 +164,7 @@ void hfind_query::Run()
                                         std::shared_ptr<hfind_query> request = std::make_shared<hfind_query>();
                                         request->user = this->user;
                                         request->partial = true;
+                                        request->slot = this->slot;
                                         request->key    = this->key;
                                         request->subresult = tracker;
                                         request->VecData = result;
@@ -168,43 +197,15 @@ void hset_query::Run()
                return;
        }
        
-       RocksData resultq = this->Get(this->dest);
+       const DBL_CODE status = FieldSet(this, this->hesh, this->value, true);
        
-       std::shared_ptr<MapHandler> handler;
-       
-       if (!resultq.status.ok())
+       if (status != DBL_NONE)
        {
-               handler = std::make_shared<MapHandler>();
-               handler->Add(this->hesh, this->value);
-               
-               if (handler->GetLast() == HANDLER_MSG_OK)
-               {
-                    if (this->Write(this->dest, handler->as_string()))
-                    {
-                        this->SetOK();
-                    }
-               }
-               else
-               {
-                        access_set(DBL_UNABLE_WRITE);
-               }
-               
+               access_set(status);
                return;
        }
        
-       handler = MapHandler::Create(resultq.value);
-       handler->Add(this->hesh, this->value);
-       
-       if (handler->GetLast() == HANDLER_MSG_OK)
-       {
-            if (this->Write(this->dest, handler->as_string()))
-            {
-                   this->SetOK();
-                   return;
-            }
-        }
-      
-        access_set(DBL_UNABLE_WRITE);
+       this->SetOK();
 }
 
 void hset_query::Process()
@@ -214,32 +215,21 @@ void hset_query::Process()
 
 void hsetnx_query::Run()
 {
-       RocksData resultq = this->Get(this->dest);
-
-       std::shared_ptr<MapHandler> handler = MapHandler::Create(resultq.value);
-
-       if (resultq.status.ok())
+       if (this->hesh.empty())
        {
-               if (handler->Exists(this->hesh))
-               {
-                    access_set(DBL_ENTRY_EXISTS);
-                    return;
-               }
+               this->access_set(DBL_MISS_ARGS);
+               return;
        }
+
+       const DBL_CODE status = FieldSet(this, this->hesh, this->value, false);
        
-       handler->Add(this->hesh, this->value);
-
-       if (handler->GetLast() == HANDLER_MSG_OK)
-       {  
-                 if (this->Write(this->dest, handler->as_string()))
-                 {
-                      this->SetOK();
-                 }
-       }
-       else
+       if (status != DBL_NONE)
        {
-            access_set(DBL_UNABLE_WRITE);
+               access_set(status);
+               return;
        }
+       
+       this->SetOK();
 }
 
 void hsetnx_query::Process()
@@ -255,18 +245,13 @@ void hexists_query::Run()
                 return;
        }
 
-       RocksData resultq = this->Get(this->dest);
+       std::string stored;
        
-       if (resultq.status.ok())
+       if (this->identified == INT_MAP && FieldGet(this, this->hesh, stored))
        {
-              std::shared_ptr<MapHandler> handler = MapHandler::Create(resultq.value);
-
-               if (handler->Exists(this->hesh))
-               {
-                    this->response = "1";
-                    this->SetOK();
-                    return;
-               }
+               this->response = "1";
+               this->SetOK();
+               return;
        }
        
        this->response = "0"; 
@@ -286,25 +271,16 @@ void hstrlen_query::Run()
                 return;
        }
 
-       RocksData result = this->Get(this->dest);
+       std::string stored;
 
-       if (!result.status.ok())
+       if (!FieldGet(this, this->hesh, stored))
        {
                access_set(DBL_NOT_FOUND);
                return;
        }
 
-       std::shared_ptr<MapHandler> handler = MapHandler::Create(result.value);
-       this->response = convto_string(handler->Strlen(this->hesh));
-       
-       if (handler->GetLast() == HANDLER_MSG_OK)
-       {
-               this->SetOK();
-       }
-       else
-       {
-               access_set(DBL_NOT_FOUND);
-       }
+       this->response = convto_string(stored.length());
+       this->SetOK();
 }
 
 void hstrlen_query::Process()
@@ -320,25 +296,13 @@ void hget_query::Run()
                 return;
        }
 
-       RocksData result = this->Get(this->dest);
-       
-       if (!result.status.ok())
+       if (!FieldGet(this, this->hesh, this->response))
        {
                access_set(DBL_NOT_FOUND);
                return;
        }
 
-       std::shared_ptr<MapHandler> handler = MapHandler::Create(result.value);
-       this->response = handler->Get(this->hesh);
-
-       if (handler->GetLast() == HANDLER_MSG_OK)
-       {
-               this->SetOK();
-       }
-       else
-       {
-               access_set(DBL_NOT_FOUND);
-       }
+       this->SetOK();
 }
 
 void hget_query::Process()
@@ -348,40 +312,33 @@ void hget_query::Process()
 
 void hdel_query::Run()
 {
-       RocksData result = this->Get(this->dest);
+       uint64_t count = 0;
+       std::string stored;
 
-       std::shared_ptr<MapHandler> handler = MapHandler::Create(result.value);
+       if (!ReadCount(this, count) || !FieldGet(this, this->hesh, stored))
+       {
+               access_set(DBL_NOT_FOUND);
+               return;
+       }
+
+       rocksdb::WriteBatch batch;
+       batch.Delete(to_member_prefix(this->key, this->select_query) + this->hesh);
 
-       if (handler->Get(this->hesh).empty())
+       if (count > 1)
        {
-               if (handler->GetLast() == HANDLER_MSG_NOT_FOUND)
-               {
-                          access_set(DBL_NOT_FOUND);
-                          return;
-                }
+               batch.Put(this->dest, to_map_header(count - 1));
        }
        else
        {
-               handler->Remove(this->hesh);
+               batch.Delete(this->dest);
+               this->RegDelete(batch, this->dest);
        }
 
-       if (handler->Count() > 0)
+       if (!this->Commit(batch))
        {
-               if (this->Write(this->dest, handler->as_string()))
-               {
-                     this->SetOK();
-               }
-               else
-               {
-                     access_set(DBL_UNABLE_WRITE);
-               }
-               
+               access_set(DBL_UNABLE_WRITE);
                return;
        }
-       else
-       {
-               this->Delete(this->dest);
-       } 
        
        this->SetOK();
 }
@@ -397,17 +354,27 @@ void hlist_query::Run()
        unsigned int aux_counter = 0;
        unsigned int tracker = 0;
        
-       RocksData query_result = this->Get(this->dest);
-       
-       std::shared_ptr<MapHandler> handler = MapHandler::Create(query_result.value);
+       if (this->flags == QUERY_FLAGS_COUNT)
+       {
+               uint64_t count = 0;
+               ReadCount(this, count);
+               
+               this->counter = count;
+               this->SetOK();
+               return;
+       }
        
-       DualMap result = handler->GetList();
+       const std::string& prefix = to_member_prefix(this->key, this->select_query);
+       std::unique_ptr<rocksdb::Iterator> it = this->Scan(prefix);
 
        StringVector result_return;
        
-       for (DualMap::iterator i = result.begin(); i != result.end(); ++i)
+       for (; it->Valid() && it->key().starts_with(prefix); it->Next())
        {
-                std::string hesh_as_string = i->first;
+                rocksdb::Slice field = it->key();
+                field.remove_prefix(prefix.size());
+                
+                std::string hesh_as_string = field.ToString();
                 
                 if (this->flags == QUERY_FLAGS_CORE)
                 {
@@ -416,12 +383,6 @@ void hlist_query::Run()
                        continue;
                 }
                 
-                if (this->flags == QUERY_FLAGS_COUNT)
-                {
-                      total_counter++;
-                      continue;
-                }
-                
                 if (this->limit != -1 && ((signed int)total_counter >= this->offset))
                 {
                              if (((signed int)aux_counter < limit))
@@ -434,11 +395,12 @@ void hlist_query::Run()
                                                 std::shared_ptr<hlist_query> request = std::make_shared<hlist_query>();
                                                 request->user = this->user;
                                                 request->partial = true;                                  
+                                                request->slot = this->slot;
                                                 request->key    = this->key;
                                                 
                                                 request->subresult = ++tracker;
                                                 request->VecData = result_return;
-                                                result.clear();
+                                                result_return.clear();
                                                 request->SetOK();
                                                 DataFlush::AttachResult(request);
                                       }
@@ -459,11 +421,12 @@ void hlist_query::Run()
                                         std::shared_ptr<hlist_query> request = std::make_shared<hlist_query>();
                                         request->user = this->user;
                                         request->partial = true;
+                                        request->slot = this->slot;
                                         request->key    = this->key;
                                         
                                         request->subresult = ++tracker;
                                         request->VecData = result_return;
-                                        result.clear();
+                                        result_return.clear();
                                         request->SetOK();
                                         DataFlush::AttachResult(request);
                              }
@@ -496,17 +459,14 @@ void hvals_query::Run()
        unsigned int aux_counter = 0;
        unsigned int tracker = 0;
        
-       RocksData query_result = this->Get(this->dest);
-       
-       std::shared_ptr<MapHandler> handler = MapHandler::Create(query_result.value);
-       
-       StringVector result = handler->GetValues();
+       const std::string& prefix = to_member_prefix(this->key, this->select_query);
+       std::unique_ptr<rocksdb::Iterator> it = this->Scan(prefix);
 
        StringVector result_return;
        
-       for (StringVector::iterator i = result.begin(); i != result.end(); ++i)
+       for (; it->Valid() && it->key().starts_with(prefix); it->Next())
        {
-                std::string hesh_as_string = (*i);
+                std::string hesh_as_string = it->value().ToString();
                 
                 if (this->limit != -1 && ((signed int)total_counter >= this->offset))
                 {
@@ -520,11 +480,12 @@ void hvals_query::Run()
                                                 std::shared_ptr<hvals_query> request = std::make_shared<hvals_query>();
                                                 request->user = this->user;
                                                 request->partial = true;                                  
+                                                request->slot = this->slot;
                                                 request->subresult = ++tracker;
                                                 request->key    = this->key;
                                                 
                                                 request->VecData = result_return;
-                                                result.clear();
+                                                result_return.clear();
                                                 request->SetOK();
                                                 DataFlush::AttachResult(request);
                                       }
@@ -545,11 +506,12 @@ void hvals_query::Run()
                                         std::shared_ptr<hvals_query> request = std::make_shared<hvals_query>();
                                         request->user = this->user;
                                         request->partial = true;
+                                        request->slot = this->slot;
                                         request->key    = this->key;
                                         
                                         request->subresult = ++tracker;
                                         request->VecData = result_return;
-                                        result.clear();
+                                        result_return.clear();
                                         request->SetOK();
                                         DataFlush::AttachResult(request);
                              }
@@ -576,18 +538,18 @@ void hgetall_query::Run()
        unsigned int aux_counter = 0;
        unsigned int tracker = 0;
        
-       RocksData query_result = this->Get(this->dest);
-       
-       std::shared_ptr<MapHandler> handler = MapHandler::Create(query_result.value);
-       
-       DualMap result = handler->GetAll();
+       const std::string& prefix = to_member_prefix(this->key, this->select_query);
+       std::unique_ptr<rocksdb::Iterator> it = this->Scan(prefix);
 
        std::multimap<std::string, std::string> result_return;
        
-       for (DualMap::iterator i = result.begin(); i != result.end(); ++i)
+       for (; it->Valid() && it->key().starts_with(prefix); it->Next())
        {
-                std::string vkey = i->first;
-                std::string vvalue = i->second;
+                rocksdb::Slice field = it->key();
+                field.remove_prefix(prefix.size());
+                
+                std::string vkey = field.ToString();
+                std::string vvalue = it->value().ToString();
                 
                 if (this->limit != -1 && ((signed int)total_counter >= this->offset))
                 {
@@ -601,9 +563,10 @@ void hgetall_query::Run()
                                                 std::shared_ptr<hgetall_query> request = std::make_shared<hgetall_query>();
                                                 request->user = this->user;
                                                 request->partial = true;                                  
+                                                request->slot = this->slot;
                                                 request->subresult = ++tracker;
                                                 request->mmap = result_return;
-                                                result.clear();
+                                                result_return.clear();
                                                 request->SetOK();
                                                 DataFlush::AttachResult(request);
                                       }
@@ -624,9 +587,10 @@ void hgetall_query::Run()
                                         std::shared_ptr<hgetall_query> request = std::make_shared<hgetall_query>();
                                         request->user = this->user;
                                         request->partial = true;
+                                        request->slot = this->slot;
                                         request->subresult = ++tracker;
                                         request->mmap = result_return;
-                                        result.clear();
+                                        result_return.clear();
                                         request->SetOK();
                                         DataFlush::AttachResult(request);
                              }
@@ -635,6 +599,8 @@ void hgetall_query::Run()
                 total_counter++;
     }
 
+     this->EndPage(it.get(), prefix);
+
      this->subresult = ++tracker;
      this->partial = false;
      this->counter = total_counter;
@@ -646,5 +612,3 @@ void hgetall_query::Process()
 {
      Dispatcher::MMapFlush(false, "Hash", "Value", this);
 }
-
-
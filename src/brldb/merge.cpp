@@ -0,0 +1,167 @@
+/*
+ * BerylDB - A lightweight database.
+ * http://www.beryldb.com
+ *
+ * Copyright (C) 2021 - Carlos F. Ferry <cferry@beryldb.com>
+ *
+ * This file is part of BerylDB. BerylDB is free software: you can
+ * redistribute it and/or modify it under the terms of the BSD License
+ * version 3.
+ *
+ * More information about our licensing can be found at https://docs.beryl.dev
+ */
+
+#include <math.h>
+
+#include "beryl.h"
+#include "brldb/merge.h"
+
+double apply_op(OP_TYPE operation, double current, double oper)
+{
+        switch (operation)
+        {
+              case OP_INCR:
+
+                     return current + 1;
+
+              case OP_DECR:
+
+                     return current - 1;
+
+              case OP_MULT:
+
+                     return current * oper;
+
+              case OP_AVG:
+
+                     return (current + oper) / 2;
+
+              case OP_DIV:
+
+                     return double(current / oper);
+
+              case OP_ADD:
+
+                     return current + oper;
+
+              case OP_MIN:
+
+                     return current - oper;
+
+              case OP_SQRT:
+
+                     return std::sqrt(current);
+
+              default:
+
+                     return current;
+        }
+}
+
+/*
+ * Applies a single operand to a value.
+ *
+ * @parameters:
+ *
+ *         · string: Operand to apply.
+ *         · bool  : Whether an entry exists.
+ *         · string: Stored value, updated.
+ */
+
+static void MergeOne(const rocksdb::Slice& operand, bool& exists, std::string& value)
+{
+        if (operand.empty())
+        {
+              return;
+        }
+
+        const std::string payload(operand.data() + 1, operand.size() - 1);
+
+        switch (operand[0])
+        {
+              case MERGE_NUMERIC:
+              {
+                     if (payload.size() != 9)
+                     {
+                            return;
+                     }
+
+                     double number = 0;
+
+                     /* Non-numeric entries are rejected before writing, keep them untouched. */
+
+                     if (exists && !from_number_value(value, number))
+                     {
+                            return;
+                     }
+
+                     const uint64_t bits = codec_get_fixed64(payload, 1);
+                     double oper = 0;
+                     std::memcpy(&oper, &bits, sizeof(oper));
+
+                     /* Unknown operations and results that are not a number are skipped. */
+
+                     if (payload[0] < OP_INCR || payload[0] > OP_SQRT)
+                     {
+                            return;
+                     }
+
+                     const double result = apply_op(static_cast<OP_TYPE>(payload[0]), number, oper);
+
+                     if (!std::isfinite(result))
+                     {
+                            return;
+                     }
+
+                     value = to_number_value(result);
+                     break;
+              }
+
+              case MERGE_PUSH:
+              {
+                     size_t pos = 0;
+
+                     if (!exists)
+                     {
+                            value = to_fields();
+                     }
+                     else if (!from_fields(value, pos))
+                     {
+                            return;
+                     }
+
+                     codec_put_field(value, payload);
+                     break;
+              }
+
+              default:
+
+                     return;
+        }
+
+        exists = true;
+}
+
+bool ValueMerge::FullMergeV2(const MergeOperationInput& merge_in, MergeOperationOutput* merge_out) const
+{
+        bool exists = (merge_in.existing_value != NULL);
+        std::string value = (exists ? merge_in.existing_value->ToString() : "");
+
+        /* Expiring keys keep their deadline. */
+        
+        const time_t deadline = value_deadline(value);
+        value = strip_deadline(value);
+
+        for (std::vector<rocksdb::Slice>::const_iterator i = merge_in.operand_list.begin(); i != merge_in.operand_list.end(); ++i)
+        {
+              MergeOne(*i, exists, value);
+        }
+
+        if (deadline)
+        {
+              value = to_expiring(deadline, value);
+        }
+
+        merge_out->new_value.swap(value);
+        return true;
+}
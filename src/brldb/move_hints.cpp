@@ -12,24 +12,25 @@
  */
 
 #include "beryl.h"
+#include "brldb/keylocks.h"
 #include "helpers.h"
 
 void move_query::Keys()
 {
      RocksData result = this->Get(this->dest);
      
-     const std::string& newdest = to_bin(this->key) + ":" + this->value + ":" + this->identified;
-     const std::string& lookup = to_bin(this->key) + ":" + this->value + ":" + INT_EXPIRE + ":" + this->database->GetName();
+     const std::string& newdest = to_dest(this->key, convto_num<unsigned int>(this->value), this->identified);
+     const std::string& lookup = to_dest(this->key, convto_num<unsigned int>(this->value), INT_EXPIRE);
 
      rocksdb::WriteBatch batch;
 
-     batch.Put(newdest, result.value);
      batch.Delete(this->dest);
-     batch.Put(lookup, convto_string(this->id));
+     this->RegDelete(batch, this->dest);
+     batch.Put(newdest, to_expiring(this->id, result.value));
+     this->RegPut(batch, newdest);
+     batch.Put(lookup, to_number_value(this->id));
 
-     rocksdb::Status stats = this->database->GetAddress()->Write(rocksdb::WriteOptions(), &batch);
-
-     if (stats.ok())
+     if (this->Commit(batch))
      {
              Kernel->Store->Expires->Delete(this->database, this->key, this->select_query);
              Kernel->Store->Expires->Add(this->database, this->id, this->key, convto_num<unsigned int>(this->value), true);
@@ -66,6 +67,12 @@ void move_query::Vectors()
 
 }
 
+void move_query::Stripes(std::vector<size_t>& locked)
+{
+       QueryBase::Stripes(locked);
+       locked.push_back(KeyLocks::Stripe(this->database, convto_num<unsigned int>(this->value), this->key));
+}
+
 void move_query::Run()
 {
     if (this->identified == INT_KEY)
@@ -101,7 +108,7 @@ void move_query::Run()
     }   
     
     RocksData result = this->Get(this->dest);
-    const std::string& newdest = to_bin(this->key) + ":" + this->value + ":" + this->identified;
+    const std::string& newdest = to_dest(this->key, convto_num<unsigned int>(this->value), this->identified);
     
     if (!this->Swap(newdest, this->dest, result.value))
     {
@@ -16,6 +16,7 @@
 #include "beryl.h"
 #include "engine.h"
 #include "brldb/multimap_handler.h"
+#include "brldb/codec.h"
 
 MultiMapHandler::MultiMapHandler()
 {
@@ -78,15 +79,18 @@ std::shared_ptr<MultiMapHandler> MultiMapHandler::Create(const std::string& load
 {
         std::shared_ptr<MultiMapHandler> New = std::make_shared<MultiMapHandler>();
 
-        engine::colon_node_stream stream(load);
-        std::string mask;
+        size_t pos = 0;
+        std::string path;
+        std::string file;
 
-        while (stream.items_extract(mask))
+        if (!from_fields(load, pos))
         {
-              size_t found =  mask.find_first_of("/");
-              std::string path = mask.substr(0,found);
-              std::string file = mask.substr(found+1);
-              New->Add(to_string(path), to_string(file));
+              return New;
+        }
+
+        while (pos < load.size() && codec_get_field(load, pos, path) && codec_get_field(load, pos, file))
+        {
+              New->Add(path, file);
         }
 
         return New;
@@ -145,23 +149,12 @@ void MultiMapHandler::Remove(const std::string& key)
 
 std::string MultiMapHandler::as_string()
 {
-        std::string final;
-        
-        unsigned int size = this->mhandler.size();
-        
-        unsigned int counter = 0;
+        std::string final = to_fields();
         
         for (MultiMap::const_iterator i = this->mhandler.begin(); i != this->mhandler.end(); ++i)      
         {
-                  std::string key = i->first;
-                  std::string value = i->second;
-                  
-                  if (counter != size)
-                  {
-                        final += to_bin(key) + "/" + to_bin(value) + ":";
-                  }
-                  
-                  counter++;
+                  codec_put_field(final, i->first);
+                  codec_put_field(final, i->second);
         }
         
         return final;
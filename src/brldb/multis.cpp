@@ -172,14 +172,15 @@ void mkeys_query::Run()
 {
        StringVector result;
 
-       rocksdb::Iterator* it = this->database->GetAddress()->NewIterator(rocksdb::ReadOptions());
+       const std::string& prefix = to_prefix(this->select_query, this->base_request);
+       std::unique_ptr<rocksdb::Iterator> it = this->Scan(prefix);
        std::string rawmap;
        
        unsigned int aux_counter = 0;
        unsigned int total_counter = 0;
        unsigned int tracker = 0;
        
-       for (it->SeekToFirst(); it->Valid(); it->Next()) 
+       for (; it->Valid() && it->key().starts_with(prefix); it->Next())
        {
                 if (!Dispatcher::CheckIterator(this))
                 {
@@ -188,66 +189,16 @@ void mkeys_query::Run()
 
                 rawmap = it->key().ToString();
                 
-                engine::colon_node_stream stream(rawmap);
-                std::string token;
+                KeyData parsed;
 
-                unsigned int strcounter = 0;
-                bool skip = false;
-
-                std::string key_as_string;
-                std::string aux;
-                
-                while (stream.items_extract(token))
+                if (!from_dest(rawmap, parsed))
                 {
-                        if (skip)
-                        {
-                               break;
-                        }
-                        
-                        switch (strcounter)
-                        {
-                             case 0:
-                             {
-                                  key_as_string = to_string(token);
-
-                                  if (!Daemon::Match(key_as_string, this->key))                                  
-                                  {
-                                         skip = true;
-                                  }
-                             }
-
-                             break;
-
-                             case 1:
-                             {
-                                  if (convto_string(this->select_query) != token)
-                                  {
-                                       skip = true;
-                                  }
-                             }
-
-                             break;
-                             
-                             case 2:
-                             {
-                                    if (this->base_request != token)
-                                    {
-                                        skip = true;
-                                    }
-                             }
-
-                             break;
-                      
-                             default:
-                             {
-                                 break;   
-                             }
-                        }
-
-                        strcounter++;
+                        continue;
                 }
 
-                if (skip)
+                const std::string& key_as_string = parsed.key;
+
+                if (!Daemon::Match(key_as_string, this->key))
                 {
                         continue;
                 }
@@ -264,6 +215,7 @@ void mkeys_query::Run()
                                                 std::shared_ptr<mkeys_query> request = std::make_shared<mkeys_query>();
                                                 request->user = this->user;
                                                 request->partial = true;                                  
+                                                request->slot = this->slot;
                                                 request->subresult = ++tracker;
                                                 request->VecData = result;
                                                 result.clear();
@@ -287,6 +239,7 @@ void mkeys_query::Run()
                                         std::shared_ptr<mkeys_query> request = std::make_shared<mkeys_query>();
                                         request->user = this->user;
                                         request->partial = true;
+                                        request->slot = this->slot;
                                         request->subresult = ++tracker;
                                         request->VecData = result;
                                         result.clear();
@@ -298,6 +251,9 @@ void mkeys_query::Run()
                 total_counter++;
        }  
        
+
+       this->EndPage(it.get(), prefix);
+
        this->subresult = ++tracker;
        this->partial = false;
        this->counter = aux_counter;
@@ -359,6 +315,7 @@ void mget_query::Run()
                                                 std::shared_ptr<mget_query> request = std::make_shared<mget_query>();
                                                 request->user = this->user;
                                                 request->partial = true;                                  
+                                                request->slot = this->slot;
                                                 request->subresult = ++tracker;
                                                 request->VecData = result_return;
                                                 result.clear();
@@ -382,6 +339,7 @@ void mget_query::Run()
                                         std::shared_ptr<mget_query> request = std::make_shared<mget_query>();
                                         request->user = this->user;
                                         request->partial = true;
+                                        request->slot = this->slot;
                                         request->subresult = ++tracker;
                                         request->VecData = result_return;
                                         result.clear();
@@ -456,6 +414,7 @@ void mvals_query::Run()
                                                 std::shared_ptr<hvals_query> request = std::make_shared<hvals_query>();
                                                 request->user = this->user;
                                                 request->partial = true;                                  
+                                                request->slot = this->slot;
                                                 request->subresult = ++tracker;
                                                 request->VecData = result_return;
                                                 result.clear();
@@ -479,6 +438,7 @@ void mvals_query::Run()
                                         std::shared_ptr<hvals_query> request = std::make_shared<hvals_query>();
                                         request->user = this->user;
                                         request->partial = true;
+                                        request->slot = this->slot;
                                         request->subresult = ++tracker;
                                         request->VecData = result_return;
                                         result.clear();
@@ -533,6 +493,7 @@ void mgetall_query::Run()
                                                 std::shared_ptr<mgetall_query> request = std::make_shared<mgetall_query>();
                                                 request->user = this->user;
                                                 request->partial = true;                                  
+                                                request->slot = this->slot;
                                                 request->subresult = ++tracker;
                                                 request->mmap = result_return;
                                                 result.clear();
@@ -556,6 +517,7 @@ void mgetall_query::Run()
                                         std::shared_ptr<mgetall_query> request = std::make_shared<mgetall_query>();
                                         request->user = this->user;
                                         request->partial = true;
+                                        request->slot = this->slot;
                                         request->subresult = ++tracker;
                                         request->mmap = result_return;
                                         result.clear();
@@ -609,6 +571,7 @@ void miter_query::Run()
                                                 std::shared_ptr<miter_query> request = std::make_shared<miter_query>();
                                                 request->user = this->user;
                                                 request->partial = true;
+                                                request->slot = this->slot;
                                                 request->subresult = ++tracker;
                                                 request->VecData = result_return;
                                                 result.clear();
@@ -632,6 +595,7 @@ void miter_query::Run()
                                         std::shared_ptr<miter_query> request = std::make_shared<miter_query>();
                                         request->user = this->user;
                                         request->partial = true;
+                                        request->slot = this->slot;
                                         request->subresult = ++tracker;
                                         request->VecData = result_return;
                                         result.clear();
@@ -20,27 +20,26 @@
 #include "brldb/query.h"
 #include "brldb/dbnumeric.h"
 #include "brldb/dbmanager.h"
+#include "brldb/keylocks.h"
+#include "brldb/merge.h"
 #include "helpers.h"
 
 void dbsize_query::Run()
 {
-    rocksdb::Iterator* it = this->database->GetAddress()->NewIterator(rocksdb::ReadOptions());
-    std::string rawmap;
-    double size_calc = 0;
-
-    for (it->SeekToFirst(); it->Valid(); it->Next()) 
-    {
-            if (!Dispatcher::CheckIterator(this))
-            {
-                    return;
-            }
+    /* Estimated by RocksDB from table files and memtables, entries are not read. */
+    
+    const std::string last(KEY_PREFIX_LENGTH, '\xff');
+    const rocksdb::Range everything("", last);
+    
+    uint64_t bytes = 0;
     
-            /* We directly count byte size from binary keys/values. */
-            
-            size_calc += it->key().size() + 2;
-            size_calc += it->value().size() + 2;  
+    if (!this->database->GetAddress()->GetApproximateSizes(&everything, 1, &bytes, rocksdb::DB::SizeApproximationFlags::INCLUDE_FILES | rocksdb::DB::SizeApproximationFlags::INCLUDE_MEMTABLES).ok())
+    {
+          this->database->GetAddress()->GetIntProperty("rocksdb.estimate-live-data-size", &bytes);
     }
     
+    double size_calc = static_cast<double>(bytes);
+    
     float as_mb = size_calc / 1024 / 1024;
     
     if (as_mb <= 1)
@@ -89,94 +88,33 @@ void op_query::Run()
 {    
     double real_oper = 0;
     
-    std::string oper;
-    std::string dbvalue;
-    
     if (!this->value.empty())
     {
-         oper = this->value;
-         real_oper = convto_num<double>(oper);
+         real_oper = convto_num<double>(this->value);
     }
 
-    RocksData result = this->Get(this->dest);
-    this->response = to_string(result.value);
+    double real_value = 0;
   
-    if (!result.status.ok())
-    {
-          /* dbvalue not found, so we start it at 0 */
+    /* dbvalue not found, so we start it at 0 */
 
-          dbvalue = "0";
-    }
-    else
+    if (this->identified != PROCESS_NULL)
     {
-          dbvalue = to_string(result.value);
-    }
+          RocksData result = this->Get(this->dest);
 
-    if (!is_number(dbvalue, true))
-    {
-          this->access_set(DBL_NOT_NUM);
-          return;
+          if (result.status.ok() && !from_number_value(result.value, real_value))
+          {
+                this->access_set(DBL_NOT_NUM);
+                return;
+          }
     }
-        
-    double real_value = convto_num<double>(dbvalue);
-
-    switch (this->operation)
-    {
-        case OP_INCR:
-            
-                real_value++;
-        break;
-        
-        case OP_DECR:
-                
-                real_value--;
-        break;
-        
-        case OP_MULT:
-            
-            real_value = real_value * real_oper;
-            
-        break;
-        
-        case OP_AVG:
 
-                real_value = (real_value + real_oper) / 2;
-                
-        break;
-        
-        case OP_DIV:
-
-                real_value = double(real_value / real_oper);
-        break;
-        
-        
-        case OP_ADD:
-            
-                real_value += real_oper;
-        break;
-        
-        case OP_MIN:
-            
-                real_value -= real_oper;
-        break;
-        
-        case OP_SQRT:
-        
-               real_value = std::sqrt(real_value);
-        break;
-        
-        default:
-        
-         break;
-        
-    }
-    
-    std::string inserting = convto_string(real_value);        
-    std::string newvalue = to_bin(inserting);
+    /* Value is already read to reply with it, so it is rewritten in place. */
     
-    if (this->Write(this->dest, newvalue))
+    const double total = apply_op(this->operation, real_value, real_oper);
+
+    if (this->Write(this->dest, to_number_value(total)))
     {
-             this->response = inserting;
+             this->response = convto_string(total);
              this->SetOK();
     }
     else
@@ -194,62 +132,34 @@ void op_query::Process()
         }
 }
 
+void sflush_query::Stripes(std::vector<size_t>& locked)
+{
+     KeyLocks::All(locked);
+}
+
 void sflush_query::Run()
 {
-     rocksdb::Iterator* it = this->database->GetAddress()->NewIterator(rocksdb::ReadOptions());
+     const unsigned int select = convto_num<unsigned int>(this->key);
+     
+     rocksdb::WriteBatch batch;
 
-     for (it->SeekToFirst(); it->Valid(); it->Next()) 
+     /* Every type keeps this select in a single range. */
+     
+     for (std::vector<std::string>::const_iterator iter = TypeRegs.begin(); iter != TypeRegs.end(); ++iter)
      {
-                if (!Dispatcher::CheckIterator(this))
-                {
-                       return;
-                }
-                
-                std::string rawmap = it->key().ToString();
-                
-                engine::colon_node_stream stream(rawmap);
-                std::string token;
-
-                unsigned int strcounter = 0;
-                bool skip = false;
-                
-               while (stream.items_extract(token))
-               {
-                        if (skip)
-                        {
-                            break;
-                        }
-                     
-                        switch (strcounter)
-                        {
-                             case 1:
-                             {
-                                   if (this->key != token)
-                                   {
-                                          skip = true;
-                                   }
-                             }
-                             
-                             break;
-                             
-                             default:
-                             {
-                                 break;   
-                             }                                     
-                        }
-                        
-                        strcounter++;
-                }
-                
-                if (skip)
-                {
-                        continue;
-                }
-                
-                this->Delete(rawmap);
-    }    
+            batch.DeleteRange(to_prefix(select, *iter), to_prefix(select + 1, *iter));
+     }
+     
+     batch.DeleteRange(to_prefix(select, INT_REG), to_prefix(select + 1, INT_REG));
+     batch.DeleteRange(to_prefix(select, INT_MEMBER), to_prefix(select + 1, INT_MEMBER));
+     
+     if (!this->Commit(batch))
+     {
+            access_set(DBL_UNABLE_WRITE);
+            return;
+     }
      
-    this->SetOK();	
+     this->SetOK();	
 }
 
 void sflush_query::Process()
@@ -258,26 +168,54 @@ void sflush_query::Process()
         sfalert(user, NOTIFY_DEFAULT, "SFlushed database: %s", user->GetDatabase()->GetName().c_str());
 }
 
-void touch_query::Run()
+/* 
+ * Looks up the registry entries of a space separated key list at once.
+ * 
+ * @parameters:
+ *
+ *         · QueryBase : Query running.
+ *         · uint      : Total keys given, returned.
+ *
+ * @return:
+ *
+ *         · uint      : Keys defined.
+ */
+
+static unsigned int CountDefined(QueryBase* query, unsigned int& total)
 {
-        engine::space_node_stream tlist(this->value);
+        engine::space_node_stream tlist(query->value);
         std::string token;
 
-        unsigned int touch_count = 0;
+        StringVector regs;
 
         while (tlist.items_extract(token))
         {
-                unsigned int result =  this->CheckDest(this->select_query, token, this->base_request);
+                regs.push_back(to_dest(token, query->select_query, INT_REG));
+        }
+
+        StringVector values;
+        std::vector<rocksdb::Status> statuses;
+        query->ReadMany(regs, values, statuses);
 
-                if (result == 0)
+        unsigned int defined = 0;
+
+        for (std::vector<rocksdb::Status>::const_iterator i = statuses.begin(); i != statuses.end(); ++i)
+        {
+                if (i->ok())
                 {
-                        continue;
+                        defined++;
                 }
-
-                touch_count++;
         }
 
-        this->counter = touch_count;
+        total = regs.size();
+        return defined;
+}
+
+void touch_query::Run()
+{
+        unsigned int total = 0;
+
+        this->counter = CountDefined(this, total);
         this->SetOK();
 }
 
@@ -288,24 +226,10 @@ void touch_query::Process()
 
 void ntouch_query::Run()
 {
-        engine::space_node_stream tlist(this->value);
-        std::string token;
-        
-        unsigned int n_touch_count = 0;
-
-        while (tlist.items_extract(token))
-        {    
-                unsigned int result =  this->CheckDest(this->select_query, token, this->base_request);
-                
-                if (result != 0)
-                {
-                        continue;
-                }
+        unsigned int total = 0;
+        const unsigned int defined = CountDefined(this, total);
 
-                n_touch_count++;
-        }        
-
-        this->counter = n_touch_count;
+        this->counter = total - defined;
         this->SetOK();
 }
 
@@ -320,68 +244,11 @@ void list_query::Run()
 
        for (std::vector<std::string>::const_iterator iter = TypeRegs.begin(); iter != TypeRegs.end(); ++iter)
        {
-              std::string ltype = *iter;
-              result[ltype] = 0;
+              result[*iter] = this->database->Counter(this->select_query, *iter);
        }
-
-       rocksdb::Iterator* it = this->database->GetAddress()->NewIterator(rocksdb::ReadOptions());
-
-       for (it->SeekToFirst(); it->Valid(); it->Next()) 
-       {
-                if (!Dispatcher::CheckIterator(this))
-                {
-                       return;
-                }
-
-                std::string rawmap = it->key().ToString();
-                std::string rawvalue = to_string(it->value().ToString());
-                         
-                engine::colon_node_stream stream(rawmap);
-                std::string token;
-                unsigned int strcounter = 0;
-                bool skip = false;
-
-                std::string key_as_string;
                 
-                while (stream.items_extract(token))
-                {
-                        if (skip)
-                        {
-                            break;
-                        }
-
-                        switch (strcounter)
-                        {
-
-                             case 1:
-                             {
-                                   if (convto_string(this->select_query) != token)
-                                   {
-                                        skip = true;
-                                   }
-                             }
-
-                             break;
-                             
-                             case 2:
-                             {
-                                  result[token]++; 
-                             }
-
-                             break;
-
-                             default:
-                             {
-                                 break;   
-                             }
-                        }
-
-                        strcounter++;
-                }
-    }
-                
-    this->nmap = result;
-    this->SetOK();
+       this->nmap = result;
+       this->SetOK();
 }
 
 void list_query::Process()
@@ -408,61 +275,10 @@ void total_query::Run()
 {
        unsigned int total_counter = 0;
        
-       rocksdb::Iterator* it = this->database->GetAddress()->NewIterator(rocksdb::ReadOptions());
-
-       for (it->SeekToFirst(); it->Valid(); it->Next()) 
+       for (std::vector<std::string>::const_iterator iter = TypeRegs.begin(); iter != TypeRegs.end(); ++iter)
        {
-                if (!Dispatcher::CheckIterator(this))
-                {
-                       return;
-                }
-
-                std::string rawmap = it->key().ToString();
-                std::string rawvalue = to_string(it->value().ToString());
-                         
-                engine::colon_node_stream stream(rawmap);
-                std::string token;
-                unsigned int strcounter = 0;
-                bool skip = false;
-
-                std::string key_as_string;
-                
-                while (stream.items_extract(token))
-                {
-                        if (skip)
-                        {
-                            break;
-                        }
-
-                        switch (strcounter)
-                        {
-
-                             case 1:
-                             {
-                                   if (convto_string(this->select_query) != token)
-                                   {
-                                        skip = true;
-                                   }
-                             }
-
-                             break;
-                             
-                             default:
-                             {
-                                 break;   
-                             }
-                        }
-
-                        strcounter++;
-                }
-                
-                if (skip)
-                {
-                     continue;
-                }
-                
-                total_counter++;
-    }
+              total_counter += this->database->Counter(this->select_query, *iter);
+       }
                 
     this->counter = total_counter;
     this->SetOK();
@@ -479,65 +295,11 @@ void glist_query::Run()
 
        for (std::vector<std::string>::const_iterator iter = TypeRegs.begin(); iter != TypeRegs.end(); ++iter)
        {
-              std::string ltype = *iter;
-              result[ltype] = 0;
+              result[*iter] = this->database->Counter(*iter);
        }
-
-       rocksdb::Iterator* it = this->database->GetAddress()->NewIterator(rocksdb::ReadOptions());
-
-       for (it->SeekToFirst(); it->Valid(); it->Next()) 
-       {
-                if (!Dispatcher::CheckIterator(this))
-                {
-                       return;
-                }
-
-                std::string rawmap = it->key().ToString();
-                std::string rawvalue = to_string(it->value().ToString());
-                         
-                engine::colon_node_stream stream(rawmap);
-                std::string token;
-                unsigned int strcounter = 0;
-                bool skip = false;
-
-                std::string key_as_string;
                 
-                while (stream.items_extract(token))
-                {
-                        if (skip)
-                        {
-                            break;
-                        }
-
-                        switch (strcounter)
-                        {
-
-                             case 1:
-                             {
-                             
-                             }
-
-                             break;
-                             
-                             case 2:
-                             {
-                                  result[token]++; 
-                             }
-
-                             break;
-
-                             default:
-                             {
-                                 break;   
-                             }
-                        }
-
-                        strcounter++;
-                }
-    }
-                
-    this->nmap = result;
-    this->SetOK();
+       this->nmap = result;
+       this->SetOK();
 }
 
 void glist_query::Process()
@@ -11,8 +11,13 @@
  * More information about our licensing can be found at https://docs.beryl.dev
  */
 
+#include <algorithm>
+
+#include <rocksdb/utilities/write_batch_with_index.h>
+
 #include "beryl.h"
 #include "brldb/query.h"
+#include "brldb/keylocks.h"
 #include "brldb/dbmanager.h"
 
 bool QueryBase::Swap(const std::string& newdest, const std::string& ldest, const std::string& lvalue, std::shared_ptr<Database> db)
@@ -24,32 +29,35 @@ bool QueryBase::Swap(const std::string& newdest, const std::string& ldest, const
        
        rocksdb::WriteBatch batch;
 
-       batch.Put(newdest, lvalue);
        batch.Delete(ldest);
-       rocksdb::Status status = db->GetAddress()->Write(rocksdb::WriteOptions(), &batch);
+       this->RegDelete(batch, ldest);
+       batch.Put(newdest, lvalue);
+       this->RegPut(batch, newdest);
+       this->CopyMembers(batch, ldest, newdest);
+       this->DropMembers(batch, ldest);
        
-       if (status.ok())
+       if (db == this->database)
        {
-            return true;
+            return this->Commit(batch);
        }
        
-       return false;
+       return db->Commit(batch);
 }
 
 bool QueryBase::SwapWithExpire(const std::string& newdest, const std::string& ldest, const std::string& lvalue, unsigned int select, const std::string& lkey, unsigned int ttl, const std::string& oldkey)
 {
        rocksdb::WriteBatch batch;
 
-       batch.Put(newdest, lvalue);
        batch.Delete(ldest);
+       this->RegDelete(batch, ldest);
+       batch.Put(newdest, to_expiring(ttl, lvalue));
+       this->RegPut(batch, newdest);
        
-       const std::string& lookup = to_bin(lkey) + ":" + convto_string(select) + ":" + INT_EXPIRE + ":" + this->database->GetName();
+       const std::string& lookup = to_dest(lkey, select, INT_EXPIRE);
 
-       batch.Put(lookup, convto_string(ttl));
+       batch.Put(lookup, to_number_value(ttl));
 
-       rocksdb::Status stats = this->database->GetAddress()->Write(rocksdb::WriteOptions(), &batch);
-
-       if (stats.ok())
+       if (this->Commit(batch))
        {
              Kernel->Store->Expires->Delete(this->database, oldkey, select);
              Kernel->Store->Expires->Add(this->database, ttl, lkey, select, true);
@@ -63,14 +71,13 @@ bool QueryBase::SwapWithExpire(const std::string& newdest, const std::string& ld
 void QueryBase::ExpireBatch(const std::string& wdest, const std::string& lvalue, const std::string& e_key, unsigned int select, unsigned int ttl)
 {
        rocksdb::WriteBatch batch;
-       std::string lookup = to_bin(e_key) + ":" + convto_string(select) + ":" + INT_EXPIRE + ":" + this->database->GetName();
-       
-       batch.Put(lookup, convto_string(ttl));
-       batch.Put(wdest, to_bin(lvalue));
+       std::string lookup = to_dest(e_key, select, INT_EXPIRE);
        
-       rocksdb::Status stats = this->database->GetAddress()->Write(rocksdb::WriteOptions(), &batch);
+       batch.Put(lookup, to_number_value(ttl));
+       batch.Put(wdest, to_expiring(ttl, to_value(lvalue)));
+       this->RegPut(batch, wdest);
        
-       if (stats.ok())
+       if (this->Commit(batch))
        {
             Kernel->Store->Expires->Add(this->database, ttl, e_key, select, true);
        }
@@ -78,19 +85,310 @@ void QueryBase::ExpireBatch(const std::string& wdest, const std::string& lvalue,
 
 bool QueryBase::Write(const std::string& wdest, const std::string& lvalue)
 {
-       rocksdb::Status status = this->database->GetAddress()->Put(rocksdb::WriteOptions(), wdest, lvalue);
+       rocksdb::WriteBatch batch;
+       
+       /* Registry entry is already in place when overwriting the entry found by Prepare(). */
        
-       if (status.ok())
+       if (wdest != this->dest || this->identified == PROCESS_NULL || this->identified.empty())
        {
-             return true;
+             batch.Put(wdest, lvalue);
+             this->RegPut(batch, wdest);
+       }
+       else
+       {
+             /* Overwriting an expiring key keeps its deadline. */
+             
+             const time_t deadline = (this->mapped.loaded ? value_deadline(this->mapped.value) : 0);
+             batch.Put(wdest, deadline ? to_expiring(deadline, lvalue) : lvalue);
        }
        
-       return false;
+       return this->Commit(batch);
+}
+
+bool QueryBase::Merge(const std::string& wdest, const std::string& operand)
+{
+       rocksdb::WriteBatch batch;
+       
+       batch.Merge(wdest, operand);
+       
+       if (wdest != this->dest || this->identified == PROCESS_NULL || this->identified.empty())
+       {
+             this->RegPut(batch, wdest);
+       }
+       
+       return this->Commit(batch);
 }
 
 void QueryBase::Delete(const std::string& wdest)
 {
-       this->database->GetAddress()->Delete(rocksdb::WriteOptions(), wdest);
+       rocksdb::WriteBatch batch;
+       
+       batch.Delete(wdest);
+       this->RegDelete(batch, wdest);
+       this->DropMembers(batch, wdest);
+       
+       this->Commit(batch);
+}
+
+void QueryBase::RegPut(rocksdb::WriteBatch& batch, const std::string& wdest)
+{
+       KeyData parsed;
+       
+       if (from_dest(wdest, parsed) && is_data_type(parsed.type))
+       {
+             batch.Put(to_dest(parsed.key, parsed.select, INT_REG), parsed.type);
+       }
+}
+
+void QueryBase::RegDelete(rocksdb::WriteBatch& batch, const std::string& wdest)
+{
+       KeyData parsed;
+       
+       if (from_dest(wdest, parsed) && is_data_type(parsed.type))
+       {
+             batch.Delete(to_dest(parsed.key, parsed.select, INT_REG));
+       }
+}
+
+void QueryBase::DropMembers(rocksdb::WriteBatch& batch, const std::string& wdest)
+{
+       KeyData parsed;
+       
+       if (from_dest(wdest, parsed) && has_members(parsed.type))
+       {
+             const std::string& prefix = to_member_prefix(parsed.key, parsed.select);
+             batch.DeleteRange(prefix, prefix_end(prefix));
+       }
+}
+
+void QueryBase::Reap(rocksdb::WriteBatch& batch, unsigned int select, const std::string& regkey, const std::string& regtype)
+{
+       const std::string& entry = to_dest(regkey, select, regtype);
+       
+       batch.Delete(entry);
+       this->RegDelete(batch, entry);
+       this->DropMembers(batch, entry);
+       batch.Delete(to_dest(regkey, select, INT_EXPIRE));
+}
+
+void QueryBase::CopyMembers(rocksdb::WriteBatch& batch, const std::string& from, const std::string& to)
+{
+       KeyData source;
+       KeyData target;
+       
+       if (!from_dest(from, source) || !from_dest(to, target) || !has_members(source.type))
+       {
+             return;
+       }
+       
+       this->DropMembers(batch, to);
+
+       const std::string& prefix = to_member_prefix(source.key, source.select);
+       const std::string& newprefix = to_member_prefix(target.key, target.select);
+       
+       std::unique_ptr<rocksdb::Iterator> it = this->Scan(prefix);
+       
+       for (; it->Valid() && it->key().starts_with(prefix); it->Next())
+       {
+             rocksdb::Slice member = it->key();
+             member.remove_prefix(prefix.size());
+             batch.Put(newprefix + member.ToString(), it->value());
+       }
+}
+
+void QueryBase::LoadList(const std::string& ldest, ListMap& items)
+{
+       KeyData parsed;
+       
+       if (!from_dest(ldest, parsed))
+       {
+             return;
+       }
+       
+       const std::string& prefix = to_member_prefix(parsed.key, parsed.select);
+       std::unique_ptr<rocksdb::Iterator> it = this->Scan(prefix);
+       
+       for (; it->Valid() && it->key().starts_with(prefix); it->Next())
+       {
+             items.push_back(it->value().ToString());
+       }
+}
+
+void QueryBase::LoadMap(const std::string& ldest, MapMap& items)
+{
+       KeyData parsed;
+       
+       if (!from_dest(ldest, parsed))
+       {
+             return;
+       }
+       
+       const std::string& prefix = to_member_prefix(parsed.key, parsed.select);
+       std::unique_ptr<rocksdb::Iterator> it = this->Scan(prefix);
+       
+       for (; it->Valid() && it->key().starts_with(prefix); it->Next())
+       {
+             rocksdb::Slice field = it->key();
+             field.remove_prefix(prefix.size());
+             items[field.ToString()] = it->value().ToString();
+       }
+}
+
+namespace
+{
+      /* Copies a batch into a transaction. */
+      
+      class TransactionReplay : public rocksdb::WriteBatch::Handler
+      {
+          private:
+          
+              QueryBase* query;
+              
+          public:
+          
+              TransactionReplay(QueryBase* owner) : query(owner)
+              {
+              
+              }
+              
+              rocksdb::Status PutCF(uint32_t family, const rocksdb::Slice& key, const rocksdb::Slice& value) override
+              {
+                      return this->query->txn->Put(key, value);
+              }
+              
+              rocksdb::Status DeleteCF(uint32_t family, const rocksdb::Slice& key) override
+              {
+                      return this->query->txn->Delete(key);
+              }
+              
+              rocksdb::Status MergeCF(uint32_t family, const rocksdb::Slice& key, const rocksdb::Slice& value) override
+              {
+                      return this->query->txn->Merge(key, value);
+              }
+              
+              /* Indexed batches do not take ranges, entries found are deleted one by one. */
+              
+              rocksdb::Status DeleteRangeCF(uint32_t family, const rocksdb::Slice& begin, const rocksdb::Slice& end) override
+              {
+                      const std::string& prefix = begin.ToString();
+                      StringVector found;
+                      
+                      std::unique_ptr<rocksdb::Iterator> it = this->query->Scan(prefix);
+                      
+                      for (; it->Valid() && it->key().compare(end) < 0; it->Next())
+                      {
+                              found.push_back(it->key().ToString());
+                      }
+                      
+                      for (StringVector::const_iterator i = found.begin(); i != found.end(); ++i)
+                      {
+                              this->query->txn->Delete(*i);
+                      }
+                      
+                      return rocksdb::Status::OK();
+              }
+      };
+}
+
+bool QueryBase::Commit(rocksdb::WriteBatch& batch)
+{
+       if (this->txn)
+       {
+              TransactionReplay replay(this);
+              return batch.Iterate(&replay).ok();
+       }
+       
+       if (!this->database->Commit(batch))
+       {
+              return false;
+       }
+       
+       /* Users watching these keys must see them as changed. */
+       
+       std::vector<size_t> written;
+       this->Stripes(written);
+       KeyLocks::Bump(written);
+       
+       return true;
+}
+
+rocksdb::Status QueryBase::Read(const std::string& where, std::string* found, std::shared_ptr<Database> db)
+{
+       if (db == NULL)
+       {
+              db = this->database;
+       }
+       
+       if (this->txn && db == this->database)
+       {
+              return this->txn->GetFromBatchAndDB(db->GetAddress(), rocksdb::ReadOptions(), where, found);
+       }
+       
+       return db->GetAddress()->Get(rocksdb::ReadOptions(), where, found);
+}
+
+void QueryBase::ReadMany(const StringVector& where, StringVector& values, std::vector<rocksdb::Status>& statuses, std::shared_ptr<Database> db)
+{
+       if (db == NULL)
+       {
+              db = this->database;
+       }
+       
+       const size_t total = where.size();
+       
+       values.assign(total, "");
+       statuses.assign(total, rocksdb::Status::NotFound());
+       
+       if (this->txn && db == this->database)
+       {
+              for (size_t i = 0; i < total; ++i)
+              {
+                     statuses[i] = this->Read(where[i], &values[i], db);
+              }
+              
+              return;
+       }
+       
+       std::vector<size_t> order(total);
+       
+       for (size_t i = 0; i < total; ++i)
+       {
+              order[i] = i;
+       }
+       
+       std::sort(order.begin(), order.end(), [&where](size_t a, size_t b) { return where[a] < where[b]; });
+       
+       std::vector<rocksdb::Slice> keys;
+       keys.reserve(total);
+       
+       for (std::vector<size_t>::const_iterator i = order.begin(); i != order.end(); ++i)
+       {
+              keys.push_back(where[*i]);
+       }
+       
+       std::vector<rocksdb::PinnableSlice> found(total);
+       std::vector<rocksdb::Status> fstatus(total);
+       
+       rocksdb::DB* const address = db->GetAddress();
+       address->MultiGet(rocksdb::ReadOptions(), address->DefaultColumnFamily(), total, keys.data(), found.data(), fstatus.data(), true);
+       
+       for (size_t i = 0; i < total; ++i)
+       {
+              statuses[order[i]] = fstatus[i];
+              
+              if (fstatus[i].ok())
+              {
+                     values[order[i]] = found[i].ToString();
+              }
+       }
+}
+
+void QueryBase::Stripes(std::vector<size_t>& locked)
+{
+       if (this->database && !this->key.empty())
+       {
+             locked.push_back(KeyLocks::Stripe(this->database, this->select_query, this->key));
+       }
 }
 
 void QueryBase::WriteExpire(const std::string& e_key, unsigned int select, unsigned int ttl, std::shared_ptr<Database> db)
@@ -100,9 +398,22 @@ void QueryBase::WriteExpire(const std::string& e_key, unsigned int select, unsig
             db = this->database;
        }
        
-       const std::string& lookup = to_bin(e_key) + ":" + convto_string(select) + ":" + INT_EXPIRE + ":" + db->GetName();
+       const std::string& lookup = to_dest(e_key, select, INT_EXPIRE);
+       const std::string& entry = to_dest(e_key, select, INT_KEY);
+       
+       rocksdb::WriteBatch batch;
+       batch.Put(lookup, to_number_value(ttl));
+       
+       /* Keys carry their deadline too. */
+       
+       std::string stored;
+       
+       if (this->Read(entry, &stored, db).ok())
+       {
+           batch.Put(entry, to_expiring(ttl, stored));
+       }
        
-       if (this->Write(lookup, convto_string(ttl)))
+       if (db == this->database ? this->Commit(batch) : db->Commit(batch))
        {
            Kernel->Store->Expires->Add(db, ttl, e_key, select, true);
        }
@@ -110,8 +421,8 @@ void QueryBase::WriteExpire(const std::string& e_key, unsigned int select, unsig
 
 void QueryBase::WriteFuture(const std::string& e_key, unsigned int select, unsigned int ttl, const std::string& fvalue)
 {
-       std::string lookup = to_bin(e_key) + ":" + convto_string(select) + ":" + INT_FUTURE + ":" + this->database->GetName();
-       std::string lvalue = convto_string(ttl) + ":" + fvalue;
+       std::string lookup = to_dest(e_key, select, INT_FUTURE);
+       std::string lvalue = to_pair(convto_string(ttl), fvalue);
        
        if (this->Write(lookup, lvalue))
        {
@@ -122,7 +433,7 @@ void QueryBase::WriteFuture(const std::string& e_key, unsigned int select, unsig
 void QueryBase::DelFuture()
 {
         Kernel->Store->Futures->Delete(this->database, this->key, this->select_query);
-        std::string lookup = to_bin(this->key) + ":" + convto_string(this->select_query) + ":" + INT_FUTURE + ":" + this->database->GetName();
+        std::string lookup = to_dest(this->key, this->select_query, INT_FUTURE);
         this->Delete(lookup);
 }
 
@@ -143,8 +454,81 @@ void QueryBase::DelExpire()
         /* Deletes key in case it is expiring. */
         
         Kernel->Store->Expires->Delete(this->database, this->key, this->select_query);
-        std::string lookup = to_bin(this->key) + ":" + convto_string(this->select_query) + ":" + INT_EXPIRE + ":" + this->database->GetName();
-        this->Delete(lookup);
+        
+        const std::string& entry = to_dest(this->key, this->select_query, INT_KEY);
+        
+        rocksdb::WriteBatch batch;
+        batch.Delete(to_dest(this->key, this->select_query, INT_EXPIRE));
+        
+        std::string stored;
+        
+        if (this->Read(entry, &stored).ok() && value_deadline(stored))
+        {
+              batch.Put(entry, strip_deadline(stored));
+        }
+        
+        this->Commit(batch);
+}
+
+std::unique_ptr<rocksdb::Iterator> QueryBase::Scan(const std::string& prefix)
+{
+       rocksdb::ReadOptions options;
+       
+       /* Shorter ranges (a whole type) span more than one prefix-extractor bucket. */
+       
+       if (prefix.size() >= KEY_PREFIX_LENGTH)
+       {
+            options.prefix_same_as_start = true;
+       }
+       else
+       {
+            options.total_order_seek = true;
+       }
+       
+       rocksdb::Iterator* base = this->database->GetAddress()->NewIterator(options);
+       
+       /* Transactions see their own writes. */
+       
+       std::unique_ptr<rocksdb::Iterator> it(this->txn ? this->txn->NewIteratorWithBase(base) : base);
+       
+       if (this->paged && this->cursor.size() > prefix.size() && rocksdb::Slice(this->cursor).starts_with(prefix))
+       {
+            /* Cursor holds the last entry delivered, which is skipped if still there. */
+            
+            it->Seek(this->cursor);
+            
+            if (it->Valid() && it->key() == this->cursor)
+            {
+                 it->Next();
+            }
+            
+            return it;
+       }
+       
+       it->Seek(prefix);
+       return it;
+}
+
+void QueryBase::EndPage(rocksdb::Iterator* it, const std::string& prefix)
+{
+       if (!this->paged)
+       {
+            return;
+       }
+       
+       if (it->Valid() && it->key().starts_with(prefix))
+       {
+            this->cursor = it->key().ToString();
+       }
+       else
+       {
+            this->cursor.clear();
+       }
+}
+
+std::string QueryBase::GetCursor()
+{
+       return "@" + bin_to_hex(this->cursor);
 }
 
 RocksData QueryBase::Get(const std::string& where)
@@ -157,7 +541,7 @@ RocksData QueryBase::Get(const std::string& where)
        RocksData result;
        std::string dbvalue;
        
-       result.status = this->database->GetAddress()->Get(rocksdb::ReadOptions(), where, &dbvalue);
+       result.status = this->Read(where, &dbvalue);
        result.value = dbvalue;
        return result;
 }
@@ -174,60 +558,63 @@ int QueryBase::CheckDest(unsigned int select, const std::string& regkey, const s
               return 1;
        }
        
-       for (std::vector<std::string>::const_iterator iter = TypeRegs.begin(); iter != TypeRegs.end(); ++iter)
-       {
-              std::string found_type = *iter;
-              std::string saved = to_bin(regkey) + ":" + convto_string(select) + ":" + found_type;
-       
-              std::string dbvalue;
-              rocksdb::Status fstatus2 = db->GetAddress()->Get(rocksdb::ReadOptions(), saved, &dbvalue);
+       std::string found_type;
+       rocksdb::Status fstatus = this->Read(to_dest(regkey, select, INT_REG), &found_type, db);
        
-              if (!dbvalue.empty())
-              {
-                   if (found_type == ltype)
-                   {
-                        /* Ltype found, same type. */
-                        
-                        return 1;
-                   }
-                   else 
-                   {
-                        /* Different ltype */
-                        
-                        return 2;
-                   }
-              }
+       if (!fstatus.ok())
+       {
+              /* 0 means entry is not defined. */
+              
+              return 0;
        }
        
-       /* 0 means entry is not defined. */
+       /* 1: Ltype found, same type. 2: Different ltype. */
        
-       return 0;
+       return (found_type == ltype ? 1 : 2);
 }
 
 bool QueryBase::GetRegistry(unsigned int select, const std::string& regkey, bool do_load)
 {
-       for (std::vector<std::string>::const_iterator iter = TypeRegs.begin(); iter != TypeRegs.end(); ++iter)
-       {
-             std::string found_type = *iter;
-             std::string lookup = to_bin(regkey) + ":" + convto_string(select) + ":" + found_type;
-             
-             std::string dbvalue;
-             rocksdb::Status fstatus2 = this->database->GetAddress()->Get(rocksdb::ReadOptions(), lookup, &dbvalue);
+       std::string found_type;
+       rocksdb::Status fstatus = this->Read(to_dest(regkey, select, INT_REG), &found_type);
 
-             if (fstatus2.ok())
-             {
-                    this->identified = found_type;
-                    this->SetDest(regkey, select, found_type);
-                   
-                    if (do_load)
+       if (fstatus.ok())
+       {
+              this->identified = found_type;
+              this->SetDest(regkey, select, found_type);
+              
+              /* Only keys expire. Blind writes do not read them. */
+              
+              if (do_load || (found_type == INT_KEY && !this->blind))
+              {
+                    std::string dbvalue;
+                    
+                    mapped.status = this->Read(this->dest, &dbvalue);
+                    mapped.value = dbvalue;
+                    mapped.loaded = do_load;
+                    
+                    /* 
+                     * Expired, but not removed yet: removed now, and treated as not found.
+                     * Values dropped by a compaction (see ExpireFilter) were expired too.
+                     */
+                    
+                    if (found_type == INT_KEY && (mapped.status.IsNotFound() || is_expired(dbvalue, Kernel->Now())))
                     {
-                          mapped.value = dbvalue;
-                          mapped.status = fstatus2;
-                          mapped.loaded = true;
+                          rocksdb::WriteBatch batch;
+                          this->Reap(batch, select, regkey, found_type);
+                          
+                          if (this->Commit(batch))
+                          {
+                                Kernel->Store->Expires->Delete(this->database, regkey, select);
+                          }
+                          
+                          this->mapped = RocksData();
+                          this->identified = PROCESS_NULL;
+                          return false;
                     }
-                   
-                    return true;
-             }
+              }
+              
+              return true;
        }
 
        this->identified = PROCESS_NULL;
@@ -236,7 +623,7 @@ bool QueryBase::GetRegistry(unsigned int select, const std::string& regkey, bool
 
 void QueryBase::SetDest(const std::string& regkey, unsigned int regselect, const std::string& regtype)
 {
-       this->dest = to_bin(regkey) + ":" + convto_string(regselect) + ":" + regtype;
+       this->dest = to_dest(regkey, regselect, regtype);
 }
 
 bool QueryBase::Check()
@@ -289,7 +676,7 @@ bool QueryBase::Prepare()
      {
            case QUERY_TYPE_WRITE:
            {
-                 if (this->GetRegistry(this->select_query, this->key, true))
+                 if (this->GetRegistry(this->select_query, this->key, !this->blind))
                  {
                       if (this->identified == this->base_request)
                       {
@@ -307,7 +694,7 @@ bool QueryBase::Prepare()
                  {
                       if (this->identified == PROCESS_NULL)
                       {
-                            this->dest = to_bin(this->key) + ":" + convto_string(this->select_query) + ":" + this->base_request;
+                            this->dest = to_dest(this->key, this->select_query, this->base_request);
                             this->Run();
                             return true;
                       }  
@@ -618,6 +1005,7 @@ bool QueryBase::Prepare()
            break;
            
            case QUERY_TYPE_SKIP:
+           case QUERY_TYPE_MULTI:
            {
                  this->Run();
                  return true;
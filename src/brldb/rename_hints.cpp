@@ -12,6 +12,7 @@
  */
 
 #include "beryl.h"
+#include "brldb/keylocks.h"
 #include "brldb/expires.h"
 #include "helpers.h"
 
@@ -29,7 +30,7 @@ void rename_query::Lists()
 void rename_query::Keys()
 {
      RocksData result = this->Get(this->dest);
-     const std::string& newdest = to_bin(this->value) + ":" + convto_string(this->select_query) + ":" + this->identified;
+     const std::string& newdest = to_dest(this->value, this->select_query, this->identified);
 
      if (!this->SwapWithExpire(newdest, this->dest, result.value, this->select_query, this->value, this->id, this->key))
      {
@@ -56,6 +57,12 @@ void rename_query::Geos()
 
 }
 
+void rename_query::Stripes(std::vector<size_t>& locked)
+{
+       QueryBase::Stripes(locked);
+       locked.push_back(KeyLocks::Stripe(this->database, this->select_query, this->value));
+}
+
 void rename_query::Run()
 {
     if (this->identified == INT_KEY)
@@ -91,7 +98,7 @@ void rename_query::Run()
     }   
     
     RocksData result = this->Get(this->dest);
-    const std::string& newdest = to_bin(this->value) + ":" + convto_string(this->select_query) + ":" + this->identified;
+    const std::string& newdest = to_dest(this->value, this->select_query, this->identified);
 
     if (!this->Swap(newdest, this->dest, result.value))
     {
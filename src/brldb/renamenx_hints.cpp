@@ -12,6 +12,7 @@
  */
 
 #include "beryl.h"
+#include "brldb/keylocks.h"
 #include "brldb/expires.h"
 #include "helpers.h"
 
@@ -28,7 +29,7 @@ void renamenx_query::Lists()
 void renamenx_query::Keys()
 {
      RocksData result = this->Get(this->dest);
-     const std::string& newdest = to_bin(this->value) + ":" + convto_string(this->select_query) + ":" + this->identified;
+     const std::string& newdest = to_dest(this->value, this->select_query, this->identified);
 
      if (!this->SwapWithExpire(newdest, this->dest, result.value, this->select_query, this->value, this->id, this->key))
      {
@@ -55,6 +56,12 @@ void renamenx_query::Geos()
 
 }
 
+void renamenx_query::Stripes(std::vector<size_t>& locked)
+{
+       QueryBase::Stripes(locked);
+       locked.push_back(KeyLocks::Stripe(this->database, this->select_query, this->value));
+}
+
 void renamenx_query::Run()
 {
     if (this->identified == INT_KEY)
@@ -90,7 +97,7 @@ void renamenx_query::Run()
     }   
 
     RocksData result = this->Get(this->dest);
-    const std::string& newdest = to_bin(this->value) + ":" + convto_string(this->select_query) + ":" + this->identified;
+    const std::string& newdest = to_dest(this->value, this->select_query, this->identified);
 
     if (!this->Swap(newdest, this->dest, result.value))
     {
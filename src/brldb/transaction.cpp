@@ -0,0 +1,134 @@
+/*
+ * BerylDB - A lightweight database.
+ * http://www.beryldb.com
+ *
+ * Copyright (C) 2021 - Carlos F. Ferry <cferry@beryldb.com>
+ *
+ * This file is part of BerylDB. BerylDB is free software: you can
+ * redistribute it and/or modify it under the terms of the BSD License
+ * version 3.
+ *
+ * More information about our licensing can be found at https://docs.beryl.dev
+ */
+
+#include <rocksdb/utilities/write_batch_with_index.h>
+
+#include "beryl.h"
+#include "engine.h"
+#include "brldb/keylocks.h"
+
+void transaction_query::Add(const std::shared_ptr<QueryBase>& query)
+{
+       if (!this->database)
+       {
+              this->database = query->database;
+       }
+
+       this->queries.push_back(query);
+}
+
+bool transaction_query::Changed()
+{
+       for (std::map<size_t, uint64_t>::const_iterator i = this->watched.begin(); i != this->watched.end(); ++i)
+       {
+              if (KeyLocks::Version(i->first) != i->second)
+              {
+                     return true;
+              }
+       }
+
+       return false;
+}
+
+void transaction_query::Stripes(std::vector<size_t>& locked)
+{
+       /* Watched keys are locked too, so they can not change before commit. */
+
+       for (std::map<size_t, uint64_t>::const_iterator i = this->watched.begin(); i != this->watched.end(); ++i)
+       {
+              locked.push_back(i->first);
+       }
+
+
+       for (std::vector<std::shared_ptr<QueryBase>>::const_iterator i = this->queries.begin(); i != this->queries.end(); ++i)
+       {
+              (*i)->Stripes(locked);
+       }
+}
+
+void transaction_query::Run()
+{
+       if (this->Changed())
+       {
+              this->conflict = true;
+              this->SetOK();
+              return;
+       }
+
+       /* Later queries of this block read entries written by earlier ones. */
+
+       rocksdb::WriteBatchWithIndex batch(rocksdb::BytewiseComparator(), 0, true);
+
+       for (std::vector<std::shared_ptr<QueryBase>>::const_iterator i = this->queries.begin(); i != this->queries.end(); ++i)
+       {
+              const std::shared_ptr<QueryBase>& query = *i;
+
+              if (query->access == DBL_INVALID_FORMAT)
+              {
+                     continue;
+              }
+
+              /* Queries on other databases write on their own. */
+
+              if (query->database == this->database)
+              {
+                     query->txn = &batch;
+              }
+
+              query->Prepare();
+              query->txn = NULL;
+       }
+
+       if (batch.GetWriteBatch()->Count() && !this->Commit(*batch.GetWriteBatch()))
+       {
+              for (std::vector<std::shared_ptr<QueryBase>>::const_iterator i = this->queries.begin(); i != this->queries.end(); ++i)
+              {
+                     if ((*i)->database == this->database)
+                     {
+                            (*i)->access_set(DBL_BATCH_FAILED);
+                     }
+              }
+       }
+
+       this->SetOK();
+}
+
+void transaction_query::Process()
+{
+       if (this->conflict)
+       {
+              user->SendProtocol(ERR_INPUT2, ERR_MULTI, WATCH_CONFLICT);
+              return;
+       }
+
+       for (std::vector<std::shared_ptr<QueryBase>>::const_iterator i = this->queries.begin(); i != this->queries.end(); ++i)
+       {
+              const std::shared_ptr<QueryBase>& query = *i;
+
+              /* Block did not run, ie: database closing. */
+
+              if (this->access != DBL_STATUS_OK)
+              {
+                     query->access_set(this->access);
+              }
+
+              if (query->flags == QUERY_FLAGS_QUIET)
+              {
+                     continue;
+              }
+
+              DataFlush::Reply(query);
+       }
+
+       Dispatcher::JustAPI(this->user, BRLD_MULTI_STOP);
+}
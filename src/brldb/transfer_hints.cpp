@@ -12,6 +12,7 @@
  */
 
 #include "beryl.h"
+#include "brldb/keylocks.h"
 #include "brldb/database.h"
 #include "brldb/query.h"
 #include "brldb/dbnumeric.h"
@@ -55,6 +56,16 @@ void transfer_query::Vectors()
 
 }
 
+void transfer_query::Stripes(std::vector<size_t>& locked)
+{
+       QueryBase::Stripes(locked);
+       
+       if (this->transf_db)
+       {
+             locked.push_back(KeyLocks::Stripe(this->transf_db, this->select_query, this->key));
+       }
+}
+
 void transfer_query::Run()
 {
     if (this->identified == INT_KEY)
@@ -83,8 +94,14 @@ void transfer_query::Run()
     }   
     
     RocksData result = this->Get(this->dest);
-    const std::string& newdest = to_bin(this->key) + ":" + convto_string(this->select_query) + ":" + this->identified;
-    this->transf_db->GetAddress()->Put(rocksdb::WriteOptions(), newdest, result.value);
+    const std::string& newdest = to_dest(this->key, this->select_query, this->identified);
+    
+    rocksdb::WriteBatch batch;
+    batch.Put(newdest, result.value);
+    this->RegPut(batch, newdest);
+    this->CopyMembers(batch, this->dest, newdest);
+    
+    this->transf_db->Commit(batch);
     this->Delete(this->dest);
 }
 
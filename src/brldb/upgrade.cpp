@@ -0,0 +1,463 @@
+/*
+ * BerylDB - A lightweight database.
+ * http://www.beryldb.com
+ *
+ * Copyright (C) 2021 - Carlos F. Ferry <cferry@beryldb.com>
+ *
+ * This file is part of BerylDB. BerylDB is free software: you can
+ * redistribute it and/or modify it under the terms of the BSD License
+ * version 3.
+ *
+ * More information about our licensing can be found at https://docs.beryl.dev
+ */
+
+#include "beryl.h"
+#include "exit.h"
+#include "engine.h"
+#include "brldb/codec.h"
+
+/* Entries converted before a batch is written. */
+
+const unsigned int UPGRADE_BATCH = 10000;
+
+/* Format marker used by format 2. */
+
+const std::string LEGACY_FORMAT_KEY = std::string(1, '\0') + "format";
+
+/* Splits a format 1 field list (bin:bin:...) into decoded items. */
+
+static StringVector LegacyItems(const std::string& value)
+{
+        StringVector items;
+
+        engine::colon_node_stream stream(value);
+        std::string token;
+
+        while (stream.items_extract(token))
+        {
+                items.push_back(to_string(token));
+        }
+
+        return items;
+}
+
+/*
+ * Converts a format 1 entry (bin(key):select:type[:db]).
+ *
+ * @parameters:
+ *
+ *         · string: Format 1 key.
+ *         · string: Format 1 value.
+ *         · string: Converted key.
+ *         · string: Converted value.
+ *
+ * @return:
+ *
+ *         · bool: False if entry could not be recognized.
+ */
+
+static bool UpgradeLegacy(const std::string& oldkey, const std::string& oldvalue, std::string& newkey, std::string& newvalue)
+{
+        engine::colon_node_stream stream(oldkey);
+        std::string token;
+        StringVector parts;
+
+        while (stream.items_extract(token))
+        {
+                parts.push_back(token);
+        }
+
+        if (parts.size() < 3 || !is_number(parts[1]))
+        {
+                return false;
+        }
+
+        const std::string key     = to_string(parts[0]);
+        const unsigned int select = convto_num<unsigned int>(parts[1]);
+        const std::string& type   = parts[2];
+
+        if (type == INT_EXPIRE || type == INT_FUTURE)
+        {
+                if (parts.size() < 4)
+                {
+                        return false;
+                }
+
+                newkey = to_dest(key, select, type);
+
+                if (type == INT_EXPIRE)
+                {
+                        newvalue = to_number_value(convto_num<double>(oldvalue));
+                        return true;
+                }
+
+                /* Futures were stored as 'ttl:value', value not encoded. */
+
+                const size_t found = oldvalue.find_first_of(":");
+
+                if (found == std::string::npos)
+                {
+                        return false;
+                }
+
+                newvalue = to_pair(oldvalue.substr(0, found), oldvalue.substr(found + 1));
+                return true;
+        }
+
+        newkey = to_dest(key, select, type);
+
+        if (type == INT_KEY)
+        {
+                newvalue = to_value(to_string(oldvalue));
+        }
+        else if (type == INT_LIST || type == INT_VECTOR)
+        {
+                newvalue = to_fields();
+
+                const StringVector& items = LegacyItems(oldvalue);
+
+                for (StringVector::const_iterator i = items.begin(); i != items.end(); ++i)
+                {
+                        codec_put_field(newvalue, *i);
+                }
+        }
+        else if (type == INT_MAP || type == INT_MMAP)
+        {
+                newvalue = to_fields();
+
+                engine::colon_node_stream mstream(oldvalue);
+                std::string mask;
+
+                while (mstream.items_extract(mask))
+                {
+                        const size_t found = mask.find_first_of("/");
+
+                        codec_put_field(newvalue, to_string(mask.substr(0, found)));
+                        codec_put_field(newvalue, found == std::string::npos ? "" : to_string(mask.substr(found + 1)));
+                }
+        }
+        else if (type == INT_GEO)
+        {
+                const StringVector& items = LegacyItems(oldvalue);
+
+                if (items.size() != 2)
+                {
+                        return false;
+                }
+
+                newvalue = to_pair(items[0], items[1]);
+        }
+        else
+        {
+                return false;
+        }
+
+        return true;
+}
+
+/*
+ * Converts a format 2 key (field(key):select:type[:db]). Values are
+ * kept as they are.
+ *
+ * @parameters:
+ *
+ *         · string: Format 2 key.
+ *         · string: Converted key.
+ *
+ * @return:
+ *
+ *         · bool: False if key could not be recognized.
+ */
+
+static bool UpgradeKey(const std::string& oldkey, std::string& newkey)
+{
+        size_t pos = 0;
+        std::string key;
+
+        if (!codec_get_field(oldkey, pos, key) || pos >= oldkey.size() || oldkey[pos] != ':')
+        {
+                return false;
+        }
+
+        const size_t select_end = oldkey.find(':', ++pos);
+
+        if (select_end == std::string::npos || select_end == pos)
+        {
+                return false;
+        }
+
+        const size_t type_end = oldkey.find(':', select_end + 1);
+        const std::string& type = oldkey.substr(select_end + 1, type_end == std::string::npos ? std::string::npos : type_end - select_end - 1);
+
+        if (type.size() != 1)
+        {
+                return false;
+        }
+
+        newkey = to_dest(key, convto_num<unsigned int>(oldkey.substr(pos, select_end - pos)), type);
+        return true;
+}
+
+/*
+ * Splits a list stored as a single value (format 4 and older) into one
+ * entry per element.
+ *
+ * @parameters:
+ *
+ *         · WriteBatch: Batch receiving elements.
+ *         · KeyData   : List being converted.
+ *         · string    : Stored list, replaced by its header.
+ *
+ * @return:
+ *
+ *         · bool: False if value is not an old list.
+ */
+
+static bool UpgradeList(rocksdb::WriteBatch& batch, const KeyData& parsed, std::string& value)
+{
+        size_t pos = 0;
+
+        if (!from_fields(value, pos))
+        {
+                return false;
+        }
+
+        const std::string& prefix = to_member_prefix(parsed.key, parsed.select);
+
+        ListHeader header;
+        std::string item;
+
+        while (pos < value.size() && codec_get_field(value, pos, item))
+        {
+                batch.Put(prefix + to_seq(header.tail++), item);
+                header.count++;
+        }
+
+        value = to_list_header(header);
+        return true;
+}
+
+/*
+ * Splits a map stored as a single value (format 5 and older) into one
+ * entry per field.
+ *
+ * @parameters:
+ *
+ *         · WriteBatch: Batch receiving fields.
+ *         · KeyData   : Map being converted.
+ *         · string    : Stored map, replaced by its header.
+ *
+ * @return:
+ *
+ *         · bool: False if value is not an old map.
+ */
+
+static bool UpgradeMap(rocksdb::WriteBatch& batch, const KeyData& parsed, std::string& value)
+{
+        size_t pos = 0;
+
+        if (!from_fields(value, pos))
+        {
+                return false;
+        }
+
+        const std::string& prefix = to_member_prefix(parsed.key, parsed.select);
+
+        std::string field;
+        std::string item;
+        std::set<std::string> fields;
+
+        while (pos < value.size() && codec_get_field(value, pos, field) && codec_get_field(value, pos, item))
+        {
+                batch.Put(prefix + field, item);
+                fields.insert(field);
+        }
+
+        value = to_map_header(fields.size());
+        return true;
+}
+
+/*
+ * Adds the deadline of every expiring key to its value, as expected
+ * since format 8. Runs once all other entries have been converted.
+ *
+ * @parameters:
+ *
+ *         · DB: Database to upgrade.
+ */
+
+static void UpgradeExpires(rocksdb::DB* db)
+{
+        const std::string& prefix = to_prefix(INT_EXPIRE);
+
+        rocksdb::ReadOptions options;
+        options.total_order_seek = true;
+
+        std::unique_ptr<rocksdb::Iterator> it(db->NewIterator(options));
+        rocksdb::WriteBatch batch;
+
+        for (it->Seek(prefix); it->Valid() && it->key().starts_with(prefix); it->Next())
+        {
+                KeyData parsed;
+                double schedule = 0;
+
+                if (!from_dest(it->key().ToString(), parsed) || !from_number_value(it->value().ToString(), schedule))
+                {
+                        continue;
+                }
+
+                const std::string& entry = to_dest(parsed.key, parsed.select, INT_KEY);
+                std::string stored;
+
+                if (db->Get(rocksdb::ReadOptions(), entry, &stored).ok())
+                {
+                        batch.Put(entry, to_expiring(static_cast<time_t>(schedule), stored));
+                }
+
+                if (static_cast<unsigned int>(batch.Count()) >= UPGRADE_BATCH)
+                {
+                        db->Write(rocksdb::WriteOptions(), &batch);
+                        batch.Clear();
+                }
+        }
+
+        db->Write(rocksdb::WriteOptions(), &batch);
+}
+
+bool Database::Upgrade()
+{
+        unsigned int format = 0;
+
+        std::string stored;
+        rocksdb::Status fstatus = this->db->Get(rocksdb::ReadOptions(), STORAGE_FORMAT_KEY, &stored);
+
+        if (!fstatus.ok())
+        {
+                fstatus = this->db->Get(rocksdb::ReadOptions(), LEGACY_FORMAT_KEY, &stored);
+        }
+
+        if (fstatus.ok())
+        {
+                double number = 0;
+
+                if (!from_number_value(stored, number) || number > STORAGE_FORMAT)
+                {
+                        bprint(ERROR, "Database %s uses an unknown storage format. Please upgrade BerylDB.", this->path.c_str());
+                        slog("DATABASE", LOG_DEFAULT, "Unknown storage format in %s", this->path.c_str());
+                        return false;
+                }
+
+                format = static_cast<unsigned int>(number);
+
+                if (format == STORAGE_FORMAT)
+                {
+                        return true;
+                }
+        }
+
+        /* A database without a format marker holding data was written by format 1. */
+
+        rocksdb::Iterator* it = this->db->NewIterator(rocksdb::ReadOptions());
+        it->SeekToFirst();
+
+        if (it->Valid())
+        {
+                bprint(INFO, "Upgrading storage format of %s.", this->path.c_str());
+                slog("DATABASE", LOG_DEFAULT, "Upgrading storage format of %s", this->path.c_str());
+
+                unsigned int converted = 0;
+                unsigned int skipped = 0;
+
+                /* Keyspace counters, built from scratch before format 7. */
+
+                std::map<std::string, double> counters;
+
+                rocksdb::WriteBatch batch;
+
+                for (; it->Valid(); it->Next())
+                {
+                        const std::string& oldkey = it->key().ToString();
+
+                        if (oldkey == LEGACY_FORMAT_KEY || oldkey == STORAGE_FORMAT_KEY)
+                        {
+                                continue;
+                        }
+
+                        std::string newkey = oldkey;
+                        std::string newvalue = it->value().ToString();
+
+                        /* Format 3 keys are kept as they are. */
+
+                        bool changed = (format < 3);
+
+                        if (format < 3)
+                        {
+                                batch.Delete(oldkey);
+
+                                const bool valid = (format == 0 ? UpgradeLegacy(oldkey, it->value().ToString(), newkey, newvalue) : UpgradeKey(oldkey, newkey));
+
+                                if (!valid)
+                                {
+                                        skipped++;
+                                        continue;
+                                }
+                        }
+
+                        KeyData parsed;
+
+                        if (from_dest(newkey, parsed))
+                        {
+                                if (format < 4 && is_data_type(parsed.type))
+                                {
+                                        batch.Put(to_dest(parsed.key, parsed.select, INT_REG), parsed.type);
+                                }
+
+                                if (format < 7 && (is_data_type(parsed.type) || parsed.type == INT_EXPIRE || parsed.type == INT_FUTURE))
+                                {
+                                        counters[to_counter(parsed.select, parsed.type)]++;
+                                }
+
+                                if (parsed.type == INT_LIST && UpgradeList(batch, parsed, newvalue))
+                                {
+                                        changed = true;
+                                }
+
+                                if (parsed.type == INT_MAP && UpgradeMap(batch, parsed, newvalue))
+                                {
+                                        changed = true;
+                                }
+                        }
+
+                        if (changed)
+                        {
+                                batch.Put(newkey, newvalue);
+                        }
+
+                        if (++converted % UPGRADE_BATCH == 0)
+                        {
+                                this->db->Write(rocksdb::WriteOptions(), &batch);
+                                batch.Clear();
+                        }
+                }
+
+                for (std::map<std::string, double>::const_iterator i = counters.begin(); i != counters.end(); ++i)
+                {
+                        batch.Put(i->first, to_number_value(i->second));
+                }
+
+                batch.Delete(LEGACY_FORMAT_KEY);
+                this->db->Write(rocksdb::WriteOptions(), &batch);
+
+                if (format < 8)
+                {
+                        UpgradeExpires(this->db);
+                }
+
+                slog("DATABASE", LOG_DEFAULT, "Upgraded %s: %u entries converted, %u dropped.", this->path.c_str(), converted, skipped);
+        }
+
+        delete it;
+
+        fstatus = this->db->Put(rocksdb::WriteOptions(), STORAGE_FORMAT_KEY, to_number_value(STORAGE_FORMAT));
+        return fstatus.ok();
+}
@@ -17,6 +17,7 @@
 #include "beryl.h"
 #include "engine.h"
 #include "brldb/vector_handler.h"
+#include "brldb/codec.h"
 
 VectorHandler::VectorHandler()
 {
@@ -27,12 +28,17 @@ std::shared_ptr<VectorHandler> VectorHandler::Create(const std::string& load)
 {
         std::shared_ptr<VectorHandler> New = std::make_shared<VectorHandler>();
         
-        engine::colon_node_stream stream(load);
+        size_t pos = 0;
         std::string mask;
 
-        while (stream.items_extract(mask))
+        if (!from_fields(load, pos))
         {
-                New->Add(to_string(mask));
+                return New;
+        }
+
+        while (pos < load.size() && codec_get_field(load, pos, mask))
+        {
+                New->Add(mask);
         }
         
         return New;
@@ -222,22 +228,11 @@ double VectorHandler::GetLow()
 
 std::string VectorHandler::as_string()
 {
-        std::string final;
-        
-        unsigned int size = this->mhandler.size();
-        
-        unsigned int counter = 0;
+        std::string final = to_fields();
         
         for (StringVector::const_iterator i = this->mhandler.begin(); i != this->mhandler.end(); ++i)      
         {
-                  std::string key = *i;
-                  
-                  if (counter != size)
-                  {
-                        final += to_bin(key) + ":";
-                  }
-                  
-                  counter++;
+                  codec_put_field(final, *i);
         }
         
         return final;
@@ -15,6 +15,7 @@
 #include "engine.h"
 
 #include "brldb/query.h"
+#include "brldb/merge.h"
 #include "brldb/vector_handler.h"
 
 void vfind_query::Run()
@@ -24,7 +25,7 @@ void vfind_query::Run()
        unsigned int tracker = 0;
        
        std::string dbvalue;
-       rocksdb::Status fstatus2 = this->database->GetAddress()->Get(rocksdb::ReadOptions(), this->dest, &dbvalue);
+       rocksdb::Status fstatus2 = this->Read(this->dest, &dbvalue);
 
        if (!fstatus2.ok())
        {
@@ -54,6 +55,7 @@ void vfind_query::Run()
                                                 std::shared_ptr<vfind_query> request = std::make_shared<vfind_query>();
                                                 request->user = this->user;
                                                 request->partial = true;       
+                                                request->slot = this->slot;
                                                 request->key	= this->key;                           
                                                 request->subresult = ++tracker;
                                                 request->VecData = result;
@@ -79,6 +81,7 @@ void vfind_query::Run()
                                         request->user = this->user;
                                         request->key    = this->key;                       
                                         request->partial = true;
+                                        request->slot = this->slot;
                                         request->subresult = ++tracker;
                                         request->VecData = result;
                                         result.clear();
@@ -137,9 +140,10 @@ void vkeys_query::Run()
        unsigned int aux_counter = 0;
        unsigned int tracker = 0;
 
-       rocksdb::Iterator* it = this->database->GetAddress()->NewIterator(rocksdb::ReadOptions());
+       const std::string& prefix = to_prefix(this->select_query, INT_VECTOR);
+       std::unique_ptr<rocksdb::Iterator> it = this->Scan(prefix);
 
-       for (it->SeekToFirst(); it->Valid(); it->Next()) 
+       for (; it->Valid() && it->key().starts_with(prefix); it->Next())
        {
                 if (!Dispatcher::CheckIterator(this))
                 {
@@ -149,63 +153,16 @@ void vkeys_query::Run()
                 std::string rawmap = it->key().ToString();
                 std::string rawvalue = it->value().ToString();
 
-                engine::colon_node_stream stream(rawmap);
-                std::string token;
-                unsigned int strcounter = 0;
-                bool skip = false;
+                KeyData parsed;
 
-                std::string key_as_string;
-
-                while (stream.items_extract(token))
+                if (!from_dest(rawmap, parsed))
                 {
-                        if (skip)
-                        {
-                            break;
-                        }
-
-                        switch (strcounter)
-                        {
-                             case 0:
-                             {
-                                  key_as_string = to_string(token);
-                                
-                                  if (!Daemon::Match(key_as_string, this->key))
-                                  {
-                                       skip = true;
-                                  }
-                             }
-                             
-                             break;
-                             
-                             case 1:
-                             {
-                                   if (convto_string(this->select_query) != token)
-                                   {
-                                        skip = true;
-                                   }
-                             }
-                             
-                             break;
-                             
-                             case 2:
-                             {
-                                  if (token != INT_VECTOR)
-                                  {
-                                         skip = true;   
-                                  }
-                             }
-                             
-                             break;
-                             
-                             default:
-                             {
-                                 break;   
-                             }                                     
-                        }
-                        
-                        strcounter++;
+                        continue;
                 }
-                if (skip)
+
+                const std::string& key_as_string = parsed.key;
+
+                if (!Daemon::Match(key_as_string, this->key))
                 {
                         continue;
                 }
@@ -224,6 +181,7 @@ void vkeys_query::Run()
                                                 std::shared_ptr<vkeys_query> request = std::make_shared<vkeys_query>();
                                                 request->user = this->user;
                                                 request->partial = true;                                  
+                                                request->slot = this->slot;
                                                 request->subresult = tracker;
                                                 request->VecData = result;
                                                 request->key    = this->key;                       
@@ -250,6 +208,7 @@ void vkeys_query::Run()
                                         request->user = this->user;
                                         request->key    = this->key;                       
                                         request->partial = true;
+                                        request->slot = this->slot;
                                         request->subresult = tracker;
                                         request->VecData = result;
                                         result.clear();
@@ -321,54 +280,15 @@ void vpush_query::Run()
              return;
        }
 
-       RocksData result = this->Get(this->dest);
-       std::shared_ptr<VectorHandler> handler;
+       /* Pushes are blind: the item is merged into the stored vector. */
        
-       if (!result.status.ok())
+       if (this->Merge(this->dest, to_push_operand(this->value)))
        {
-               /* Create a new entry. */   
-    
-               handler = std::make_shared<VectorHandler>();
-               handler->Add(this->value);
-               
-               if (handler->GetLast() == HANDLER_MSG_OK)
-               {
-                     if (this->Write(this->dest, handler->as_string()))
-                     {
-                           this->SetOK();
-                     }
-                     else
-                     {
-                           access_set(DBL_UNABLE_WRITE);
-                     }
-               }
-               else
-               {
-                     access_set(DBL_UNABLE_WRITE);
-               }
-
-               return;
-       }
-       
-       handler = VectorHandler::Create(result.value);
-       handler->Add(this->value);
-       
-       if (handler->GetLast() == HANDLER_MSG_OK)
-       {
-               if (this->Write(this->dest, handler->as_string()))
-               {
-                    this->SetOK();
-               }
-               else
-               {
-                    access_set(DBL_UNABLE_WRITE);
-               }
-               
-               return;
+             this->SetOK();
        }
        else
        {
-               access_set(DBL_UNABLE_WRITE);
+             access_set(DBL_UNABLE_WRITE);
        }
 }
 
@@ -425,6 +345,7 @@ void vget_query::Run()
                                                 std::shared_ptr<vget_query> request = std::make_shared<vget_query>();
                                                 request->user = this->user;
                                                 request->partial = true;                                  
+                                                request->slot = this->slot;
                                                 request->key    = this->key;                       
                                                 request->subresult = ++tracker;
                                                 request->VecData = result_return;
@@ -450,6 +371,7 @@ void vget_query::Run()
                                         request->user = this->user;
                                         request->key    = this->key;                       
                                         request->partial = true;
+                                        request->slot = this->slot;
                                         request->subresult = ++tracker;
                                         request->VecData = result_return;
                                         result_return.clear();
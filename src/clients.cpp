@@ -16,6 +16,7 @@
 #include "queues.h"
 #include "notifier.h"
 #include "channelmanager.h"
+#include "reactors.h"
 
 namespace
 {
@@ -157,6 +158,13 @@ void ClientManager::AddUser(int socket, BindingPort* via, engine::sockets::socka
 		}
 	}
 
+	/* Sockets without I/O hooks are handled by I/O threads, if any. */
+
+	if (!ehandler->GetIOQueue())
+	{
+		Reactors::Attach(ehandler);
+	}
+
         if (this->local_users.size() > Kernel->Config->MaxClients)
         {
                 this->Disconnect(New, "New connections are not allowed.");
@@ -198,10 +206,10 @@ void ClientManager::ForceExits()
 	{
 		User* user = *i;
 		
-		if (user->IsQuitting() && !user->IsLocked())
+		if (user->IsQuitting() && !user->IsBusy())
 		{
 			Kernel->Reducer.Add(user);
-			this->AwaitingExit.erase(i);
+			i = this->AwaitingExit.erase(i);
 		}
 		else
 		{
@@ -246,7 +254,7 @@ void ClientManager::Disconnect(User* user, const std::string& quitmessage)
 		localuser->Send(Kernel->GetBRLDEvents().error, errormsg);
 	}
 
-	if (!user->IsLocked())
+	if (!user->IsBusy())
 	{
 		Kernel->Reducer->Add(user);
 	}
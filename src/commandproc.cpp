@@ -11,6 +11,8 @@
  * More information about our licensing can be found at https://docs.beryl.dev
  */
 
+#include <chrono>
+
 #include "beryl.h"
 #include "managers/user.h"
 #include "extras.h"
@@ -390,7 +392,7 @@ void CommandHandler::Execute(LocalUser* user, std::string& command, CommandModel
 		      
 		      if (handler->run_conf)
 		      {
-  				Limiter Conf = GetLimits(user, handler->max_params, cmd_params);
+  				Limiter Conf = GetLimits(user, handler->max_params, cmd_params, handler->run_cursor);
 				
 				if (Conf->GetError())
 				{
@@ -400,6 +402,8 @@ void CommandHandler::Execute(LocalUser* user, std::string& command, CommandModel
 				{
 					handler->offset = Conf->GetOffset();
 					handler->limit  = Conf->GetLimit();
+					handler->paged  = Conf->GetPaged();
+					handler->cursor = Conf->GetCursor();
 				}
 		      }
                 }
@@ -541,12 +545,14 @@ void CommandQueue::Add(LocalUser* user, const std::string& command, CommandModel
         if (command == "PONG")
         {       
                 user->PendingList.push_back(adding);
+                this->ready.insert(user->uuid);
                 return;
         }
 
         if (command == "MULTIRESET")
         {
 		user->PendingMulti.clear();
+		user->Watched.clear();
 		user->MultiRunning = false;
 	}
 	else
@@ -572,6 +578,7 @@ void CommandQueue::Add(LocalUser* user, const std::string& command, CommandModel
 	}
         
         user->PendingList.push_back(adding);
+        this->ready.insert(user->uuid);
 }
 
 void CommandQueue::Reset()
@@ -589,43 +596,72 @@ void CommandQueue::Reset()
                   
                   user->PendingList.clear();
 	}
+	
+	this->ready.clear();
+	this->last.clear();
 }
 
 bool CommandQueue::Flush()
 {
        bool flag = false;
        
-       if (!Kernel->Ready)
+       if (!Kernel->Ready || this->ready.empty())
        {
         	return flag;
        }
        
-       const ClientManager::LocalList& users = Kernel->Clients->GetLocals();
+       const std::chrono::steady_clock::time_point deadline = std::chrono::steady_clock::now() + std::chrono::microseconds(Kernel->Config->FlushUsec);
+
+       /* Only users with pending commands are visited, starting after the last one served. */
        
-       if (!users.size())
-       {
-               return false;
-       }
-      
-       for (ClientManager::LocalList::const_iterator u = users.begin(); u != users.end(); ++u)
+       std::set<std::string>::const_iterator u = this->ready.upper_bound(this->last);
+       
+       for (size_t visits = this->ready.size(); visits && !this->ready.empty(); visits--)
        {
-               LocalUser* user = *u;
-
-               if (user == NULL)
+               if (u == this->ready.end())
                {
-                     continue;
+                     u = this->ready.begin();
                }
+               
+               LocalUser* user = IS_LOCAL(Kernel->Clients->FindUUID(*u));
 
-               if (user->IsQuitting())
+               if (user && user->IsQuitting())
                {
                	     user->PendingList.clear();
                }
                
-               if (!user->PendingList.size())
+               if (user == NULL || !user->PendingList.size())
                {
+                     u = this->ready.erase(u);
                      continue;
                }
                
+               this->last = *u;
+               ++u;
+               
+               if (this->Drain(user))
+               {
+                     flag = true;
+               }
+               
+               /* Remaining users are served first in the next pass. */
+               
+               if (std::chrono::steady_clock::now() >= deadline)
+               {
+                     break;
+               }
+        }
+        
+        return flag;
+}
+
+bool CommandQueue::Drain(LocalUser* user)
+{
+       bool executed = false;
+       unsigned int budget = Kernel->Config->CommandBurst;
+       
+       while (budget && user->PendingList.size())
+       {
                PendingCMD event = user->PendingList.front();
 
                /* PONGS are allowed at any time when processing queries, even when locked. */
@@ -634,41 +670,126 @@ bool CommandQueue::Flush()
                {
                        user->PendingList.pop_front();
                        Kernel->Commander->Execute(user, event.command, event.cmd_params);
-                       return true;
+                       executed = true;
+                       budget--;
+                       continue;
                }
                   
                if (user->IsLocked())
                {
-                 	continue; 
+                 	break; 
+               }
+
+               /* Commands that only read keys may run next to queries in flight. */
+               
+               if (!user->Multi && !user->MultiRunning)
+               {
+                        const unsigned int piped = this->Pipeline(user, budget);
+                        
+                        if (piped)
+                        {
+                                executed = true;
+                                budget -= piped;
+                                continue;
+                        }
+               }
+               
+               if (!user->CanRun(false))
+               {
+                        break;
                }
                
                if (user->Multi && event.command == "MRUN")
                {
-	               	user->MultiRunning = true;
-	               	user->Multi = false;
-	               	Dispatcher::JustAPI(user, BRLD_MULTI_START);
+                        user->PendingList.pop_front();
+                        this->Transaction(user);
+                        executed = true;
+                        budget--;
+                        continue;
 	       }
-	       
-	       if (user->MultiRunning)
-	       {        
-  		      if (!user->PendingMulti.size())
-                      {
-                           user->MultiRunning = false;
-                           Dispatcher::JustAPI(user, BRLD_MULTI_STOP);
-                           continue;
-                      }
-
-	       	      PendingCMD m_event = user->PendingMulti.front();
-	       	      Kernel->Commander->Execute(user, m_event.command, m_event.cmd_params);
-	              user->PendingMulti.pop_front();
-	              flag = true;
-	              continue;
-	        }
                
   	        user->PendingList.pop_front();
+  	        user->OpenSlot(false);
                 Kernel->Commander->Execute(user, event.command, event.cmd_params);
-                flag = true;
+                user->CloseSlot();
+                executed = true;
+                budget--;
         }
         
-        return flag;
+        return executed;
+}
+
+void CommandQueue::Transaction(LocalUser* user)
+{
+       user->Multi = false;
+       user->MultiRunning = true;
+
+       user->OpenSlot(false);
+       Dispatcher::JustAPI(user, BRLD_MULTI_START);
+       user->CloseSlot();
+       
+       std::shared_ptr<transaction_query> transaction = std::make_shared<transaction_query>();
+       transaction->user = user;
+       transaction->watched.swap(user->Watched);
+       
+       /* Queries pushed by these commands are collected, instead of being queued. */
+       
+       user->Transaction = transaction;
+       
+       while (user->PendingMulti.size())
+       {
+               PendingCMD event = user->PendingMulti.front();
+               user->PendingMulti.pop_front();
+               
+               user->OpenSlot(false);
+               Kernel->Commander->Execute(user, event.command, event.cmd_params);
+               user->CloseSlot();
+       }
+       
+       user->Transaction.reset();
+       user->MultiRunning = false;
+       
+       user->OpenSlot(false);
+       
+       if (transaction->queries.empty())
+       {
+               if (transaction->Changed())
+               {
+                       user->SendProtocol(ERR_INPUT2, ERR_MULTI, WATCH_CONFLICT);
+               }
+               else
+               {
+                       Dispatcher::JustAPI(user, BRLD_MULTI_STOP);
+               }
+       }
+       else
+       {
+               Kernel->Store->Push(transaction);
+       }
+       
+       user->CloseSlot();
+}
+
+unsigned int CommandQueue::Pipeline(LocalUser* user, unsigned int budget)
+{
+       unsigned int executed = 0;
+       
+       while (executed < budget && user->PendingList.size())
+       {
+               PendingCMD event = user->PendingList.front();
+               Command* handler = Kernel->Commander->GetBase(event.command);
+               
+               if (!handler || !handler->pipeline_ok || !user->CanRun(true))
+               {
+                       break;
+               }
+               
+               user->PendingList.pop_front();
+               user->OpenSlot(true);
+               Kernel->Commander->Execute(user, event.command, event.cmd_params);
+               user->CloseSlot();
+               executed++;
+       }
+       
+       return executed;
 }
@@ -46,6 +46,8 @@ Command::Command(Module* mod, const std::string& cmd, unsigned int minpara, unsi
 	, check_value(false)
 	, offset(-1)
 	, limit(-1)
+	, run_cursor(false)
+	, paged(false)
 	, check_login(-1)
 	, check_hash(-1)
 	, check_key(-1)
@@ -56,6 +58,7 @@ Command::Command(Module* mod, const std::string& cmd, unsigned int minpara, unsi
         , syntax(NO_SYNTAX)
 	, pre_reg_ok(false)
 	, no_hint_until_reg(false)
+	, pipeline_ok(false)
 {
 
 }
@@ -148,6 +148,8 @@ void Configuration::CrossCheckConnectBlocks()
 				new ConfigConnect(tag, type, mask);
 
 			me->name = name;
+			me->pipeline = me->config->as_uint("pipeline", 16, 1, 1024);
+			me->recvq = me->config->as_uint("recvq", 8388608, INPUT_LIMIT);
 
 			std::string ports = tag->as_string("port");
 
@@ -229,6 +231,9 @@ void Configuration::Fill()
         
 	
 	MaxClients = settings->as_uint("maxclients", 1500);
+	CommandBurst = settings->as_uint("burst", 32, 1, 10000);
+	FlushUsec = settings->as_uint("flushusec", 2000, 100, 1000000);
+	IOThreads = settings->as_uint("iothreads", 0, 0, CORE_COUNT);
 	
 	Network = server->as_string("network", "Network", 1);
 	ModifiedVersion = settings->as_string("customversion");
@@ -287,6 +292,9 @@ void Configuration::CheckDatabases()
         DB.yieldusec = databases->as_uint("yield_usec", 20, 0, 100000, true);        
         DB.createim = databases->as_bool("createim", true);        
         DB.pipeline = databases->as_bool("pipeline", true);        
+        DB.sync = databases->as_bool("sync", false);
+        DB.commitusec = databases->as_uint("commit_usec", 0, 0, 100000, true);
+        DB.commitops = databases->as_uint("commit_ops", 64, 1, 10000, true);
 }
 
 void Configuration::SetAll()
@@ -132,14 +132,15 @@ COMMAND_RESULT CommandGeoGet::Handle(User* user, const Params& parameters)
 CommandGFind::CommandGFind(Module* Creator) : Command(Creator, "GKEYS", 1, 3)
 {
         run_conf	=	true;
+        run_cursor	=	true;
         check_key       =       0;
         group 		= 	'g';
-        syntax 		= 	"<\%name> <offset> <limit>";
+        syntax 		= 	"<\%name> <offset|@cursor> <limit>";
 }
 
 COMMAND_RESULT CommandGFind::Handle(User* user, const Params& parameters)
 {  
-       KeyHelper::RetroLimits(user, std::make_shared<gkeys_query>(), parameters[0], this->offset, this->limit);
+       KeyHelper::RetroPage(user, std::make_shared<gkeys_query>(), parameters[0], this);
        return SUCCESS;
 }
 
@@ -99,6 +99,7 @@ CommandExists::CommandExists(Module* Creator) : Command(Creator, "EXISTS", 1, 1)
 {
         check_key       =       0;
         group  		= 	'h';
+        pipeline_ok = 	true;
         syntax 		= 	"<key>";
 }
 
@@ -137,6 +138,7 @@ CommandType::CommandType(Module* Creator) : Command(Creator, "TYPE", 1, 1)
 {
         check_key       =       0;
         group 		= 	'h';
+        pipeline_ok = 	true;
 }
 
 COMMAND_RESULT CommandType::Handle(User* user, const Params& parameters)
@@ -17,26 +17,28 @@
 CommandKeys::CommandKeys(Module* Creator) : Command(Creator, "KEYS", 1, 3)
 {
        run_conf		=	true; 
+       run_cursor	=	true;
        group  		= 	'k';
-       syntax 		= 	"<\%key> <offset> <limit>";
+       syntax 		= 	"<\%key> <offset|@cursor> <limit>";
 }
 
 COMMAND_RESULT CommandKeys::Handle(User* user, const Params& parameters)
 {  
-       KeyHelper::RetroLimits(user, std::make_shared<keys_query>(), parameters[0], this->offset, this->limit, true);
+       KeyHelper::RetroPage(user, std::make_shared<keys_query>(), parameters[0], this, true);
        return SUCCESS;
 }
 
 CommandSearch::CommandSearch(Module* Creator) : Command(Creator, "SEARCH", 1, 3)
 {
          run_conf	=	true;
+         run_cursor	=	true;
          group  	= 	'k';
-         syntax 	= 	"<\%key> <offset> <limit>";
+         syntax 	= 	"<\%key> <offset|@cursor> <limit>";
 }
 
 COMMAND_RESULT CommandSearch::Handle(User* user, const Params& parameters)
 {  
-       KeyHelper::RetroLimits(user, std::make_shared<search_query>(), parameters[0], this->offset, this->limit, true);
+       KeyHelper::RetroPage(user, std::make_shared<search_query>(), parameters[0], this, true);
        return SUCCESS;
 }
 
@@ -63,6 +63,28 @@ COMMAND_RESULT CommandSetNX::Handle(User* user, const Params& parameters)
        return SUCCESS;
 }
 
+CommandCAS::CommandCAS(Module* Creator) : Command(Creator, "CAS", 3, 3)
+{
+       check_value      =       true;
+       check_key	= 	0;
+       group  		= 	'k';
+       syntax 		= 	"<key> \"expected\" \"value\"";
+}
+
+COMMAND_RESULT CommandCAS::Handle(User* user, const Params& parameters)
+{  
+       if (!CheckFormat(user, parameters[1]))
+       {
+              return FAILED;
+       }
+
+       std::shared_ptr<cas_query> query = std::make_shared<cas_query>();
+       query->hesh = stripe(parameters[1]);
+       
+       KeyHelper::Simple(user, query, parameters[0], parameters.back());
+       return SUCCESS;
+}
+
 CommandSetTX::CommandSetTX(Module* Creator) : Command(Creator, "SETTX", 2, 2)
 {
        check_value      =       true;
@@ -148,6 +170,7 @@ CommandGet::CommandGet(Module* Creator) : Command(Creator, "GET", 1, 1)
 {
        check_key        = 	0;
        group 		= 	'k';
+       pipeline_ok = 	true;
        syntax 		= 	"<key>";
 }
 
@@ -157,10 +180,35 @@ COMMAND_RESULT CommandGet::Handle(User* user, const Params& parameters)
        return SUCCESS;
 }
 
+CommandGets::CommandGets(Module* Creator) : Command(Creator, "GETS", 1)
+{
+       group 		= 	'k';
+       pipeline_ok = 	true;
+       syntax 		= 	"<key> ...";
+}
+
+COMMAND_RESULT CommandGets::Handle(User* user, const Params& parameters)
+{  
+       for (Params::const_iterator i = parameters.begin(); i != parameters.end(); ++i)
+       {
+              if (!Kernel->Engine->ValidKey(*i))
+              {
+                     user->SendProtocol(ERR_INPUT, INVALID_KEY);
+                     return FAILED;
+              }
+       }
+
+       std::shared_ptr<gets_query> query = std::make_shared<gets_query>();
+       query->VecData.assign(parameters.begin(), parameters.end());
+       KeyHelper::Quick(user, query);
+       return SUCCESS;
+}
+
 CommandStrlen::CommandStrlen(Module* Creator) : Command(Creator, "STRLEN", 1, 1)
 {
        check_key        = 	0;
        group  		= 	'k';
+       pipeline_ok = 	true;
        syntax 		= 	"<key>";
 }
 
@@ -220,6 +268,7 @@ CommandIsAlpha::CommandIsAlpha(Module* Creator) : Command(Creator, "ISALPHA", 1,
 {
          check_key      =       0;
          group  	= 	'k';
+         pipeline_ok = 	true;
          syntax 	= 	"<key>";
 }
 
@@ -233,6 +282,7 @@ CommandIsNum::CommandIsNum(Module* Creator) : Command(Creator, "ISNUM", 1, 1)
 {
          check_key      =       0;
          group 		= 	'k';
+         pipeline_ok = 	true;
          syntax 	= 	"<key>";
 }
 
@@ -278,6 +328,7 @@ CommandIsBool::CommandIsBool(Module* Creator) : Command(Creator, "ISBOOL", 1, 1)
 {
          check_key	=	0;
          group 		= 	'k';
+         pipeline_ok = 	true;
          syntax 	= 	"<key>";
 }
 
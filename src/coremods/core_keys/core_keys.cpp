@@ -20,6 +20,7 @@ class CoreModKeys : public Module
     
         CommandSet 		cmdset;
         CommandGet 		cmdget;
+        CommandGets 		cmdgets;
         CommandStrlen 		cmdstrlen;
         CommandKeys 		cmdkeys;
         CommandCount 		cmdcount;
@@ -29,6 +30,7 @@ class CoreModKeys : public Module
         CommandRKey 		cmdrkey;
         CommandAppend 		cmdappend;
         CommandSetNX 		cmdsetnx;
+        CommandCAS 		cmdcas;
         CommandSetTX 		cmdsettx;
         CommandSearch 		cmdsearch;
         CommandWDel 		cmdwdel;
@@ -50,6 +52,7 @@ class CoreModKeys : public Module
         
         CoreModKeys() : cmdset(this), 
                         cmdget(this),	
+                        cmdgets(this),
                         cmdstrlen(this),
                         cmdkeys(this),
                         cmdcount(this),
@@ -59,6 +62,7 @@ class CoreModKeys : public Module
                         cmdrkey(this),
                         cmdappend(this),
                         cmdsetnx(this),
+                        cmdcas(this),
                         cmdsettx(this),
                         cmdsearch(this),
                         cmdwdel(this),
@@ -259,6 +259,29 @@ class CommandSetNX : public Command
         COMMAND_RESULT Handle(User* user, const Params& parameters);
 };
 
+/* 
+ * Compare and set: sets a key only if it still holds an expected value.
+ * 
+ * @parameters:
+ *
+ *         · string   : Key to set.
+ *         · string   : Value key is expected to have.
+ *         · string   : New value.
+ * 
+ * @protocol:
+ *
+ *         · int      : 1 if key was set, 0 if value did not match.
+ */
+
+class CommandCAS : public Command 
+{
+    public: 
+
+        CommandCAS(Module* Creator);
+
+        COMMAND_RESULT Handle(User* user, const Params& parameters);
+};
+
 /* 
  * Gets a key.
  * 
@@ -281,6 +304,27 @@ class CommandGet : public Command
         COMMAND_RESULT Handle(User* user, const Params& parameters);
 };
 
+/* 
+ * Gets many keys, as separated by spaces, in a single lookup.
+ * 
+ * @parameters:
+ *
+ *         · string   : Keys to retrieve.
+ * 
+ * @protocol:
+ *
+ *         · list     : Keys and their values, NULL if not defined.
+ */
+
+class CommandGets : public Command 
+{
+    public: 
+
+        CommandGets(Module* Creator);
+
+        COMMAND_RESULT Handle(User* user, const Params& parameters);
+};
+
 /* 
  * Verifies whether an string has repeated strings.
  * 
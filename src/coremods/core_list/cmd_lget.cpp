@@ -51,13 +51,14 @@ COMMAND_RESULT CommandLGet::Handle(User* user, const Params& parameters)
 CommandLKeys::CommandLKeys(Module* Creator) : Command(Creator, "LKEYS", 1, 3)
 {
        run_conf		=	true;
+       run_cursor	=	true;
        group 		= 	'l';
-       syntax 		= 	"<%key> <offset> <limit>";
+       syntax 		= 	"<%key> <offset|@cursor> <limit>";
 }
 
 COMMAND_RESULT CommandLKeys::Handle(User* user, const Params& parameters)
 {  
-       KeyHelper::RetroLimits(user, std::make_shared<lkeys_query>(), parameters[0], this->offset, this->limit, true);
+       KeyHelper::RetroPage(user, std::make_shared<lkeys_query>(), parameters[0], this, true);
        return SUCCESS;  
 }
 
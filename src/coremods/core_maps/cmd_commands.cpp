@@ -19,6 +19,7 @@ CommandHGet::CommandHGet(Module* Creator) : Command(Creator, "HGET", 2, 2)
        check_key        =       0;
        check_hash       =       1;
        group 		= 	'm';
+       pipeline_ok = 	true;
        syntax 		= 	"<map> <key>";
 }
 
@@ -49,6 +50,7 @@ CommandHExists::CommandHExists(Module* Creator) : Command(Creator, "HEXISTS", 2,
        check_key        =       0;
        check_hash	=	1;
        group 		= 	'm';
+       pipeline_ok = 	true;
        syntax 		= 	"<map> <key>";
 }
 
@@ -63,6 +65,7 @@ CommandHStrlen::CommandHStrlen(Module* Creator) : Command(Creator, "HSTRLEN", 2,
        check_key        =       0;
        check_hash       =       1;
        group 		= 	'm';
+       pipeline_ok = 	true;
        syntax 		= 	"<map> <key>";
 }
 
@@ -89,14 +92,15 @@ COMMAND_RESULT CommandHVals::Handle(User* user, const Params& parameters)
 CommandHGetAll::CommandHGetAll(Module* Creator) : Command(Creator, "HGETALL", 1, 3)
 {
        run_conf		=	true;
+       run_cursor	=	true;
        check_key	=	0;
        group 		= 	'm';
-       syntax 		= 	"<map> <offset> <limit>";
+       syntax 		= 	"<map> <offset|@cursor> <limit>";
 }
 
 COMMAND_RESULT CommandHGetAll::Handle(User* user, const Params& parameters)
 {  
-       KeyHelper::RetroLimits(user, std::make_shared<hgetall_query>(), parameters[0], this->offset, this->limit);
+       KeyHelper::RetroPage(user, std::make_shared<hgetall_query>(), parameters[0], this);
        return SUCCESS;
 }
 
@@ -77,13 +77,14 @@ COMMAND_RESULT CommandMPushNX::Handle(User* user, const Params& parameters)
 CommandMKeys::CommandMKeys(Module* Creator) : Command(Creator, "MKEYS", 1, 3)
 {
         run_conf	=	true;
+        run_cursor	=	true;
         group  		= 	'x';
-        syntax 		= 	"<map> <limit> <offset>";
+        syntax 		= 	"<map> <offset|@cursor> <limit>";
 }
 
 COMMAND_RESULT CommandMKeys::Handle(User* user, const Params& parameters)
 {  
-       KeyHelper::RetroLimits(user, std::make_shared<mkeys_query>(), parameters[0], this->offset, this->limit, true);
+       KeyHelper::RetroPage(user, std::make_shared<mkeys_query>(), parameters[0], this, true);
        return SUCCESS;
 }
 
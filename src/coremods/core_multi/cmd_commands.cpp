@@ -12,6 +12,7 @@
  */
 
 #include "beryl.h"
+#include "brldb/keylocks.h"
 #include "core_multi.h"
 
 CommandMulti::CommandMulti(Module* Creator) : Command(Creator, "MULTI", 0, 0)
@@ -61,3 +62,58 @@ COMMAND_RESULT CommandMRUN::Handle(User* user, const Params& parameters)
 {  
       return SUCCESS;
 }
+
+CommandWatch::CommandWatch(Module* Creator) : Command(Creator, "WATCH", 1)
+{
+      group = 'w';
+      syntax = "<key> ...";
+}
+
+COMMAND_RESULT CommandWatch::Handle(User* user, const Params& parameters)
+{  
+      LocalUser* const localuser = IS_LOCAL(user);
+
+      if (!localuser || user->Multi || user->MultiRunning)
+      {
+            user->SendProtocol(ERR_INPUT, PROCESS_ERROR);
+            return FAILED;
+      }
+      
+      for (Params::const_iterator i = parameters.begin(); i != parameters.end(); ++i)
+      {
+            if (!Kernel->Engine->ValidKey(*i))
+            {
+                  user->SendProtocol(ERR_INPUT, INVALID_KEY);
+                  return FAILED;
+            }
+      }
+
+      /* Keys keep the version they had when first watched. */
+
+      for (Params::const_iterator i = parameters.begin(); i != parameters.end(); ++i)
+      {
+            const size_t stripe = KeyLocks::Stripe(user->GetDatabase(), user->select, *i);
+            localuser->Watched.insert(std::make_pair(stripe, KeyLocks::Version(stripe)));
+      }
+      
+      user->SendProtocol(BRLD_OK, PROCESS_OK);
+      return SUCCESS;
+}
+
+CommandUnwatch::CommandUnwatch(Module* Creator) : Command(Creator, "UNWATCH", 0, 0)
+{
+      group = 'w';
+}
+
+COMMAND_RESULT CommandUnwatch::Handle(User* user, const Params& parameters)
+{  
+      LocalUser* const localuser = IS_LOCAL(user);
+
+      if (localuser)
+      {
+            localuser->Watched.clear();
+      }
+      
+      user->SendProtocol(BRLD_OK, PROCESS_OK);
+      return SUCCESS;
+}
@@ -21,12 +21,16 @@ class CoreModuleMulti : public Module
         CommandMulti 		cmdmulti;
         CommandMRUN 		cmdmrun;
         CommandMultiReset 	cmdmultireset;
+        CommandWatch 		cmdwatch;
+        CommandUnwatch 		cmdunwatch;
         
     public:     
         
         CoreModuleMulti() : cmdmulti(this), 
                             cmdmrun(this), 
-                            cmdmultireset(this)
+                            cmdmultireset(this),
+                            cmdwatch(this),
+                            cmdunwatch(this)
         {
 
         }
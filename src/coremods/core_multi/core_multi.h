@@ -70,3 +70,43 @@ class CommandMultiReset : public Command
         COMMAND_RESULT Handle(User* user, const Params& parameters);
 };
 
+/* 
+ * Watches keys. MRUN fails with WATCH_CONFLICT, without running any
+ * command, if a watched key is written after this command.
+ * 
+ * @parameters:
+ *
+ *         · string   : Keys to watch.
+ * 
+ * @protocol:
+ *
+ *         · protocol        : OK or ERROR.
+ */ 
+
+class CommandWatch : public Command 
+{
+
+    public: 
+
+        CommandWatch(Module* parent);
+
+        COMMAND_RESULT Handle(User* user, const Params& parameters);
+};
+
+/* 
+ * Forgets keys watched by WATCH.
+ * 
+ * @protocol:
+ *
+ *         · protocol        : OK.
+ */ 
+
+class CommandUnwatch : public Command 
+{
+
+    public: 
+
+        CommandUnwatch(Module* parent);
+
+        COMMAND_RESULT Handle(User* user, const Params& parameters);
+};
@@ -13,6 +13,143 @@
 
 #include "beryl.h"
 
+/* 
+ * Length prefixed framing. A frame is a 4 byte, big endian length followed
+ * by its items, each one being a 4 byte length followed by its bytes.
+ * Requests carry the command and its parameters; replies carry source
+ * (may be empty), command and parameters. Items are taken as they are,
+ * so values may hold any byte, including spaces, newlines and NULs.
+ */
+
+class BinarySerializer : public ProtocolTrigger::Serializer
+{
+	static const std::string::size_type LENGTH_SIZE = 4;
+
+	static void AppendItem(std::string& frame, const std::string& item);
+
+	static bool ReadLength(const std::string& data, std::string::size_type pos, uint32_t& length);
+
+ public:
+
+	BinarySerializer(Module* mod) : ProtocolTrigger::Serializer(mod, "binary")
+	{
+
+	}
+
+	ExtractResult Extract(LocalUser* user, const std::string& recvq, std::string::size_type& head, std::string::size_type& checked, std::string& message);
+	bool Parse(LocalUser* user, const std::string& line, ProtocolTrigger::ParseOutput& parseoutput);
+	ProtocolTrigger::SerializedMessage Serialize(const ProtocolTrigger::Message& msg, const ProtocolTrigger::TagSelection& tagwl) const;
+};
+
+void BinarySerializer::AppendItem(std::string& frame, const std::string& item)
+{
+	const uint32_t length = item.length();
+
+	frame.push_back(static_cast<char>(length >> 24));
+	frame.push_back(static_cast<char>(length >> 16));
+	frame.push_back(static_cast<char>(length >> 8));
+	frame.push_back(static_cast<char>(length));
+	frame.append(item);
+}
+
+bool BinarySerializer::ReadLength(const std::string& data, std::string::size_type pos, uint32_t& length)
+{
+	if (data.length() < pos + LENGTH_SIZE)
+	{
+		return false;
+	}
+
+	const unsigned char* raw = reinterpret_cast<const unsigned char*>(data.data() + pos);
+
+	length = (uint32_t(raw[0]) << 24) | (uint32_t(raw[1]) << 16) | (uint32_t(raw[2]) << 8) | uint32_t(raw[3]);
+	return true;
+}
+
+ProtocolTrigger::Serializer::ExtractResult BinarySerializer::Extract(LocalUser* user, const std::string& recvq, std::string::size_type& head, std::string::size_type& checked, std::string& message)
+{
+	uint32_t length;
+
+	if (!ReadLength(recvq, head, length))
+	{
+		checked = recvq.length();
+		return EXTRACT_MORE;
+	}
+
+	/* Frames that could never fit in the recvq are not waited for. */
+
+	if (length > user->GetRecvQMax())
+	{
+		return EXTRACT_TOO_LONG;
+	}
+
+	/* Frame not fully received yet. */
+
+	if (recvq.length() - head - LENGTH_SIZE < length)
+	{
+		checked = recvq.length();
+		return EXTRACT_MORE;
+	}
+
+	message.assign(recvq, head + LENGTH_SIZE, length);
+	head += LENGTH_SIZE + length;
+	checked = head;
+	return EXTRACT_DONE;
+}
+
+bool BinarySerializer::Parse(LocalUser* user, const std::string& line, ProtocolTrigger::ParseOutput& parseoutput)
+{
+	std::string::size_type pos = 0;
+	uint32_t length;
+
+	while (pos < line.length())
+	{
+		if (!ReadLength(line, pos, length) || line.length() - pos - LENGTH_SIZE < length)
+		{
+			user->SendProtocol(ERR_INPUT, MALFORMED_FRAME);
+			return false;
+		}
+
+		pos += LENGTH_SIZE;
+
+		if (parseoutput.cmd.empty())
+		{
+			parseoutput.cmd.assign(line, pos, length);
+		}
+		else
+		{
+			parseoutput.params.push_back(line.substr(pos, length));
+		}
+
+		pos += length;
+	}
+
+	return !parseoutput.cmd.empty();
+}
+
+ProtocolTrigger::SerializedMessage BinarySerializer::Serialize(const ProtocolTrigger::Message& msg, const ProtocolTrigger::TagSelection& tagwl) const
+{
+	std::string frame(LENGTH_SIZE, '\0');
+
+	AppendItem(frame, msg.GetSource() ? *msg.GetSource() : std::string());
+	AppendItem(frame, msg.GetCommand());
+
+	const ProtocolTrigger::Message::ParamList& params = msg.GetParams();
+
+	for (ProtocolTrigger::Message::ParamList::const_iterator i = params.begin(); i != params.end(); ++i)
+	{
+		AppendItem(frame, *i);
+	}
+
+	const uint32_t length = frame.length() - LENGTH_SIZE;
+
+	frame[0] = static_cast<char>(length >> 24);
+	frame[1] = static_cast<char>(length >> 16);
+	frame[2] = static_cast<char>(length >> 8);
+	frame[3] = static_cast<char>(length);
+
+	return frame;
+}
+
 class Serializer : public ProtocolTrigger::Serializer
 {
 
@@ -22,17 +159,38 @@ class Serializer : public ProtocolTrigger::Serializer
 
 	static void SerializeTags(const ProtocolTrigger::TagMap& tags, const ProtocolTrigger::TagSelection& tagwl, std::string& line);
 
+	/* Serializer taking over clients that open with a binary frame. */
+
+	BinarySerializer* binary;
+
  public:
 
-	Serializer(Module* mod) : ProtocolTrigger::Serializer(mod, "brld")
+	Serializer(Module* mod, BinarySerializer* bin) : ProtocolTrigger::Serializer(mod, "brld"), binary(bin)
 	{
 		
 	}
 
+	ExtractResult Extract(LocalUser* user, const std::string& recvq, std::string::size_type& head, std::string::size_type& checked, std::string& message);
  	bool Parse(LocalUser* user, const std::string& line, ProtocolTrigger::ParseOutput& parseoutput) ;
 	ProtocolTrigger::SerializedMessage Serialize(const ProtocolTrigger::Message& msg, const ProtocolTrigger::TagSelection& tagwl) const ;
 };
 
+ProtocolTrigger::Serializer::ExtractResult Serializer::Extract(LocalUser* user, const std::string& recvq, std::string::size_type& head, std::string::size_type& checked, std::string& message)
+{
+	/* 
+	 * Frame lengths start with a NUL byte, which no text client sends first.
+	 * Protocol can only be switched before logging in.
+	 */
+
+	if (user->registered == REG_NONE && checked <= head && head < recvq.length() && recvq[head] == '\0')
+	{
+		user->serializer = this->binary;
+		return this->binary->Extract(user, recvq, head, checked, message);
+	}
+
+	return ProtocolTrigger::Serializer::Extract(user, recvq, head, checked, message);
+}
+
 bool Serializer::Parse(LocalUser* user, const std::string& line, ProtocolTrigger::ParseOutput& parseoutput)
 {
 	size_t start = line.find_first_not_of(" ");
@@ -212,11 +370,13 @@ class ModuleCoreSerializer : public Module
 {
   private:
   
+	BinarySerializer binary;
+
 	Serializer serializer;
 
  public:
  
-	ModuleCoreSerializer() : serializer(this)
+	ModuleCoreSerializer() : binary(this), serializer(this, &binary)
 	{
 	
 	}
@@ -230,7 +390,7 @@ class ModuleCoreSerializer : public Module
 
 		LocalUser* const user = IS_LOCAL(static_cast<User*>(item));
 	
-		if ((user) && (user->serializer == &serializer))
+		if ((user) && (user->serializer == &serializer || user->serializer == &binary))
 		{
 			Kernel->Clients->Disconnect(user, "Protocol serializer module unloading");
 		}
@@ -246,7 +406,7 @@ class ModuleCoreSerializer : public Module
 
 	Version GetDescription() 
 	{
-		return Version("Provides a Serializer to the client.", VF_CORE|VF_BERYLDB);
+		return Version("Provides text and binary serializers to the client.", VF_CORE|VF_BERYLDB);
 	}
 };
 
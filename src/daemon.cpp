@@ -794,3 +794,27 @@ void Dispatcher::MMapFlush(bool comillas, const std::string& title, const std::s
         }
 }
 
+void Dispatcher::PairFlush(const std::string& title, const std::string& subtitle, const DualVector& pairs, QueryBase* query)
+{
+        Dispatcher::JustAPI(query->user, BRLD_START_LIST);
+
+        if (pairs.empty())
+        {
+                Dispatcher::JustAPI(query->user, BRLD_END_LIST);
+                Dispatcher::JustEmerald(query->user, BRLD_OK, PROCESS_EMPTY);
+                return;
+        }
+
+        Dispatcher::JustEmerald(query->user, BRLD_START_LIST, Daemon::Format("+%-16s+%-29s+", Dispatcher::Repeat("-", 17).c_str(), Dispatcher::Repeat("-", 30).c_str()));
+        Dispatcher::JustEmerald(query->user, BRLD_START_LIST, Daemon::Format("| %-16s| %-29s|", title.c_str(), subtitle.c_str()));
+        Dispatcher::JustEmerald(query->user, BRLD_START_LIST, Daemon::Format("+%-16s+%-29s+", Dispatcher::Repeat("-", 17).c_str(), Dispatcher::Repeat("-", 30).c_str()));
+
+        for (DualVector::const_iterator i = pairs.begin(); i != pairs.end(); ++i)
+        {
+                Dispatcher::ListDepend(query->user, BRLD_ITEM_LIST, Daemon::Format("| %-16s| %-29s|", i->first.c_str(), i->second.c_str()), Daemon::Format("%s %s", i->first.c_str(), i->second.c_str()));
+        }
+
+        Dispatcher::JustAPI(query->user, BRLD_END_LIST);
+        Dispatcher::JustEmerald(query->user, BRLD_END_LIST, Daemon::Format("+%-16s+%-29s+", Dispatcher::Repeat("-", 17).c_str(), Dispatcher::Repeat("-", 30).c_str()));
+}
+
@@ -33,6 +33,7 @@ void SocketPool::Start()
 		InitError();
 	}
 	
+	InitWaker();
 }
 
 void SocketPool::SafeInit()
@@ -139,9 +140,11 @@ void SocketPool::DeleteDescriptor(EventHandler* ehandler)
 	SocketPool::DeleteFileDescRef(ehandler);
 }
 
-int SocketPool::Events()
+int SocketPool::Events(int timeout)
 {
-	int i = epoll_wait(SocketHandler, &events[0], events.size(), 10);
+	/* Trials left by the previous loop must be run without waiting. */
+
+	int i = epoll_wait(SocketHandler, &events[0], events.size(), trials.empty() ? timeout : 0);
         Kernel->Now();
 	
 	for (int j = 0; j < i; j++)
@@ -44,6 +44,7 @@ void SocketPool::Start()
 {
 	get_max_fdesc();
 	SafeInit();
+	InitWaker();
 }
 
 void SocketPool::SafeInit()
@@ -133,11 +134,18 @@ void SocketPool::OnMaskReq(EventHandler* ehandler, int old_mask, int new_mask)
 	}
 }
 
-int SocketPool::Events()
+int SocketPool::Events(int timeout)
 {
+	/* Trials left by the previous loop must be run without waiting. */
+
+	if (!trials.empty())
+	{
+		timeout = 0;
+	}
+
 	struct timespec ts;
-	ts.tv_nsec = 30000000;
-	ts.tv_sec = 0;
+	ts.tv_sec = timeout / 1000;
+	ts.tv_nsec = (timeout % 1000) * 1000000;
 
 	int i = kevent(SocketHandler, &pendinglist.front(), ChangePos, &ke_list.front(), ke_list.size(), &ts);
 	ChangePos = 0;
@@ -0,0 +1,515 @@
+/*
+ * BerylDB - A lightweight database.
+ * http://www.beryldb.com
+ *
+ * Copyright (C) 2021 - Carlos F. Ferry <cferry@beryldb.com>
+ *
+ * This file is part of BerylDB. BerylDB is free software: you can
+ * redistribute it and/or modify it under the terms of the BSD License
+ * version 3.
+ *
+ * More information about our licensing can be found at https://docs.beryl.dev
+ */
+
+#include <linux/io_uring.h>
+#include <sys/mman.h>
+#include <sys/syscall.h>
+#include <sys/resource.h>
+#include <poll.h>
+
+#include "beryl.h"
+
+/*
+ * io_uring engine. Descriptors are watched with poll requests: edge
+ * triggered masks use multishot polls, level triggered ones a single shot
+ * poll that is armed again once handled. Mask changes only queue entries,
+ * which are submitted together with the next wait, so a loop costs a single
+ * io_uring_enter() instead of an epoll_ctl() per change.
+ *
+ * Experimental, only built with ./configure --engine uring. Sockets still
+ * read and write on their own, so it does not use multishot accept/recv or
+ * registered buffers: it ties with epoll at 10-100 connections and is slower
+ * on a single one. epoll remains the default.
+ */
+
+namespace
+{
+	/* Submission entries. Completions get four times as many. */
+
+	const unsigned int RING_ENTRIES = 4096;
+
+	/* user_data of requests whose completions are not looked at. */
+
+	const uint64_t IGNORED = 0;
+
+	/* Poll watching a descriptor. */
+
+	struct PollState
+	{
+		/*
+		 * Bumped every time the poll is replaced, completions of older polls
+		 * are dropped. Never 0, so user_data is never IGNORED.
+		 */
+
+		uint32_t generation;
+
+		/* Whether a poll is pending in the kernel. */
+
+		bool armed;
+
+		PollState() : generation(0), armed(false)
+		{
+
+		}
+	};
+
+	struct Ring
+	{
+		unsigned* sq_head;
+		unsigned* sq_tail;
+		unsigned* sq_mask;
+		unsigned* sq_array;
+		unsigned sq_entries;
+		struct io_uring_sqe* sqes;
+
+		unsigned* cq_head;
+		unsigned* cq_tail;
+		unsigned* cq_mask;
+		struct io_uring_cqe* cqes;
+
+		void* sq_map;
+		size_t sq_size;
+		void* cq_map;
+		size_t cq_size;
+		size_t sqes_size;
+	};
+
+	int SocketHandler = -1;
+
+	Ring ring;
+
+	std::vector<PollState> polls(16);
+}
+
+static int Enter(unsigned int submit, unsigned int wait, unsigned int flags, void* arg, size_t argsize)
+{
+	return syscall(__NR_io_uring_enter, SocketHandler, submit, wait, flags, arg, argsize);
+}
+
+static unsigned int Queued()
+{
+	return *ring.sq_tail - __atomic_load_n(ring.sq_head, __ATOMIC_ACQUIRE);
+}
+
+/* Submits queued entries, without waiting for completions. */
+
+static void Submit()
+{
+	while (Queued() && Enter(Queued(), 0, 0, NULL, 0) < 0 && errno == EINTR)
+	{
+
+	}
+}
+
+static void Queue(uint8_t opcode, int fd, uint64_t addr, unsigned int events, unsigned int len, uint64_t data)
+{
+	if (Queued() >= ring.sq_entries)
+	{
+		Submit();
+	}
+
+	const unsigned int tail = *ring.sq_tail;
+	const unsigned int index = tail & *ring.sq_mask;
+
+	struct io_uring_sqe* sqe = &ring.sqes[index];
+	memset(sqe, 0, sizeof(*sqe));
+
+	sqe->opcode = opcode;
+	sqe->fd = fd;
+	sqe->addr = addr;
+	sqe->len = len;
+	sqe->user_data = data;
+
+#if __BYTE_ORDER == __BIG_ENDIAN
+	events = (events << 16) | (events >> 16);
+#endif
+
+	sqe->poll32_events = events;
+
+	ring.sq_array[index] = index;
+	__atomic_store_n(ring.sq_tail, tail + 1, __ATOMIC_RELEASE);
+}
+
+static PollState& GetState(int fd)
+{
+	if (static_cast<size_t>(fd) >= polls.size())
+	{
+		polls.resize(fd * 2 + 1);
+	}
+
+	return polls[fd];
+}
+
+static uint64_t ToData(int fd, uint32_t generation)
+{
+	return (static_cast<uint64_t>(generation) << 32) | static_cast<uint32_t>(fd);
+}
+
+static unsigned SetMask(int req_mask, bool& edge)
+{
+	unsigned rv = 0;
+
+	edge = false;
+
+	if (req_mask & (Q_REQ_POOL_READ | Q_REQ_POLL_WRITE | Q_SINGLE_WRITE))
+	{
+		if (req_mask & (Q_REQ_POOL_READ | Q_FAST_READ))
+		{
+			rv |= POLLIN;
+		}
+
+		if (req_mask & (Q_REQ_POLL_WRITE | Q_FAST_WRITE | Q_SINGLE_WRITE))
+		{
+			rv |= POLLOUT;
+		}
+	}
+	else
+	{
+		edge = true;
+
+		if (req_mask & (Q_FAST_READ | Q_EDGE_READ))
+		{
+			rv |= POLLIN;
+		}
+
+		if (req_mask & (Q_FAST_WRITE | Q_EDGE_WRITE))
+		{
+			rv |= POLLOUT;
+		}
+	}
+
+	return rv;
+}
+
+static void Arm(int fd, int req_mask)
+{
+	bool edge;
+	const unsigned events = SetMask(req_mask, edge);
+
+	PollState& state = GetState(fd);
+
+	if (++state.generation == 0)
+	{
+		state.generation = 1;
+	}
+
+	state.armed = true;
+	Queue(IORING_OP_POLL_ADD, fd, 0, events, (edge ? IORING_POLL_ADD_MULTI : 0), ToData(fd, state.generation));
+}
+
+static void Disarm(int fd)
+{
+	PollState& state = GetState(fd);
+
+	if (state.armed)
+	{
+		Queue(IORING_OP_POLL_REMOVE, -1, ToData(fd, state.generation), 0, 0, IGNORED);
+	}
+
+	if (++state.generation == 0)
+	{
+		state.generation = 1;
+	}
+
+	state.armed = false;
+}
+
+void SocketPool::Start()
+{
+	get_max_fdesc();
+
+	struct io_uring_params params;
+	memset(&params, 0, sizeof(params));
+	params.flags = IORING_SETUP_CQSIZE;
+	params.cq_entries = RING_ENTRIES * 4;
+
+	SocketHandler = syscall(__NR_io_uring_setup, RING_ENTRIES, &params);
+
+	if (SocketHandler == -1)
+	{
+		InitError();
+	}
+
+	if (!(params.features & IORING_FEAT_NODROP) || !(params.features & IORING_FEAT_EXT_ARG))
+	{
+		errno = ENOSYS;
+		InitError();
+	}
+
+	ring.sq_size = params.sq_off.array + params.sq_entries * sizeof(unsigned);
+	ring.cq_size = params.cq_off.cqes + params.cq_entries * sizeof(struct io_uring_cqe);
+
+	if (params.features & IORING_FEAT_SINGLE_MMAP)
+	{
+		ring.sq_size = ring.cq_size = std::max(ring.sq_size, ring.cq_size);
+	}
+
+	ring.sq_map = mmap(NULL, ring.sq_size, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, SocketHandler, IORING_OFF_SQ_RING);
+
+	if (ring.sq_map == MAP_FAILED)
+	{
+		InitError();
+	}
+
+	ring.cq_map = ring.sq_map;
+
+	if (!(params.features & IORING_FEAT_SINGLE_MMAP))
+	{
+		ring.cq_map = mmap(NULL, ring.cq_size, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, SocketHandler, IORING_OFF_CQ_RING);
+
+		if (ring.cq_map == MAP_FAILED)
+		{
+			InitError();
+		}
+	}
+
+	ring.sqes_size = params.sq_entries * sizeof(struct io_uring_sqe);
+	ring.sqes = static_cast<struct io_uring_sqe*>(mmap(NULL, ring.sqes_size, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, SocketHandler, IORING_OFF_SQES));
+
+	if (ring.sqes == MAP_FAILED)
+	{
+		InitError();
+	}
+
+	char* const sq = static_cast<char*>(ring.sq_map);
+	char* const cq = static_cast<char*>(ring.cq_map);
+
+	ring.sq_head = reinterpret_cast<unsigned*>(sq + params.sq_off.head);
+	ring.sq_tail = reinterpret_cast<unsigned*>(sq + params.sq_off.tail);
+	ring.sq_mask = reinterpret_cast<unsigned*>(sq + params.sq_off.ring_mask);
+	ring.sq_array = reinterpret_cast<unsigned*>(sq + params.sq_off.array);
+	ring.sq_entries = params.sq_entries;
+
+	ring.cq_head = reinterpret_cast<unsigned*>(cq + params.cq_off.head);
+	ring.cq_tail = reinterpret_cast<unsigned*>(cq + params.cq_off.tail);
+	ring.cq_mask = reinterpret_cast<unsigned*>(cq + params.cq_off.ring_mask);
+	ring.cqes = reinterpret_cast<struct io_uring_cqe*>(cq + params.cq_off.cqes);
+
+	InitWaker();
+}
+
+void SocketPool::SafeInit()
+{
+
+}
+
+void SocketPool::CloseAll()
+{
+	munmap(ring.sqes, ring.sqes_size);
+
+	if (ring.cq_map != ring.sq_map)
+	{
+		munmap(ring.cq_map, ring.cq_size);
+	}
+
+	munmap(ring.sq_map, ring.sq_size);
+	Close(SocketHandler);
+}
+
+bool SocketPool::AddDescriptor(EventHandler* ehandler, int req_mask)
+{
+	int fd = ehandler->GetDescriptor();
+
+	if (fd < 0)
+	{
+		return false;
+	}
+
+	if (!SocketPool::AttachFileDescRef(ehandler))
+	{
+		return false;
+	}
+
+	Arm(fd, req_mask);
+	ehandler->SetReqMask(req_mask);
+
+	return true;
+}
+
+void SocketPool::OnMaskReq(EventHandler* ehandler, int old_mask, int new_mask)
+{
+	bool previous_edge, new_edge;
+
+	unsigned PreviousEvents = SetMask(old_mask, previous_edge);
+	unsigned NewEvents = SetMask(new_mask, new_edge);
+
+	if (PreviousEvents != NewEvents || previous_edge != new_edge)
+	{
+		const int fd = ehandler->GetDescriptor();
+
+		Disarm(fd);
+		Arm(fd, new_mask);
+	}
+}
+
+void SocketPool::DeleteDescriptor(EventHandler* ehandler)
+{
+	int fd = ehandler->GetDescriptor();
+
+	if (fd < 0)
+	{
+		return;
+	}
+
+	/* Removal is submitted with the next wait, before the kernel drops its reference to the socket. */
+
+	Disarm(fd);
+	SocketPool::DeleteFileDescRef(ehandler);
+}
+
+int SocketPool::Events(int timeout)
+{
+	struct __kernel_timespec ts;
+	ts.tv_sec = timeout / 1000;
+	ts.tv_nsec = (timeout % 1000) * 1000000L;
+
+	struct io_uring_getevents_arg arg;
+	memset(&arg, 0, sizeof(arg));
+	arg.ts = reinterpret_cast<uint64_t>(&ts);
+
+	/* Trials left by the previous loop must be run without waiting. */
+
+	const bool ready = (*ring.cq_head != __atomic_load_n(ring.cq_tail, __ATOMIC_ACQUIRE));
+
+	if (trials.empty() && !ready)
+	{
+		Enter(Queued(), 1, IORING_ENTER_GETEVENTS | IORING_ENTER_EXT_ARG, &arg, sizeof(arg));
+	}
+	else
+	{
+		Submit();
+	}
+
+        Kernel->Now();
+
+	unsigned head = *ring.cq_head;
+	const unsigned tail = __atomic_load_n(ring.cq_tail, __ATOMIC_ACQUIRE);
+
+	/* Single shot polls (and multishot ones the kernel ended) handled by this loop. */
+
+	std::vector<std::pair<int, uint32_t>> ended;
+
+	int i = 0;
+
+	for (; head != tail; ++head)
+	{
+		const struct io_uring_cqe cqe = ring.cqes[head & *ring.cq_mask];
+		__atomic_store_n(ring.cq_head, head + 1, __ATOMIC_RELEASE);
+
+		if (cqe.user_data == IGNORED)
+		{
+			continue;
+		}
+
+		const int fd = static_cast<int>(cqe.user_data & 0xFFFFFFFF);
+		const uint32_t generation = static_cast<uint32_t>(cqe.user_data >> 32);
+
+		if (GetState(fd).generation != generation)
+		{
+			continue;
+		}
+
+		if (!(cqe.flags & IORING_CQE_F_MORE))
+		{
+			GetState(fd).armed = false;
+			ended.push_back(std::make_pair(fd, generation));
+		}
+
+		EventHandler* const ehandler = GetReference(fd);
+
+		if (!ehandler)
+		{
+			continue;
+		}
+
+		i++;
+
+		if (cqe.res < 0)
+		{
+			ehandler->OnManageError(-cqe.res);
+			continue;
+		}
+
+		const unsigned revents = cqe.res;
+
+		if (revents & POLLHUP)
+		{
+			ehandler->OnManageError(0);
+			continue;
+		}
+
+		if (revents & POLLERR)
+		{
+			socklen_t codesize = sizeof(int);
+			int errcode;
+
+			if (getsockopt(fd, SOL_SOCKET, SO_ERROR, &errcode, &codesize) < 0)
+			{
+				errcode = errno;
+			}
+
+			ehandler->OnManageError(errcode);
+			continue;
+		}
+
+		int mask = ehandler->GetEventMask();
+
+		if (revents & POLLIN)
+		{
+			mask &= ~Q_READ_WILL_BLOCK;
+		}
+
+		if (revents & POLLOUT)
+		{
+			mask &= ~Q_WRITE_BLOCK;
+
+			if (mask & Q_SINGLE_WRITE)
+			{
+				int nm = mask & ~Q_SINGLE_WRITE;
+				OnMaskReq(ehandler, mask, nm);
+				mask = nm;
+			}
+		}
+
+		ehandler->SetReqMask(mask);
+
+		if (revents & POLLIN)
+		{
+			ehandler->OnPendingRead();
+
+			if (ehandler != GetReference(fd))
+			{
+				continue;
+			}
+		}
+
+		if (revents & POLLOUT)
+		{
+			ehandler->OnPendingWrites();
+		}
+	}
+
+	/* Polls replaced or removed meanwhile have a new generation. */
+
+	for (std::vector<std::pair<int, uint32_t>>::const_iterator j = ended.begin(); j != ended.end(); ++j)
+	{
+		EventHandler* const ehandler = GetReference(j->first);
+
+		if (ehandler && GetState(j->first).generation == j->second && !GetState(j->first).armed)
+		{
+			Arm(j->first, ehandler->GetEventMask());
+		}
+	}
+
+	return i;
+}
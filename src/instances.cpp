@@ -24,6 +24,7 @@ User::User(const std::string& uid, Server* srv, UserType type) :
                                         	, connected(0)
                                         	, logged(0)
                                         	, Locked(false)	 
+                                        	, InFlight(0)
                                         	, Multi(false)
                                         	, MultiRunning(false)
                                         	, Paused(false)
@@ -59,6 +60,9 @@ User::User(const std::string& uid, Server* srv, UserType type) :
 
 LocalUser::LocalUser(int myfd, engine::sockets::sockaddrs* client, engine::sockets::sockaddrs* servaddr)
 	: User(Kernel->UID->GetUID(), Kernel->Clients->Global->server, CLIENT_TYPE_LOCAL)
+	, FirstSlot(1)
+	, Writing(NO_SLOT)
+	, Pipelining(false)
 	, usercon(this)
 	, serializer(NULL)
 	, lastping(true)
@@ -77,7 +81,7 @@ LocalUser::LocalUser(int myfd, engine::sockets::sockaddrs* client, engine::socke
 	SetHost(GetReadableIP(), true);
 }
 
-LocalUser::LocalUser(int myfd, const std::string& uid, Serializable::Data& data) : User(uid, Kernel->Clients->Global->server, CLIENT_TYPE_LOCAL), usercon(this), already_sent(0)
+LocalUser::LocalUser(int myfd, const std::string& uid, Serializable::Data& data) : User(uid, Kernel->Clients->Global->server, CLIENT_TYPE_LOCAL), FirstSlot(1), Writing(NO_SLOT), Pipelining(false), usercon(this), already_sent(0)
 {
 	usercon.SetFileDesc(myfd);
 	Deserialize(data);
@@ -93,7 +97,6 @@ User::~User()
         Kernel->Notify->Remove(this);
         
 	pending.clear();
-	notifications.clear();
 	Groups.clear();
 	instance.clear();
 	
@@ -149,6 +152,11 @@ bool User::IsLocked()
         return this->Locked;
 }
 
+bool User::IsBusy()
+{
+        return (this->Locked || this->InFlight);
+}
+
 const std::string& User::GetHostFormat()
 {
 	if (!this->cached_user_real_host.empty())
@@ -312,41 +320,27 @@ void InstanceStream::StreamData()
 
 	std::string line;
 
-	std::string::size_type ipos;
-
-	std::string::size_type queueindex;
+	/* 
+	 * Messages are read in place, moving head forward. Handed out data is
+	 * dropped once all messages are read, instead of after every message,
+	 * so pipelined commands are not moved around for each one of them.
+	 */
 
 	while (GetQueueSize() < ULONG_MAX)
 	{
-		ipos = recvq.find('\n', checked_until);
+		const ProtocolTrigger::Serializer::ExtractResult extracted = user->serializer->Extract(user, recvq, head, checked_until, line);
 
-		if (ipos == std::string::npos)
+		if (extracted == ProtocolTrigger::Serializer::EXTRACT_TOO_LONG)
 		{
-			checked_until = recvq.length();
+			Kernel->Clients->Disconnect(user, "RecvQ exceeded");
 			return;
 		}
 
-		line.reserve(ipos);
-
-		for (queueindex = 0; queueindex < ipos; ++queueindex)
+		if (extracted != ProtocolTrigger::Serializer::EXTRACT_DONE)
 		{
-			char c = recvq[queueindex];
-
-			switch (c)
-			{
-				case '\0':
-					c = ' ';
-					break;
-				case '\r':
-					continue;
-			}
-
-			line.push_back(c);
+			break;
 		}
 
-		recvq.erase(0, ipos + 1);
-		checked_until = 0;
-
 		Kernel->Commander.ProcessBuffer(user, line);
 
 		if (user->IsQuitting())
@@ -356,11 +350,26 @@ void InstanceStream::StreamData()
 
 		line.clear();
 	}
+
+	if (head)
+	{
+		recvq.erase(0, head);
+		checked_until -= head;
+		head = 0;
+	}
+
+	/* Incomplete messages are not buffered past the limit of this class. */
+
+	if (recvq.length() > user->GetRecvQMax())
+	{
+		Kernel->Clients->Disconnect(user, "RecvQ exceeded");
+	}
 }
 
 void InstanceStream::swap_internal(InstanceStream& other)
 {
 	StreamSocket::swap_internal(other);
+	std::swap(head, other.head);
 	std::swap(checked_until, other.checked_until);
 }
 
@@ -611,16 +620,128 @@ void LocalUser::set_client_ip(const engine::sockets::sockaddrs& sa)
 	}
 }
 
-void LocalUser::Write(const ProtocolTrigger::SerializedMessage& text)
+void LocalUser::Write(const ProtocolTrigger::SharedMessage& text)
 {
 	if (!SocketPool::BoundsCheckFd(&usercon))
 	{
 		return;
 	}
 
+	/* Earlier commands are still running, output waits for them. */
+	
+	if (this->Writing > this->FirstSlot)
+	{
+		this->Slots[this->Writing - this->FirstSlot].buffer.push_back(text);
+		return;
+	}
+
 	usercon.AppendBuffer(text);
 }
 
+void LocalUser::OpenSlot(bool pipelined)
+{
+	this->Slots.push_back(ReplySlot());
+	this->Writing = this->FirstSlot + this->Slots.size() - 1;
+	this->Pipelining = pipelined;
+}
+
+void LocalUser::CloseSlot()
+{
+	if (this->Writing == NO_SLOT)
+	{
+		return;
+	}
+	
+	this->Slots[this->Writing - this->FirstSlot].executed = true;
+	this->Writing = NO_SLOT;
+	this->Pipelining = false;
+	this->ReleaseSlots();
+}
+
+uint64_t LocalUser::HoldSlot()
+{
+	if (this->Writing == NO_SLOT)
+	{
+		return NO_SLOT;
+	}
+	
+	this->Slots[this->Writing - this->FirstSlot].running++;
+	return this->Writing;
+}
+
+uint64_t LocalUser::EnterSlot(uint64_t id)
+{
+	const uint64_t previous = this->Writing;
+	
+	if (id < this->FirstSlot || id >= this->FirstSlot + this->Slots.size())
+	{
+		this->Writing = NO_SLOT;
+		return previous;
+	}
+	
+	this->Writing = id;
+	return previous;
+}
+
+void LocalUser::LeaveSlot(uint64_t previous)
+{
+	this->Writing = previous;
+}
+
+void LocalUser::FinishSlot(uint64_t id)
+{
+	if (id < this->FirstSlot || id >= this->FirstSlot + this->Slots.size())
+	{
+		return;
+	}
+	
+	ReplySlot& slot = this->Slots[id - this->FirstSlot];
+	
+	if (slot.running)
+	{
+		slot.running--;
+	}
+	
+	this->ReleaseSlots();
+}
+
+void LocalUser::ReleaseSlots()
+{
+	while (!this->Slots.empty() && this->Slots.front().executed && !this->Slots.front().running)
+	{
+		this->Slots.pop_front();
+		this->FirstSlot++;
+		
+		/* Next slot is now in order, so it can be sent. */
+		
+		if (!this->Slots.empty() && !this->Slots.front().buffer.empty())
+		{
+			if (SocketPool::BoundsCheckFd(&usercon))
+			{
+				usercon.AppendBuffer(this->Slots.front().buffer);
+			}
+			
+			this->Slots.front().buffer.clear();
+		}
+	}
+}
+
+bool LocalUser::CanRun(bool pipelined)
+{
+	if (this->IsLocked())
+	{
+		return false;
+	}
+	
+	if (!pipelined)
+	{
+		return (!this->InFlight && this->pending.empty());
+	}
+	
+	const unsigned int depth = (this->GetClass() ? this->GetClass()->pipeline : 1);
+	return (this->InFlight + this->pending.size() < depth);
+}
+
 void LocalUser::Send(ProtocolTrigger::Event& protoev)
 {
 	if (!serializer)
@@ -905,6 +1026,8 @@ ConfigConnect::ConfigConnect(config_rule* tag, char t, const std::string& mask)
 			, type(t)
 			, name("undefined")
 			, host(mask)
+			, pipeline(1)
+			, recvq(8388608)
 {
 
 }
@@ -946,4 +1069,6 @@ void ConfigConnect::Update(const ConfigConnect* src)
 	name   = src->name;
 	host   = src->host;
 	ports  = src->ports;
+	pipeline = src->pipeline;
+	recvq = src->recvq;
 }
@@ -104,15 +104,14 @@ void GlobalHelper::Exists(User* user, const std::string& entry)
        Kernel->Store->Push(query);
 }
 
-void GlobalHelper::ExpireDelete(std::shared_ptr<Database> database, unsigned int  where, const std::string& key)
+void GlobalHelper::ExpireBatch(std::shared_ptr<Database> database, std::vector<std::pair<unsigned int, std::string>>& due)
 {
-       std::shared_ptr<del_query> query = std::make_shared<del_query>();
+       std::shared_ptr<expire_batch_query> query = std::make_shared<expire_batch_query>();
 
        query->user = Kernel->Clients->Global;
        query->database = database;
-       query->select_query = where;
        query->flags = QUERY_FLAGS_QUIET;
-       query->key = key;
+       query->due.swap(due);
        
        Kernel->Store->Push(query);
 }
@@ -97,6 +97,13 @@ void KeyHelper::RetroLimits(User* user, std::shared_ptr<QueryBase> query, const
        Kernel->Store->Push(query);
 }
 
+void KeyHelper::RetroPage(User* user, std::shared_ptr<QueryBase> query, const std::string& entry, Command* handler, bool allow)
+{
+       query->paged = handler->paged;
+       query->cursor = handler->cursor;
+       KeyHelper::RetroLimits(user, query, entry, handler->offset, handler->limit, allow);
+}
+
 void KeyHelper::SimpleRetro(User* user, std::shared_ptr<QueryBase> query, const std::string& entry, const std::string& value)
 {
        Helpers::make_query(user, query, entry);
@@ -62,7 +62,40 @@ ProtocolTrigger::TagSelection ProtocolTrigger::Serializer::MakeTagWhitelist(Loca
 	return tagwl;
 }
 
-const ProtocolTrigger::SerializedMessage& ProtocolTrigger::Serializer::SerializeForUser(LocalUser* user, Message& msg)
+ProtocolTrigger::Serializer::ExtractResult ProtocolTrigger::Serializer::Extract(LocalUser* user, const std::string& recvq, std::string::size_type& head, std::string::size_type& checked, std::string& message)
+{
+	const std::string::size_type ipos = recvq.find('\n', std::max(head, checked));
+
+	if (ipos == std::string::npos)
+	{
+		checked = recvq.length();
+		return EXTRACT_MORE;
+	}
+
+	message.reserve(ipos - head);
+
+	for (std::string::size_type queueindex = head; queueindex < ipos; ++queueindex)
+	{
+		char c = recvq[queueindex];
+
+		switch (c)
+		{
+			case '\0':
+				c = ' ';
+				break;
+			case '\r':
+				continue;
+		}
+
+		message.push_back(c);
+	}
+
+	head = ipos + 1;
+	checked = head;
+	return EXTRACT_DONE;
+}
+
+const ProtocolTrigger::SharedMessage& ProtocolTrigger::Serializer::SerializeForUser(LocalUser* user, Message& msg)
 {
 	if (!msg.msginit_done)
 	{
@@ -73,7 +106,7 @@ const ProtocolTrigger::SerializedMessage& ProtocolTrigger::Serializer::Serialize
 	return msg.GetSerialized(Message::SerializedData(this, MakeTagWhitelist(user, msg.GetTags())));
 }
 
-const ProtocolTrigger::SerializedMessage& ProtocolTrigger::Message::GetSerialized(const SerializedData& serializeinfo) const
+const ProtocolTrigger::SharedMessage& ProtocolTrigger::Message::GetSerialized(const SerializedData& serializeinfo) const
 {
 	for (SerializedList::const_iterator i = serlist.begin(); i != serlist.end(); ++i)
 	{
@@ -85,7 +118,7 @@ const ProtocolTrigger::SerializedMessage& ProtocolTrigger::Message::GetSerialize
 		}
 	}
 
-	serlist.push_back(std::make_pair(serializeinfo, serializeinfo.serializer->Serialize(*this, serializeinfo.tagwl)));
+	serlist.push_back(std::make_pair(serializeinfo, std::make_shared<const SerializedMessage>(serializeinfo.serializer->Serialize(*this, serializeinfo.tagwl))));
 	return serlist.back().second;
 }
 
@@ -0,0 +1,781 @@
+/*
+ * BerylDB - A lightweight database.
+ * http://www.beryldb.com
+ *
+ * Copyright (C) 2021 - Carlos F. Ferry <cferry@beryldb.com>
+ *
+ * This file is part of BerylDB. BerylDB is free software: you can
+ * redistribute it and/or modify it under the terms of the BSD License
+ * version 3.
+ *
+ * More information about our licensing can be found at https://docs.beryl.dev
+ */
+
+#include <thread>
+#include <unordered_map>
+
+#ifdef __linux__
+#include <sys/epoll.h>
+#include <sys/eventfd.h>
+#endif
+
+#include "beryl.h"
+#include "reactors.h"
+
+/* Input a socket may hold before reads stop, until the mainloop takes it. */
+
+const size_t REACTOR_INPUT_MAX = 1024 * 1024;
+
+/* Events handled in a single pass. */
+
+const int REACTOR_EVENTS = 128;
+
+static const int reactor_iov_max = iov_max < 128 ? iov_max : 128;
+
+/* Requests sent from the mainloop to a reactor. */
+
+enum ReactorOp
+{
+	REACTOR_ATTACH,
+	REACTOR_WRITE,
+	REACTOR_RESUME,
+	REACTOR_DETACH,
+	REACTOR_STOP
+};
+
+typedef std::pair<ReactorOp, std::shared_ptr<ReactorLink>> ReactorRequest;
+
+class Reactor
+{
+ private:
+
+	int pollfd;
+
+	int wakefd;
+
+	std::thread handler;
+
+	/* Requests not processed yet. */
+
+	std::mutex mute;
+
+	std::vector<ReactorRequest> requests;
+
+	/* Sockets owned by this reactor, by descriptor. Reactor only. */
+
+	std::unordered_map<int, std::shared_ptr<ReactorLink>> links;
+
+	std::vector<char> buffer;
+
+	void Run();
+
+	/* Runs queued requests, returns false once asked to stop. */
+
+	bool Requests();
+
+	void Read(const std::shared_ptr<ReactorLink>& link);
+
+	void Write(const std::shared_ptr<ReactorLink>& link);
+
+	/* Updates poll set after a change of state. */
+
+	void Arm(const std::shared_ptr<ReactorLink>& link);
+
+	/* Lets the mainloop know about new input or errors. */
+
+	void Notify(const std::shared_ptr<ReactorLink>& link);
+
+ public:
+
+	Reactor();
+
+	~Reactor();
+
+	bool Create();
+
+	void Post(ReactorOp op, const std::shared_ptr<ReactorLink>& link);
+
+	void Join();
+};
+
+namespace
+{
+	std::vector<std::unique_ptr<Reactor>> reactors;
+
+	/* Next reactor to get a socket. */
+
+	size_t next_reactor = 0;
+
+	/* Sockets with output queued by the mainloop. */
+
+	std::vector<std::shared_ptr<ReactorLink>> dirty;
+
+	/* Sockets with data or errors for the mainloop. */
+
+	std::mutex incoming_mute;
+
+	std::vector<std::shared_ptr<ReactorLink>> incoming;
+}
+
+#ifdef __linux__
+
+Reactor::Reactor() : pollfd(-1), wakefd(-1), buffer(BUFFERSIZE)
+{
+
+}
+
+Reactor::~Reactor()
+{
+	for (std::unordered_map<int, std::shared_ptr<ReactorLink>>::iterator i = this->links.begin(); i != this->links.end(); ++i)
+	{
+		SocketPool::Close(i->first);
+	}
+
+	if (this->wakefd >= 0)
+	{
+		SocketPool::Close(this->wakefd);
+	}
+
+	if (this->pollfd >= 0)
+	{
+		SocketPool::Close(this->pollfd);
+	}
+}
+
+bool Reactor::Create()
+{
+	this->pollfd = epoll_create1(EPOLL_CLOEXEC);
+	this->wakefd = eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+
+	if (this->pollfd < 0 || this->wakefd < 0)
+	{
+		return false;
+	}
+
+	struct epoll_event ev;
+	memset(&ev, 0, sizeof(ev));
+	ev.events = EPOLLIN;
+	ev.data.fd = this->wakefd;
+
+	if (epoll_ctl(this->pollfd, EPOLL_CTL_ADD, this->wakefd, &ev) < 0)
+	{
+		return false;
+	}
+
+	this->handler = std::thread(&Reactor::Run, this);
+	return true;
+}
+
+void Reactor::Join()
+{
+	if (!this->handler.joinable())
+	{
+		return;
+	}
+
+	this->Post(REACTOR_STOP, std::shared_ptr<ReactorLink>());
+	this->handler.join();
+}
+
+void Reactor::Post(ReactorOp op, const std::shared_ptr<ReactorLink>& link)
+{
+	bool wake;
+
+	{
+		std::lock_guard<std::mutex> lock(this->mute);
+		wake = this->requests.empty();
+		this->requests.push_back(std::make_pair(op, link));
+	}
+
+	/* Reactor drains all requests on wake up, a single write will do. */
+
+	if (wake)
+	{
+		const uint64_t one = 1;
+
+		if (write(this->wakefd, &one, sizeof(one)) < 0)
+		{
+			slog("SOCKET", LOG_DEBUG, "Unable to wake reactor: %s", strerror(errno));
+		}
+	}
+}
+
+void Reactor::Run()
+{
+	/* Signals are handled by the mainloop. */
+
+	sigset_t all;
+	sigfillset(&all);
+	pthread_sigmask(SIG_BLOCK, &all, NULL);
+
+	struct epoll_event events[REACTOR_EVENTS];
+
+	while (true)
+	{
+		const int count = epoll_wait(this->pollfd, events, REACTOR_EVENTS, -1);
+
+		for (int i = 0; i < count; i++)
+		{
+			if (events[i].data.fd == this->wakefd)
+			{
+				uint64_t drain;
+
+				while (read(this->wakefd, &drain, sizeof(drain)) > 0)
+				{
+				}
+
+				if (!this->Requests())
+				{
+					return;
+				}
+
+				continue;
+			}
+
+			/* Socket may have been detached earlier in this pass. */
+
+			std::unordered_map<int, std::shared_ptr<ReactorLink>>::iterator found = this->links.find(events[i].data.fd);
+
+			if (found == this->links.end())
+			{
+				continue;
+			}
+
+			const std::shared_ptr<ReactorLink> link = found->second;
+
+			if (events[i].events & EPOLLOUT)
+			{
+				{
+					std::lock_guard<std::mutex> lock(link->mute);
+					link->blocked = false;
+				}
+
+				this->Write(link);
+			}
+
+			if (events[i].events & (EPOLLIN | EPOLLRDHUP | EPOLLHUP | EPOLLERR))
+			{
+				this->Read(link);
+			}
+		}
+	}
+}
+
+bool Reactor::Requests()
+{
+	std::vector<ReactorRequest> pending;
+
+	{
+		std::lock_guard<std::mutex> lock(this->mute);
+		pending.swap(this->requests);
+	}
+
+	for (std::vector<ReactorRequest>::const_iterator i = pending.begin(); i != pending.end(); ++i)
+	{
+		const std::shared_ptr<ReactorLink>& link = i->second;
+
+		switch (i->first)
+		{
+			case REACTOR_ATTACH:
+			{
+				this->links[link->fd] = link;
+				this->Arm(link);
+				this->Write(link);
+			}
+
+			break;
+
+			case REACTOR_WRITE:
+			{
+				this->Write(link);
+			}
+
+			break;
+
+			case REACTOR_RESUME:
+			{
+				if (link->dead)
+				{
+					break;
+				}
+
+				{
+					std::lock_guard<std::mutex> lock(link->mute);
+					link->paused = false;
+				}
+
+				this->Arm(link);
+				this->Write(link);
+			}
+
+			break;
+
+			case REACTOR_DETACH:
+			{
+				/* Last chance to write output, ie: an error before quitting. */
+
+				{
+					std::lock_guard<std::mutex> lock(link->mute);
+					link->blocked = false;
+				}
+
+				this->Write(link);
+
+				if (link->events)
+				{
+					struct epoll_event ev;
+					epoll_ctl(this->pollfd, EPOLL_CTL_DEL, link->fd, &ev);
+				}
+
+				shutdown(link->fd, SHUT_RDWR);
+				SocketPool::Close(link->fd);
+				this->links.erase(link->fd);
+			}
+
+			break;
+
+			case REACTOR_STOP:
+			{
+				return false;
+			}
+		}
+	}
+
+	return true;
+}
+
+void Reactor::Arm(const std::shared_ptr<ReactorLink>& link)
+{
+	uint32_t mask = 0;
+
+	if (!link->dead)
+	{
+		mask = (link->paused ? 0u : static_cast<uint32_t>(EPOLLIN | EPOLLRDHUP)) | (link->blocked ? static_cast<uint32_t>(EPOLLOUT) : 0u);
+	}
+
+	if (mask == link->events)
+	{
+		return;
+	}
+
+	/* Polling is level triggered, so idle sockets are left out entirely. */
+
+	struct epoll_event ev;
+	memset(&ev, 0, sizeof(ev));
+	ev.events = mask;
+	ev.data.fd = link->fd;
+
+	if (!mask)
+	{
+		epoll_ctl(this->pollfd, EPOLL_CTL_DEL, link->fd, &ev);
+		link->events = 0;
+		return;
+	}
+
+	if (epoll_ctl(this->pollfd, link->events ? EPOLL_CTL_MOD : EPOLL_CTL_ADD, link->fd, &ev) < 0)
+	{
+		const int errnum = errno;
+		bool notify;
+
+		{
+			std::lock_guard<std::mutex> lock(link->mute);
+			link->dead = true;
+			link->error = errnum;
+			notify = !link->incoming;
+			link->incoming = true;
+		}
+
+		if (link->events)
+		{
+			epoll_ctl(this->pollfd, EPOLL_CTL_DEL, link->fd, &ev);
+			link->events = 0;
+		}
+
+		if (notify)
+		{
+			this->Notify(link);
+		}
+
+		return;
+	}
+
+	link->events = mask;
+}
+
+void Reactor::Read(const std::shared_ptr<ReactorLink>& link)
+{
+	if (link->dead || link->paused)
+	{
+		return;
+	}
+
+	const int n = recv(link->fd, &this->buffer[0], this->buffer.size(), 0);
+
+	if (n < 0 && (errno == EAGAIN || errno == EWOULDBLOCK || errno == EINTR))
+	{
+		return;
+	}
+
+	const int errnum = errno;
+	bool notify;
+
+	{
+		std::lock_guard<std::mutex> lock(link->mute);
+
+		if (n > 0)
+		{
+			link->input.append(&this->buffer[0], n);
+			link->paused = (link->input.size() >= REACTOR_INPUT_MAX);
+		}
+		else
+		{
+			link->dead = true;
+			link->error = (n == 0 ? 0 : errnum);
+		}
+
+		notify = !link->incoming;
+		link->incoming = true;
+	}
+
+	this->Arm(link);
+
+	if (notify)
+	{
+		this->Notify(link);
+	}
+}
+
+void Reactor::Write(const std::shared_ptr<ReactorLink>& link)
+{
+	if (link->dead || link->blocked)
+	{
+		return;
+	}
+
+	bool notify = false;
+
+	{
+		std::lock_guard<std::mutex> lock(link->mute);
+
+		StreamSocket::send_queue& sq = link->output;
+
+		while (!sq.empty())
+		{
+			int bufcount = sq.size();
+
+			if (bufcount > reactor_iov_max)
+			{
+				bufcount = reactor_iov_max;
+			}
+
+			SocketPool::IOVector iovecs[reactor_iov_max];
+			size_t rv_max = 0;
+			int j = 0;
+
+			for (StreamSocket::send_queue::const_iterator i = sq.begin(), end = i + bufcount; i != end; ++i, j++)
+			{
+				iovecs[j].iov_base = const_cast<char*>(i->data());
+				iovecs[j].iov_len = i->length();
+				rv_max += iovecs[j].iov_len;
+			}
+
+			int rv = writev(link->fd, iovecs, bufcount);
+
+			if (rv < 0)
+			{
+				if (errno == EINTR)
+				{
+					continue;
+				}
+
+				if (errno == EAGAIN || errno == EWOULDBLOCK)
+				{
+					link->blocked = true;
+				}
+				else
+				{
+					link->dead = true;
+					link->error = errno;
+					notify = !link->incoming;
+					link->incoming = true;
+				}
+
+				break;
+			}
+
+			if ((size_t)rv < rv_max)
+			{
+				link->blocked = true;
+			}
+
+			while (rv > 0 && !sq.empty())
+			{
+				const StreamSocket::send_queue::Element& front = sq.front();
+
+				if (front.length() <= (size_t)rv)
+				{
+					rv -= front.length();
+					sq.pop_front();
+				}
+				else
+				{
+					sq.erase_front(rv);
+					rv = 0;
+				}
+			}
+
+			if (link->blocked)
+			{
+				break;
+			}
+		}
+	}
+
+	/* Either waits for the socket, or stops waiting once all is written. */
+
+	this->Arm(link);
+
+	if (notify)
+	{
+		this->Notify(link);
+	}
+}
+
+void Reactor::Notify(const std::shared_ptr<ReactorLink>& link)
+{
+	{
+		std::lock_guard<std::mutex> lock(incoming_mute);
+		incoming.push_back(link);
+	}
+
+	SocketPool::Wake();
+}
+
+void Reactors::Start(unsigned int count)
+{
+	for (unsigned int i = 0; i < count; i++)
+	{
+		std::unique_ptr<Reactor> reactor(new Reactor());
+
+		if (!reactor->Create())
+		{
+			slog("SOCKET", LOG_DEFAULT, "Unable to start I/O thread: %s", strerror(errno));
+			break;
+		}
+
+		reactors.push_back(std::move(reactor));
+	}
+
+	if (!reactors.empty())
+	{
+		slog("SOCKET", LOG_DEFAULT, "Started %lu I/O threads.", (unsigned long)reactors.size());
+	}
+}
+
+#else
+
+Reactor::Reactor() : pollfd(-1), wakefd(-1)
+{
+
+}
+
+Reactor::~Reactor()
+{
+
+}
+
+bool Reactor::Create()
+{
+	return false;
+}
+
+void Reactor::Post(ReactorOp op, const std::shared_ptr<ReactorLink>& link)
+{
+
+}
+
+void Reactor::Join()
+{
+
+}
+
+void Reactors::Start(unsigned int count)
+{
+	if (count)
+	{
+		slog("SOCKET", LOG_DEFAULT, "I/O threads are not supported on this system, using mainloop only.");
+	}
+}
+
+#endif
+
+void Reactors::Stop()
+{
+	for (std::vector<std::unique_ptr<Reactor>>::iterator i = reactors.begin(); i != reactors.end(); ++i)
+	{
+		(*i)->Join();
+	}
+
+	reactors.clear();
+	dirty.clear();
+
+	std::lock_guard<std::mutex> lock(incoming_mute);
+	incoming.clear();
+}
+
+bool Reactors::Attach(StreamSocket* sock)
+{
+	if (reactors.empty() || !sock->HasFileDesc())
+	{
+		return false;
+	}
+
+	Reactor* const reactor = reactors[next_reactor++ % reactors.size()].get();
+
+	/* Descriptor stays open, it is just not polled by the mainloop anymore. */
+
+	SocketPool::DeleteDescriptor(sock);
+
+	sock->link = std::make_shared<ReactorLink>(reactor, sock);
+	sock->link->output.moveall(sock->Getsend_queue());
+
+	reactor->Post(REACTOR_ATTACH, sock->link);
+	return true;
+}
+
+void Reactors::Detach(StreamSocket* sock)
+{
+	std::shared_ptr<ReactorLink> link;
+	link.swap(sock->link);
+
+	link->sock = NULL;
+
+	{
+		std::lock_guard<std::mutex> lock(link->mute);
+		link->output.moveall(sock->Getsend_queue());
+	}
+
+	link->reactor->Post(REACTOR_DETACH, link);
+	sock->SetFileDesc(-1);
+}
+
+void Reactors::Queue(StreamSocket* sock)
+{
+	if (sock->link->dirty)
+	{
+		return;
+	}
+
+	sock->link->dirty = true;
+	dirty.push_back(sock->link);
+}
+
+void Reactors::Writes()
+{
+	if (dirty.empty())
+	{
+		return;
+	}
+
+	std::vector<std::shared_ptr<ReactorLink>> pending;
+	pending.swap(dirty);
+
+	for (std::vector<std::shared_ptr<ReactorLink>>::const_iterator i = pending.begin(); i != pending.end(); ++i)
+	{
+		const std::shared_ptr<ReactorLink>& link = *i;
+		link->dirty = false;
+
+		/* Closed sockets handed their output on Detach(). */
+
+		if (!link->sock)
+		{
+			continue;
+		}
+
+		{
+			std::lock_guard<std::mutex> lock(link->mute);
+			link->output.moveall(link->sock->Getsend_queue());
+		}
+
+		link->reactor->Post(REACTOR_WRITE, link);
+	}
+}
+
+void Reactors::Process()
+{
+	std::vector<std::shared_ptr<ReactorLink>> pending;
+
+	{
+		std::lock_guard<std::mutex> lock(incoming_mute);
+
+		if (incoming.empty())
+		{
+			return;
+		}
+
+		pending.swap(incoming);
+	}
+
+	std::string data;
+
+	for (std::vector<std::shared_ptr<ReactorLink>>::const_iterator i = pending.begin(); i != pending.end(); ++i)
+	{
+		const std::shared_ptr<ReactorLink>& link = *i;
+
+		bool dead;
+		bool paused;
+		int error;
+
+		{
+			std::lock_guard<std::mutex> lock(link->mute);
+			data.swap(link->input);
+			link->input.clear();
+			link->incoming = false;
+			dead = link->dead;
+			paused = link->paused;
+			error = link->error;
+		}
+
+		StreamSocket* const sock = link->sock;
+
+		if (!sock)
+		{
+			data.clear();
+			continue;
+		}
+
+		if (paused && !dead)
+		{
+			link->reactor->Post(REACTOR_RESUME, link);
+		}
+
+		if (!data.empty())
+		{
+			sock->recvq.append(data);
+			data.clear();
+
+			try
+			{
+				sock->StreamData();
+			}
+			catch (KernelException& ex)
+			{
+				sock->SetError(ex.get_reason());
+			}
+
+			/* Socket may have been closed while processing. */
+
+			if (!link->sock)
+			{
+				continue;
+			}
+
+			sock->CheckError(L_ERR_OTHER);
+		}
+
+		if (dead && link->sock)
+		{
+			sock->OnManageError(error);
+		}
+	}
+}
@@ -13,6 +13,7 @@
 
 #include "beryl.h"
 #include "queues.h"
+#include "reactors.h"
 
 static const int use_iov_max = iov_max < 128 ? iov_max : 128;
 
@@ -114,6 +115,14 @@ void StreamSocket::Close()
 	}
 
 	closing = true;
+
+	/* I/O thread writes what is left, and closes the descriptor. */
+
+	if (this->link)
+	{
+		Reactors::Detach(this);
+		return;
+	}
 	
 	if (HasFileDesc())
 	{
@@ -137,7 +146,7 @@ void StreamSocket::Close()
 
 void StreamSocket::Close(bool writeblock)
 {
-	if (GetQueueSize() != 0 && writeblock)
+	if (GetQueueSize() != 0 && writeblock && !this->link)
 	{
 		closeonempty = true;
 	}
@@ -410,6 +419,50 @@ void StreamSocket::AppendBuffer(const std::string &data)
 	}
 
 	sendq.push_back(data);
+
+	if (this->link)
+	{
+		Reactors::Queue(this);
+		return;
+	}
+
+	SocketPool::EventSwitch(this, Q_ADD_WRITE_TRIAL);
+}
+
+void StreamSocket::AppendBuffer(const std::shared_ptr<const std::string>& data)
+{
+	if (!HasFileDesc())
+	{
+		return;
+	}
+
+	sendq.push_back(data);
+
+	if (this->link)
+	{
+		Reactors::Queue(this);
+		return;
+	}
+
+	SocketPool::EventSwitch(this, Q_ADD_WRITE_TRIAL);
+}
+
+void StreamSocket::AppendBuffer(send_queue& data)
+{
+	if (!HasFileDesc())
+	{
+		data.clear();
+		return;
+	}
+
+	sendq.moveall(data);
+
+	if (this->link)
+	{
+		Reactors::Queue(this);
+		return;
+	}
+
 	SocketPool::EventSwitch(this, Q_ADD_WRITE_TRIAL);
 }
 
@@ -629,4 +682,15 @@ void StreamSocket::swap_internal(StreamSocket& other)
 	std::swap(ioattach, other.ioattach);
 	std::swap(recvq, other.recvq);
 	std::swap(sendq, other.sendq);
+	std::swap(link, other.link);
+
+	if (link)
+	{
+		link->sock = this;
+	}
+
+	if (other.link)
+	{
+		other.link->sock = &other;
+	}
 }
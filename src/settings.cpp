@@ -118,7 +118,9 @@ bool Helpers::as_bool(const std::string &key, bool def)
 
 std::string Helpers::Format(const std::string& fmt)
 {
-    return Daemon::Format("\"%s\"", fmt.c_str());
+    /* Not formatted through printf, values may hold NUL bytes. */
+
+    return "\"" + fmt + "\"";
 }
 
 void Helpers::make_query(User* user, std::shared_ptr<QueryBase> base, const std::string& key, bool allow)     
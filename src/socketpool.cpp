@@ -13,6 +13,10 @@
 
 #include <iostream>
 
+#ifdef __linux__
+#include <sys/eventfd.h>
+#endif
+
 #include "exit.h"
 #include "beryl.h"
 #include "engine.h"
@@ -25,6 +29,46 @@ std::set<int> SocketPool::trials;
 
 size_t SocketPool::set_size_limit = 0;
 
+namespace
+{
+	/* Readable end of the wake-up descriptor, registered with the pool. */
+
+	class LoopWaker : public EventHandler
+	{
+	 public:
+
+		/* Written by Wake(). Same as fd when using an eventfd. */
+
+		int writefd;
+
+		/* Set while a wake-up is pending, avoids a write per result. */
+
+		std::atomic<bool> signaled;
+
+		LoopWaker() : writefd(-1), signaled(false)
+		{
+		}
+
+		void OnPendingRead()
+		{
+			char drain[64];
+
+			while (read(this->fd, drain, sizeof(drain)) > 0)
+			{
+			}
+
+			/*
+			 * Cleared only once drained, so a Wake() from now on writes again.
+			 * Results queued before this point are collected later in this pass.
+			 */
+
+			this->signaled = false;
+		}
+	};
+
+	LoopWaker waker;
+}
+
 EventHandler::EventHandler()
 {
 	fd = -1;
@@ -56,6 +100,57 @@ void SocketPool::InitError()
 	exit(EXIT_CODE_SOCKETSTREAM);
 }
 
+void SocketPool::InitWaker()
+{
+#ifdef __linux__
+
+	waker.SetFileDesc(eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC));
+	waker.writefd = waker.GetDescriptor();
+
+#else
+
+	int fds[2];
+
+	if (pipe(fds) == 0)
+	{
+		NonBlocking(fds[0]);
+		NonBlocking(fds[1]);
+		
+		waker.SetFileDesc(fds[0]);
+		waker.writefd = fds[1];
+	}
+
+#endif
+
+	if (!waker.HasFileDesc() || !AddDescriptor(&waker, Q_REQ_POOL_READ | Q_NO_WRITE))
+	{
+		InitError();
+	}
+}
+
+void SocketPool::Wake()
+{
+	if (waker.signaled.exchange(true))
+	{
+		return;
+	}
+
+#ifdef __linux__
+
+	const uint64_t one = 1;
+
+#else
+
+	const char one = 0;
+
+#endif
+
+	if (write(waker.writefd, &one, sizeof(one)) < 0)
+	{
+		waker.signaled = false;
+	}
+}
+
 void SocketPool::get_max_fdesc()
 {
 	struct rlimit limits;
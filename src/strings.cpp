@@ -31,6 +31,32 @@ std::string bin_to_hex(const void* raw, size_t l)
 	return rv;
 }
 
+bool hex_to_bin(const std::string& hex, std::string& raw)
+{
+	if (hex.size() % 2)
+	{
+		return false;
+	}
+
+	raw.clear();
+	raw.reserve(hex.size() / 2);
+
+	for (size_t i = 0; i < hex.size(); i += 2)
+	{
+		const char* high = strchr(hex_table, tolower(hex[i]));
+		const char* low = strchr(hex_table, tolower(hex[i + 1]));
+
+		if (!hex[i] || !hex[i + 1] || !high || !low)
+		{
+			return false;
+		}
+
+		raw.push_back(static_cast<char>(((high - hex_table) << 4) | (low - hex_table)));
+	}
+
+	return true;
+}
+
 static const char base_64_table[] = "ABCDEFGHIJKLMNOPQRSTUVWXYZabcdefghijklmnopqrstuvwxyz0123456789+/";
 
 std::string bin_to_base64(const std::string& data_str, const char* table, char pad)
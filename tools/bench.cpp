@@ -0,0 +1,318 @@
+/*
+ * BerylDB - A lightweight database.
+ * http://www.beryldb.com
+ *
+ * Copyright (C) 2021 - Carlos F. Ferry <cferry@beryldb.com>
+ *
+ * This file is part of BerylDB. BerylDB is free software: you can
+ * redistribute it and/or modify it under the terms of the BSD License
+ * version 3.
+ *
+ * More information about our licensing can be found at https://docs.beryl.dev
+ */
+
+/*
+ * Small load driver, used to check how throughput scales with
+ * <dbconf threads="N">. Every client keeps one SET or INCR in flight,
+ * clients are spread over a few driver threads.
+ *
+ * Build:
+ *
+ *         c++ -O2 -std=c++14 -pthread tools/bench.cpp -o bench
+ *
+ * Usage:
+ *
+ *         bench [set|incr] [clients] [seconds] [keys] [threads] [host] [port] [auth]
+ *
+ * Defaults are set, 64 clients, 10 seconds, 100000 keys, 4 threads,
+ * 127.0.0.1, 6378 and the default auth. Keys are spread evenly, so
+ * clients rarely wait on the same key stripe.
+ */
+
+#include <sys/epoll.h>
+#include <sys/socket.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <arpa/inet.h>
+#include <unistd.h>
+#include <fcntl.h>
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <random>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace
+{
+      struct Settings
+      {
+              bool incr = false;
+              unsigned int clients = 64;
+              double seconds = 10;
+              unsigned int keys = 100000;
+              unsigned int threads = 4;
+              std::string host = "127.0.0.1";
+              unsigned int port = 6378;
+              std::string auth = "default";
+      };
+
+      struct Client
+      {
+              int fd = -1;
+              std::string input;
+      };
+
+      Settings config;
+
+      std::atomic<unsigned long> total(0);
+      std::atomic<unsigned long> failures(0);
+
+      /* Sends a whole request, these are small enough to never fill the socket. */
+
+      bool SendAll(int fd, const std::string& data)
+      {
+              size_t sent = 0;
+
+              while (sent < data.size())
+              {
+                      const ssize_t wrote = write(fd, data.data() + sent, data.size() - sent);
+
+                      if (wrote <= 0)
+                      {
+                              return false;
+                      }
+
+                      sent += wrote;
+              }
+
+              return true;
+      }
+
+      /* Reads a single line, used while logging in. */
+
+      bool ReadLine(int fd, std::string& line)
+      {
+              line.clear();
+              char ch;
+
+              while (read(fd, &ch, 1) == 1)
+              {
+                      if (ch == '\n')
+                      {
+                              return true;
+                      }
+
+                      if (ch != '\r')
+                      {
+                              line.push_back(ch);
+                      }
+              }
+
+              return false;
+      }
+
+      int Connect()
+      {
+              sockaddr_in address;
+              std::memset(&address, 0, sizeof(address));
+
+              address.sin_family = AF_INET;
+              address.sin_port = htons(config.port);
+
+              if (inet_pton(AF_INET, config.host.c_str(), &address.sin_addr) != 1)
+              {
+                      return -1;
+              }
+
+              const int fd = socket(AF_INET, SOCK_STREAM, 0);
+
+              if (fd < 0)
+              {
+                      return -1;
+              }
+
+              int one = 1;
+              setsockopt(fd, IPPROTO_TCP, TCP_NODELAY, &one, sizeof(one));
+
+              if (connect(fd, reinterpret_cast<sockaddr*>(&address), sizeof(address)) < 0)
+              {
+                      close(fd);
+                      return -1;
+              }
+
+              /* BRLD_CONNECTED (108) closes the greeting once the login went through. */
+
+              if (!SendAll(fd, "ILOGIN bench " + config.auth + " root\r\n"))
+              {
+                      close(fd);
+                      return -1;
+              }
+
+              std::string line;
+
+              while (ReadLine(fd, line))
+              {
+                      if (line.find(" 108 ") != std::string::npos)
+                      {
+                              fcntl(fd, F_SETFL, fcntl(fd, F_GETFL) | O_NONBLOCK);
+                              return fd;
+                      }
+              }
+
+              close(fd);
+              return -1;
+      }
+
+      std::string Request(std::mt19937& random)
+      {
+              const std::string& index = std::to_string(random() % config.keys);
+
+              if (config.incr)
+              {
+                      return "INCR bench_incr_" + index + "\r\n";
+              }
+
+              return "SET bench_set_" + index + " \"value\"\r\n";
+      }
+
+      /* Runs a share of the clients until the deadline. */
+
+      void Drive(std::vector<Client>& clients, std::chrono::steady_clock::time_point deadline, unsigned int seed)
+      {
+              std::mt19937 random(seed);
+
+              const int poll = epoll_create1(0);
+
+              for (size_t i = 0; i < clients.size(); i++)
+              {
+                      epoll_event event;
+                      std::memset(&event, 0, sizeof(event));
+
+                      event.events = EPOLLIN;
+                      event.data.u64 = i;
+
+                      epoll_ctl(poll, EPOLL_CTL_ADD, clients[i].fd, &event);
+                      SendAll(clients[i].fd, Request(random));
+              }
+
+              std::vector<epoll_event> events(256);
+              char buffer[16384];
+              unsigned long done = 0;
+              unsigned long failed = 0;
+
+              while (std::chrono::steady_clock::now() < deadline)
+              {
+                      const int ready = epoll_wait(poll, events.data(), events.size(), 100);
+
+                      for (int e = 0; e < ready; e++)
+                      {
+                              Client& client = clients[events[e].data.u64];
+                              ssize_t got;
+
+                              while ((got = read(client.fd, buffer, sizeof(buffer))) > 0)
+                              {
+                                      client.input.append(buffer, got);
+                              }
+
+                              size_t end;
+
+                              /* One line per reply, the next request goes out right away. */
+
+                              while ((end = client.input.find('\n')) != std::string::npos)
+                              {
+                                      if (client.input.find("ERR") < end)
+                                      {
+                                              failed++;
+                                      }
+
+                                      client.input.erase(0, end + 1);
+                                      done++;
+
+                                      SendAll(client.fd, Request(random));
+                              }
+                      }
+              }
+
+              close(poll);
+
+              total += done;
+              failures += failed;
+      }
+}
+
+int main(int argc, char** argv)
+{
+        if (argc > 1)
+        {
+              const std::string mode = argv[1];
+
+              if (mode != "set" && mode != "incr")
+              {
+                      std::fprintf(stderr, "usage: %s [set|incr] [clients] [seconds] [keys] [threads] [host] [port] [auth]\n", argv[0]);
+                      return 1;
+              }
+
+              config.incr = (mode == "incr");
+        }
+
+        if (argc > 2) config.clients = std::max(1, std::atoi(argv[2]));
+        if (argc > 3) config.seconds = std::max(1.0, std::atof(argv[3]));
+        if (argc > 4) config.keys = std::max(1, std::atoi(argv[4]));
+        if (argc > 5) config.threads = std::max(1, std::atoi(argv[5]));
+        if (argc > 6) config.host = argv[6];
+        if (argc > 7) config.port = std::atoi(argv[7]);
+        if (argc > 8) config.auth = argv[8];
+
+        config.threads = std::min(config.threads, config.clients);
+
+        std::vector<std::vector<Client>> shares(config.threads);
+
+        for (unsigned int i = 0; i < config.clients; i++)
+        {
+              Client client;
+              client.fd = Connect();
+
+              if (client.fd < 0)
+              {
+                      std::fprintf(stderr, "unable to connect and log in client %u\n", i);
+                      return 1;
+              }
+
+              shares[i % config.threads].push_back(client);
+        }
+
+        const std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+        const std::chrono::steady_clock::time_point deadline = start + std::chrono::duration_cast<std::chrono::steady_clock::duration>(std::chrono::duration<double>(config.seconds));
+
+        std::vector<std::thread> drivers;
+
+        for (unsigned int i = 0; i < config.threads; i++)
+        {
+              drivers.emplace_back(Drive, std::ref(shares[i]), deadline, i + 1);
+        }
+
+        for (std::vector<std::thread>::iterator i = drivers.begin(); i != drivers.end(); ++i)
+        {
+              i->join();
+        }
+
+        const double elapsed = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+        std::printf("%s clients %u threads %u replies %lu errors %lu ops/s %.0f\n", (config.incr ? "incr" : "set"), config.clients, config.threads, total.load(), failures.load(), total / elapsed);
+
+        for (std::vector<std::vector<Client>>::iterator share = shares.begin(); share != shares.end(); ++share)
+        {
+              for (std::vector<Client>::iterator client = share->begin(); client != share->end(); ++client)
+              {
+                      close(client->fd);
+              }
+        }
+
+        return 0;
+}